@@ -1,27 +1,19 @@
+mod helpers;
+
 use anyhow::Context;
+use helpers::{get_language, grammars_dir, EXAMPLE_FILTER, LANGUAGE_FILTER, REPETITION_COUNT};
 use lazy_static::lazy_static;
 use std::collections::BTreeMap;
 use std::path::{Path, PathBuf};
 use std::time::Instant;
-use std::{env, fs, str, usize};
-use tree_sitter::{Language, Parser, Query};
-use tree_sitter_loader::Loader;
-
-include!("../src/tests/helpers/dirs.rs");
+use std::{fs, str, usize};
+use tree_sitter::{Parser, Query};
 
 lazy_static! {
-    static ref LANGUAGE_FILTER: Option<String> =
-        env::var("TREE_SITTER_BENCHMARK_LANGUAGE_FILTER").ok();
-    static ref EXAMPLE_FILTER: Option<String> =
-        env::var("TREE_SITTER_BENCHMARK_EXAMPLE_FILTER").ok();
-    static ref REPETITION_COUNT: usize = env::var("TREE_SITTER_BENCHMARK_REPETITION_COUNT")
-        .map(|s| usize::from_str_radix(&s, 10).unwrap())
-        .unwrap_or(5);
-    static ref TEST_LOADER: Loader = Loader::with_parser_lib_path(SCRATCH_DIR.clone());
     static ref EXAMPLE_AND_QUERY_PATHS_BY_LANGUAGE_DIR: BTreeMap<PathBuf, (Vec<PathBuf>, Vec<PathBuf>)> = {
         fn process_dir(result: &mut BTreeMap<PathBuf, (Vec<PathBuf>, Vec<PathBuf>)>, dir: &Path) {
             if dir.join("grammar.js").exists() {
-                let relative_path = dir.strip_prefix(GRAMMARS_DIR.as_path()).unwrap();
+                let relative_path = dir.strip_prefix(grammars_dir()).unwrap();
                 let (example_paths, query_paths) =
                     result.entry(relative_path.to_owned()).or_default();
 
@@ -57,7 +49,7 @@ lazy_static! {
         }
 
         let mut result = BTreeMap::new();
-        process_dir(&mut result, &GRAMMARS_DIR);
+        process_dir(&mut result, grammars_dir());
         result
     };
 }
@@ -205,11 +197,3 @@ fn parse(path: &Path, max_path_length: usize, mut action: impl FnMut(&[u8])) ->
     eprintln!("time {} ms\tspeed {} bytes/ms", duration_ms as usize, speed);
     speed as usize
 }
-
-fn get_language(path: &Path) -> Language {
-    let src_dir = GRAMMARS_DIR.join(path).join("src");
-    TEST_LOADER
-        .load_language_at_path(&src_dir, &src_dir)
-        .with_context(|| format!("Failed to load language at path {:?}", src_dir))
-        .unwrap()
-}
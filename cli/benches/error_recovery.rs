@@ -0,0 +1,84 @@
+mod helpers;
+
+use helpers::{get_language, language_dirs, LANGUAGE_FILTER, REPETITION_COUNT};
+use lazy_static::lazy_static;
+use rand::prelude::{Rng, SeedableRng, StdRng};
+use std::time::Instant;
+use std::{env, usize};
+use tree_sitter::Parser;
+
+lazy_static! {
+    static ref INPUT_SIZE: usize = env::var("TREE_SITTER_BENCHMARK_INPUT_SIZE")
+        .map(|s| usize::from_str_radix(&s, 10).unwrap())
+        .unwrap_or(256 * 1024);
+}
+
+// The recovery budgets to compare. Zero means that recovery is unlimited.
+const RECOVERY_BUDGETS: &[u32] = &[0, 1000, 100, 10];
+
+// Characters that are common in source code, so that random input made from
+// them contains many tokens that are valid on their own, but not in sequence.
+const CODE_CHARACTERS: &[u8] = b"{}()[];,.<>=+-*/!&|?:'\"` \nabcxyz019";
+
+// Measure how quickly each fixture grammar parses garbage, with a range of
+// recovery budgets. Two kinds of input are generated: arbitrary bytes, and
+// random sequences of characters that are common in source code.
+fn main() {
+    eprintln!(
+        "Benchmarking with {} repetitions on {} byte inputs",
+        *REPETITION_COUNT, *INPUT_SIZE
+    );
+
+    let mut rng = StdRng::seed_from_u64(0);
+    let random_bytes = (0..*INPUT_SIZE).map(|_| rng.gen()).collect::<Vec<u8>>();
+    let random_code = (0..*INPUT_SIZE)
+        .map(|_| CODE_CHARACTERS[rng.gen_range(0..CODE_CHARACTERS.len())])
+        .collect::<Vec<u8>>();
+
+    let mut parser = Parser::new();
+    for language_path in language_dirs() {
+        let language_name = language_path.file_name().unwrap().to_str().unwrap();
+        if let Some(filter) = LANGUAGE_FILTER.as_ref() {
+            if language_name != filter.as_str() {
+                continue;
+            }
+        }
+
+        eprintln!("\nLanguage: {}", language_name);
+        parser.set_language(get_language(&language_path)).unwrap();
+        for (input_name, input) in [
+            ("random bytes", &random_bytes),
+            ("random code", &random_code),
+        ] {
+            eprintln!("  {}:", input_name);
+            for budget in RECOVERY_BUDGETS {
+                parser.set_recovery_budget(*budget);
+                let (speed, node_count) = parse_speed(&mut parser, input);
+                eprintln!(
+                    "    budget {:>5}: {:>6} bytes/ms, {:>6} nodes",
+                    if *budget == 0 {
+                        "none".to_string()
+                    } else {
+                        budget.to_string()
+                    },
+                    speed,
+                    node_count
+                );
+            }
+        }
+    }
+    eprintln!("");
+}
+
+// Return the parsing speed in bytes per millisecond, and the number of nodes
+// in the resulting tree.
+fn parse_speed(parser: &mut Parser, source: &[u8]) -> (usize, usize) {
+    let time = Instant::now();
+    let mut tree = None;
+    for _ in 0..*REPETITION_COUNT {
+        tree = Some(parser.parse(source, None).expect("Failed to parse"));
+    }
+    let duration = time.elapsed() / (*REPETITION_COUNT as u32);
+    let speed = (source.len() as u128 * 1000 / (duration.as_micros() + 1)) as usize;
+    (speed, tree.unwrap().root_node().descendant_count())
+}
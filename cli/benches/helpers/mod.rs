@@ -0,0 +1,87 @@
+// Each benchmark only uses some of these helpers.
+#![allow(dead_code)]
+
+use anyhow::Context;
+use lazy_static::lazy_static;
+use std::path::{Path, PathBuf};
+use std::{env, fs, usize};
+use tree_sitter::Language;
+use tree_sitter_loader::Loader;
+
+include!("../../src/tests/helpers/dirs.rs");
+
+lazy_static! {
+    pub static ref LANGUAGE_FILTER: Option<String> =
+        env::var("TREE_SITTER_BENCHMARK_LANGUAGE_FILTER").ok();
+    pub static ref EXAMPLE_FILTER: Option<String> =
+        env::var("TREE_SITTER_BENCHMARK_EXAMPLE_FILTER").ok();
+    pub static ref REPETITION_COUNT: usize = env::var("TREE_SITTER_BENCHMARK_REPETITION_COUNT")
+        .map(|s| usize::from_str_radix(&s, 10).unwrap())
+        .unwrap_or(5);
+    static ref TEST_LOADER: Loader = Loader::with_parser_lib_path(SCRATCH_DIR.clone());
+}
+
+pub fn grammars_dir() -> &'static Path {
+    &GRAMMARS_DIR
+}
+
+pub fn header_dir() -> &'static Path {
+    &HEADER_DIR
+}
+
+pub fn scratch_dir() -> &'static Path {
+    &SCRATCH_DIR
+}
+
+pub fn get_language(path: &Path) -> Language {
+    let src_dir = GRAMMARS_DIR.join(path).join("src");
+    TEST_LOADER
+        .load_language_at_path(&src_dir, &src_dir)
+        .with_context(|| format!("Failed to load language at path {:?}", src_dir))
+        .unwrap()
+}
+
+// The fixture grammars, relative to the grammars directory, in sorted order.
+pub fn language_dirs() -> Vec<PathBuf> {
+    fn process_dir(result: &mut Vec<PathBuf>, dir: &Path) {
+        if dir.join("grammar.js").exists() {
+            result.push(dir.strip_prefix(GRAMMARS_DIR.as_path()).unwrap().to_owned());
+        } else {
+            for entry in fs::read_dir(&dir).unwrap() {
+                let entry = entry.unwrap().path();
+                if entry.is_dir() {
+                    process_dir(result, &entry);
+                }
+            }
+        }
+    }
+
+    let mut result = Vec::new();
+    process_dir(&mut result, &GRAMMARS_DIR);
+    result.sort();
+    result
+}
+
+// The fixture grammars that have examples, along with the paths of their
+// examples, in sorted order.
+pub fn example_paths_by_language_dir() -> Vec<(PathBuf, Vec<PathBuf>)> {
+    language_dirs()
+        .into_iter()
+        .filter_map(|language_dir| {
+            let example_files = fs::read_dir(GRAMMARS_DIR.join(&language_dir).join("examples"));
+            let mut example_paths = example_files
+                .ok()?
+                .filter_map(|p| {
+                    let p = p.unwrap().path();
+                    if p.is_file() {
+                        Some(p)
+                    } else {
+                        None
+                    }
+                })
+                .collect::<Vec<_>>();
+            example_paths.sort();
+            Some((language_dir, example_paths))
+        })
+        .collect()
+}
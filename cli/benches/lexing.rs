@@ -0,0 +1,157 @@
+mod helpers;
+
+use anyhow::Context;
+use helpers::{
+    example_paths_by_language_dir, grammars_dir, header_dir, scratch_dir, EXAMPLE_FILTER,
+    LANGUAGE_FILTER, REPETITION_COUNT,
+};
+use std::fs;
+use std::path::Path;
+use std::time::Instant;
+use tree_sitter::{Language, Parser};
+use tree_sitter_cli::generate::{
+    generate_parser_for_grammar_with_abi_version, generate_parser_for_grammar_with_lex_tables,
+};
+use tree_sitter_loader::Loader;
+
+// The last ABI version whose lexers advance through every character one at
+// a time.
+const BASELINE_ABI_VERSION: usize = 14;
+
+#[derive(Clone, Copy, PartialEq, Eq)]
+enum LexerKind {
+    Baseline,
+    Functions,
+    Tables,
+}
+
+// Compare the parsing speed of each fixture grammar when it is generated for
+// the baseline ABI version, and when it is generated for the current ABI
+// version, whose lexers skip over runs of ASCII characters in bulk. Also
+// compare the current ABI version's lexing functions with its table-driven
+// lexers.
+fn main() {
+    eprintln!("Benchmarking with {} repetitions", *REPETITION_COUNT);
+
+    let mut baseline_parser = Parser::new();
+    let mut parser = Parser::new();
+    let mut table_parser = Parser::new();
+    let mut all_speedups = Vec::new();
+    let mut all_table_speed_ratios = Vec::new();
+    for (language_path, example_paths) in example_paths_by_language_dir() {
+        let language_name = language_path.file_name().unwrap().to_str().unwrap();
+        if let Some(filter) = LANGUAGE_FILTER.as_ref() {
+            if language_name != filter.as_str() {
+                continue;
+            }
+        }
+
+        eprintln!("\nLanguage: {}", language_name);
+        baseline_parser
+            .set_language(generate_language(&language_path, LexerKind::Baseline))
+            .unwrap();
+        parser
+            .set_language(generate_language(&language_path, LexerKind::Functions))
+            .unwrap();
+        table_parser
+            .set_language(generate_language(&language_path, LexerKind::Tables))
+            .unwrap();
+
+        for example_path in example_paths {
+            if let Some(filter) = EXAMPLE_FILTER.as_ref() {
+                if !example_path.to_str().unwrap().contains(filter.as_str()) {
+                    continue;
+                }
+            }
+
+            let source_code = fs::read(&example_path)
+                .with_context(|| format!("Failed to read {:?}", example_path))
+                .unwrap();
+            let baseline_speed = parse_speed(&mut baseline_parser, &source_code);
+            let speed = parse_speed(&mut parser, &source_code);
+            let table_speed = parse_speed(&mut table_parser, &source_code);
+            let speedup = speed as f64 / baseline_speed.max(1) as f64;
+            let table_speed_ratio = table_speed as f64 / speed.max(1) as f64;
+            all_speedups.push(speedup);
+            all_table_speed_ratios.push(table_speed_ratio);
+            eprintln!(
+                "  {:30}\tABI {}: {} bytes/ms\tABI {}: {} bytes/ms ({:.2}x)\ttables: {} bytes/ms ({:.2}x)",
+                example_path.file_name().unwrap().to_str().unwrap(),
+                BASELINE_ABI_VERSION,
+                baseline_speed,
+                tree_sitter::LANGUAGE_VERSION,
+                speed,
+                speedup,
+                table_speed,
+                table_speed_ratio,
+            );
+        }
+    }
+
+    if !all_speedups.is_empty() {
+        all_speedups.sort_by(|a, b| a.partial_cmp(b).unwrap());
+        eprintln!("\n  Overall");
+        eprintln!(
+            "  Average speedup: {:.2}x",
+            all_speedups.iter().sum::<f64>() / all_speedups.len() as f64
+        );
+        eprintln!("  Worst speedup: {:.2}x", all_speedups[0]);
+        eprintln!(
+            "  Average speed of tables relative to functions: {:.2}x",
+            all_table_speed_ratios.iter().sum::<f64>() / all_table_speed_ratios.len() as f64
+        );
+    }
+    eprintln!("");
+}
+
+fn parse_speed(parser: &mut Parser, source_code: &[u8]) -> usize {
+    let time = Instant::now();
+    for _ in 0..*REPETITION_COUNT {
+        parser.parse(source_code, None).expect("Failed to parse");
+    }
+    let duration = time.elapsed() / (*REPETITION_COUNT as u32);
+    let duration_ms = duration.as_micros() as f64 / 1000.0;
+    (source_code.len() as f64 / duration_ms.max(0.001)) as usize
+}
+
+// Generate the grammar's parser with the given kind of lexer. Each kind is
+// compiled into its own directory, because the libraries export the same
+// symbols.
+fn generate_language(path: &Path, kind: LexerKind) -> Language {
+    let src_dir = grammars_dir().join(path).join("src");
+    let grammar_json = fs::read_to_string(src_dir.join("grammar.json"))
+        .with_context(|| format!("Failed to read grammar in {:?}", src_dir))
+        .unwrap();
+    let (name, parser_code) = match kind {
+        LexerKind::Baseline => {
+            generate_parser_for_grammar_with_abi_version(&grammar_json, BASELINE_ABI_VERSION)
+        }
+        LexerKind::Functions => generate_parser_for_grammar_with_abi_version(
+            &grammar_json,
+            tree_sitter::LANGUAGE_VERSION,
+        ),
+        LexerKind::Tables => generate_parser_for_grammar_with_lex_tables(&grammar_json),
+    }
+    .with_context(|| format!("Failed to generate parser in {:?}", src_dir))
+    .unwrap();
+
+    let scratch_dir = scratch_dir().join(match kind {
+        LexerKind::Baseline => "lexing-baseline",
+        LexerKind::Functions => "lexing-functions",
+        LexerKind::Tables => "lexing-tables",
+    });
+    fs::create_dir_all(&scratch_dir).unwrap();
+    let parser_path = scratch_dir.join(format!("{}-parser.c", name));
+    if fs::read_to_string(&parser_path).ok().as_ref() != Some(&parser_code) {
+        fs::write(&parser_path, &parser_code).unwrap();
+    }
+    let scanner_path = ["scanner.c", "scanner.cc"]
+        .iter()
+        .map(|file_name| src_dir.join(file_name))
+        .find(|path| path.exists());
+
+    Loader::with_parser_lib_path(scratch_dir)
+        .load_language_from_sources(&name, header_dir(), &parser_path, &scanner_path)
+        .with_context(|| format!("Failed to load language in {:?}", src_dir))
+        .unwrap()
+}
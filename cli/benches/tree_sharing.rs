@@ -0,0 +1,138 @@
+mod helpers;
+
+use anyhow::Context;
+use helpers::{
+    example_paths_by_language_dir, get_language, EXAMPLE_FILTER, LANGUAGE_FILTER, REPETITION_COUNT,
+};
+use lazy_static::lazy_static;
+use std::sync::{Arc, Barrier};
+use std::time::{Duration, Instant};
+use std::{env, fs, thread, usize};
+use tree_sitter::{Parser, Tree};
+
+lazy_static! {
+    static ref THREAD_COUNT: usize = env::var("TREE_SITTER_BENCHMARK_THREAD_COUNT")
+        .map(|s| usize::from_str_radix(&s, 10).unwrap())
+        .unwrap_or_else(|_| thread::available_parallelism().map_or(4, |n| n.get()));
+}
+
+// The number of copies that each thread creates and deletes per repetition.
+const COPIES_PER_THREAD: usize = 10_000;
+
+// Stress the deletion of syntax trees that are shared between threads.
+//
+// For each example file, this measures two things:
+// * The throughput of copying and deleting a tree that is shared by all of
+//   the threads.
+// * The latency of deleting a thread's handle to a tree, when the tree's last
+//   handles are dropped on many threads at once. Whichever thread drops the
+//   last handle frees the entire tree, so the worst latency includes the cost
+//   of the teardown. With `Tree::drop_in_background`, that cost moves to the
+//   background reclamation thread.
+fn main() {
+    eprintln!(
+        "Benchmarking with {} repetitions on {} threads",
+        *REPETITION_COUNT, *THREAD_COUNT
+    );
+
+    let mut parser = Parser::new();
+    for (language_path, example_paths) in example_paths_by_language_dir() {
+        let language_name = language_path.file_name().unwrap().to_str().unwrap();
+        if let Some(filter) = LANGUAGE_FILTER.as_ref() {
+            if language_name != filter.as_str() {
+                continue;
+            }
+        }
+
+        eprintln!("\nLanguage: {}", language_name);
+        parser.set_language(get_language(&language_path)).unwrap();
+
+        for example_path in example_paths {
+            if let Some(filter) = EXAMPLE_FILTER.as_ref() {
+                if !example_path.to_str().unwrap().contains(filter.as_str()) {
+                    continue;
+                }
+            }
+
+            let source_code = fs::read(&example_path)
+                .with_context(|| format!("Failed to read {:?}", example_path))
+                .unwrap();
+            let tree = parser.parse(&source_code, None).expect("Failed to parse");
+            eprintln!("  {}", example_path.file_name().unwrap().to_str().unwrap());
+
+            let copies_per_ms = copy_and_delete_shared_tree(&tree);
+            eprintln!("    copy/delete shared tree: {} copies/ms", copies_per_ms);
+
+            for (label, in_background) in [
+                ("delete last copies:      ", false),
+                ("delete in background:    ", true),
+            ] {
+                let mut worst_latency = Duration::ZERO;
+                let mut total_latency = Duration::ZERO;
+                for _ in 0..*REPETITION_COUNT {
+                    let tree = parser.parse(&source_code, None).expect("Failed to parse");
+                    let latencies = delete_last_copies_concurrently(tree, in_background);
+                    worst_latency = worst_latency.max(*latencies.iter().max().unwrap());
+                    total_latency += latencies.iter().sum::<Duration>();
+                }
+                let average_latency = total_latency / (*REPETITION_COUNT * *THREAD_COUNT) as u32;
+                eprintln!(
+                    "    {}average {} us\tworst {} us",
+                    label,
+                    average_latency.as_micros(),
+                    worst_latency.as_micros()
+                );
+            }
+        }
+    }
+    eprintln!("");
+}
+
+fn copy_and_delete_shared_tree(tree: &Tree) -> usize {
+    let barrier = Arc::new(Barrier::new(*THREAD_COUNT + 1));
+    let threads = (0..*THREAD_COUNT)
+        .map(|_| {
+            let tree = tree.clone();
+            let barrier = barrier.clone();
+            thread::spawn(move || {
+                barrier.wait();
+                for _ in 0..(*REPETITION_COUNT * COPIES_PER_THREAD) {
+                    drop(tree.clone());
+                }
+            })
+        })
+        .collect::<Vec<_>>();
+
+    barrier.wait();
+    let time = Instant::now();
+    for thread in threads {
+        thread.join().unwrap();
+    }
+    let copy_count = *THREAD_COUNT * *REPETITION_COUNT * COPIES_PER_THREAD;
+    (copy_count as u128 / (time.elapsed().as_millis() + 1)) as usize
+}
+
+fn delete_last_copies_concurrently(tree: Tree, in_background: bool) -> Vec<Duration> {
+    let barrier = Arc::new(Barrier::new(*THREAD_COUNT));
+    let threads = (0..*THREAD_COUNT)
+        .map(|_| {
+            let tree = tree.clone();
+            let barrier = barrier.clone();
+            thread::spawn(move || {
+                barrier.wait();
+                let time = Instant::now();
+                if in_background {
+                    tree.drop_in_background();
+                } else {
+                    drop(tree);
+                }
+                time.elapsed()
+            })
+        })
+        .collect::<Vec<_>>();
+    drop(tree);
+    threads
+        .into_iter()
+        .map(|thread| thread.join().unwrap())
+        .collect()
+}
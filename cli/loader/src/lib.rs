@@ -101,6 +101,7 @@ pub struct Loader {
     highlight_names: Box<Mutex<Vec<String>>>,
     use_all_highlight_names: bool,
     debug_build: bool,
+    libraries_by_language: Mutex<HashMap<Language, (PathBuf, Option<u64>)>>,
 }
 
 unsafe impl Send for Loader {}
@@ -127,6 +128,7 @@ impl Loader {
             highlight_names: Box::new(Mutex::new(Vec::new())),
             use_all_highlight_names: true,
             debug_build: false,
+            libraries_by_language: Mutex::new(HashMap::new()),
         }
     }
 
@@ -448,9 +450,33 @@ impl Loader {
             language_fn()
         };
         mem::forget(library);
+        self.libraries_by_language
+            .lock()
+            .unwrap()
+            .insert(language, (library_path, None));
         Ok(language)
     }
 
+    /// Get a hash of the compiled library that a language was loaded from.
+    ///
+    /// The hash changes whenever the grammar, its external scanner, or the way
+    /// that it was compiled changes, so it can be used to identify data that
+    /// was derived from a particular version of a grammar. Returns `None` if
+    /// the language wasn't loaded by this loader.
+    pub fn grammar_hash(&self, language: Language) -> Result<Option<u64>> {
+        let mut libraries = self.libraries_by_language.lock().unwrap();
+        let (library_path, hash) = match libraries.get_mut(&language) {
+            Some(entry) => entry,
+            None => return Ok(None),
+        };
+        if hash.is_none() {
+            let library = fs::read(&library_path)
+                .with_context(|| format!("Failed to read library {:?}", library_path))?;
+            *hash = Some(hash_bytes(&library));
+        }
+        Ok(*hash)
+    }
+
     pub fn highlight_config_for_injection_string<'a>(
         &'a self,
         string: &str,
@@ -820,6 +846,14 @@ impl<'a> LanguageConfiguration<'a> {
     }
 }
 
+/// A 64-bit FNV-1a hash, which unlike the standard library's hasher is stable
+/// across compiler versions.
+pub fn hash_bytes(bytes: &[u8]) -> u64 {
+    bytes.iter().fold(0xcbf29ce484222325, |hash, byte| {
+        (hash ^ *byte as u64).wrapping_mul(0x100000001b3)
+    })
+}
+
 fn needs_recompile(
     lib_path: &Path,
     parser_c_path: &Path,
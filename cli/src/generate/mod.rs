@@ -15,7 +15,7 @@ use self::build_tables::build_tables;
 use self::grammars::{InlinedProductionMap, LexicalGrammar, SyntaxGrammar};
 use self::parse_grammar::parse_grammar;
 use self::prepare_grammar::prepare_grammar;
-use self::render::render_c_code;
+use self::render::{render_c_code, ABI_VERSION_WITH_LEX_TABLES, LEX_TABLE_MAX_STATE_COUNT};
 use self::rules::AliasMap;
 use anyhow::{anyhow, Context, Result};
 use lazy_static::lazy_static;
@@ -42,6 +42,7 @@ pub fn generate_parser_in_directory(
     repo_path: &PathBuf,
     grammar_path: Option<&str>,
     abi_version: usize,
+    use_lex_tables: bool,
     generate_bindings: bool,
     report_symbol_name: Option<&str>,
     js_runtime: Option<&str>,
@@ -84,6 +85,7 @@ pub fn generate_parser_in_directory(
         inlines,
         simple_aliases,
         abi_version,
+        use_lex_tables,
         report_symbol_name,
     )?;
 
@@ -99,6 +101,25 @@ pub fn generate_parser_in_directory(
 }
 
 pub fn generate_parser_for_grammar(grammar_json: &str) -> Result<(String, String)> {
+    generate_parser_for_grammar_with_abi_version(grammar_json, tree_sitter::LANGUAGE_VERSION)
+}
+
+pub fn generate_parser_for_grammar_with_abi_version(
+    grammar_json: &str,
+    abi_version: usize,
+) -> Result<(String, String)> {
+    generate_parser_for_grammar_with_config(grammar_json, abi_version, false)
+}
+
+pub fn generate_parser_for_grammar_with_lex_tables(grammar_json: &str) -> Result<(String, String)> {
+    generate_parser_for_grammar_with_config(grammar_json, tree_sitter::LANGUAGE_VERSION, true)
+}
+
+fn generate_parser_for_grammar_with_config(
+    grammar_json: &str,
+    abi_version: usize,
+    use_lex_tables: bool,
+) -> Result<(String, String)> {
     let grammar_json = JSON_COMMENT_REGEX.replace_all(grammar_json, "\n");
     let input_grammar = parse_grammar(&grammar_json)?;
     let (syntax_grammar, lexical_grammar, inlines, simple_aliases) =
@@ -109,7 +130,8 @@ pub fn generate_parser_for_grammar(grammar_json: &str) -> Result<(String, String
         lexical_grammar,
         inlines,
         simple_aliases,
-        tree_sitter::LANGUAGE_VERSION,
+        abi_version,
+        use_lex_tables,
         None,
     )?;
     Ok((input_grammar.name, parser.c_code))
@@ -122,8 +144,16 @@ fn generate_parser_for_grammar_with_opts(
     inlines: InlinedProductionMap,
     simple_aliases: AliasMap,
     abi_version: usize,
+    use_lex_tables: bool,
     report_symbol_name: Option<&str>,
 ) -> Result<GeneratedParser> {
+    if use_lex_tables && abi_version < ABI_VERSION_WITH_LEX_TABLES {
+        return Err(anyhow!(
+            "Table-driven lexers require ABI version {} or later",
+            ABI_VERSION_WITH_LEX_TABLES
+        ));
+    }
+
     let variable_info =
         node_types::get_variable_info(&syntax_grammar, &lexical_grammar, &simple_aliases)?;
     let node_types_json = node_types::generate_node_types_json(
@@ -140,6 +170,17 @@ fn generate_parser_for_grammar_with_opts(
         &inlines,
         report_symbol_name,
     )?;
+    if use_lex_tables {
+        for lex_table in [&main_lex_table, &keyword_lex_table] {
+            if lex_table.states.len() > LEX_TABLE_MAX_STATE_COUNT {
+                return Err(anyhow!(
+                    "Table-driven lexers can have at most {} states, but this grammar needs {}",
+                    LEX_TABLE_MAX_STATE_COUNT,
+                    lex_table.states.len()
+                ));
+            }
+        }
+    }
     let c_code = render_c_code(
         name,
         parse_table,
@@ -150,6 +191,7 @@ fn generate_parser_for_grammar_with_opts(
         lexical_grammar,
         simple_aliases,
         abi_version,
+        use_lex_tables,
     );
     Ok(GeneratedParser {
         c_code,
@@ -294,6 +294,10 @@ impl CharacterSet {
         self.ranges.iter().flat_map(|r| r.clone())
     }
 
+    pub fn ranges<'a>(&'a self) -> impl Iterator<Item = &'a Range<u32>> + 'a {
+        self.ranges.iter()
+    }
+
     pub fn chars<'a>(&'a self) -> impl Iterator<Item = char> + 'a {
         self.iter().filter_map(char::from_u32)
     }
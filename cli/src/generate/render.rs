@@ -20,6 +20,14 @@ const SMALL_STATE_THRESHOLD: usize = 64;
 const ABI_VERSION_MIN: usize = 13;
 const ABI_VERSION_MAX: usize = tree_sitter::LANGUAGE_VERSION;
 const ABI_VERSION_WITH_PRIMARY_STATES: usize = 14;
+const ABI_VERSION_WITH_ADVANCE_WHILE_IN_SET: usize = 15;
+pub(crate) const ABI_VERSION_WITH_LEX_TABLES: usize = 15;
+const ABI_VERSION_WITH_SMALL_STATE_MASKS: usize = 15;
+
+// Lex table entries store the next state plus one, with the high bit
+// reserved for marking skipped characters.
+pub(crate) const LEX_TABLE_MAX_STATE_COUNT: usize = 0x7fff;
+const LEX_TABLE_SKIP: u16 = 0x8000;
 
 macro_rules! add {
     ($this: tt, $($arg: tt)*) => {{
@@ -74,6 +82,7 @@ struct Generator {
     unique_aliases: Vec<Alias>,
     symbol_map: HashMap<Symbol, Symbol>,
     field_names: Vec<String>,
+    use_lex_tables: bool,
 
     #[allow(unused)]
     abi_version: usize,
@@ -83,6 +92,7 @@ struct TransitionSummary {
     is_included: bool,
     ranges: Vec<Range<char>>,
     call_id: Option<usize>,
+    ascii_set_id: Option<usize>,
 }
 
 struct LargeCharacterSetInfo {
@@ -120,12 +130,20 @@ impl Generator {
 
         let mut main_lex_table = LexTable::default();
         swap(&mut main_lex_table, &mut self.main_lex_table);
-        self.add_lex_function("ts_lex", main_lex_table, true);
+        if self.use_lex_tables {
+            self.add_lex_table("ts_lex", main_lex_table);
+        } else {
+            self.add_lex_function("ts_lex", main_lex_table, true);
+        }
 
         if self.keyword_capture_token.is_some() {
             let mut keyword_lex_table = LexTable::default();
             swap(&mut keyword_lex_table, &mut self.keyword_lex_table);
-            self.add_lex_function("ts_lex_keywords", keyword_lex_table, false);
+            if self.use_lex_tables {
+                self.add_lex_table("ts_lex_keywords", keyword_lex_table);
+            } else {
+                self.add_lex_function("ts_lex_keywords", keyword_lex_table, false);
+            }
         }
 
         self.add_lex_modes_list();
@@ -673,13 +691,15 @@ impl Generator {
     ) {
         let mut ruled_out_chars = HashSet::new();
         let mut large_character_sets = Vec::<LargeCharacterSetInfo>::new();
+        let mut ascii_sets = Vec::<[u8; 16]>::new();
 
         // For each lex state, compute a summary of the code that needs to be
         // generated.
         let state_transition_summaries: Vec<Vec<TransitionSummary>> = lex_table
             .states
             .iter()
-            .map(|state| {
+            .enumerate()
+            .map(|(state_id, state)| {
                 ruled_out_chars.clear();
 
                 // For each state transition, compute the set of character ranges
@@ -725,10 +745,37 @@ impl Generator {
                             }
                         }
 
+                        // When a state loops back to itself, the lexer can skip over
+                        // runs of ASCII characters in bulk, rather than advancing
+                        // through them one at a time.
+                        let mut ascii_set_id = None;
+                        if action.state == state_id
+                            && self.abi_version >= ABI_VERSION_WITH_ADVANCE_WHILE_IN_SET
+                        {
+                            let mut ascii_set = [0u8; 16];
+                            for c in 1..128u8 {
+                                if chars.contains(c as char) {
+                                    ascii_set[(c & 15) as usize] |= 1 << (c >> 4);
+                                }
+                            }
+                            if ascii_set != [0; 16] {
+                                ascii_set_id = Some(
+                                    ascii_sets
+                                        .iter()
+                                        .position(|set| *set == ascii_set)
+                                        .unwrap_or_else(|| {
+                                            ascii_sets.push(ascii_set);
+                                            ascii_sets.len() - 1
+                                        }),
+                                );
+                            }
+                        }
+
                         TransitionSummary {
                             is_included,
                             ranges,
                             call_id,
+                            ascii_set_id,
                         }
                     })
                     .collect()
@@ -756,6 +803,31 @@ impl Generator {
             add_line!(self, "");
         }
 
+        // Generate a table of the ASCII character sets that can be skipped over in bulk.
+        if !ascii_sets.is_empty() {
+            add_line!(
+                self,
+                "static const uint8_t {}_ascii_sets[{}][16] = {{",
+                name,
+                ascii_sets.len()
+            );
+            indent!(self);
+            for set in &ascii_sets {
+                add_whitespace!(self);
+                add!(self, "{{");
+                for (i, byte) in set.iter().enumerate() {
+                    if i > 0 {
+                        add!(self, ", ");
+                    }
+                    add!(self, "0x{:02x}", byte);
+                }
+                add!(self, "}},\n");
+            }
+            dedent!(self);
+            add_line!(self, "}};");
+            add_line!(self, "");
+        }
+
         add_line!(
             self,
             "static bool {}(TSLexer *lexer, TSStateId state) {{",
@@ -771,7 +843,12 @@ impl Generator {
         for (i, state) in lex_table.states.into_iter().enumerate() {
             add_line!(self, "case {}:", i);
             indent!(self);
-            self.add_lex_state(state, &state_transition_summaries[i], &large_character_sets);
+            self.add_lex_state(
+                name,
+                state,
+                &state_transition_summaries[i],
+                &large_character_sets,
+            );
             dedent!(self);
         }
 
@@ -788,6 +865,267 @@ impl Generator {
         add_line!(self, "");
     }
 
+    fn add_lex_table(&mut self, name: &str, lex_table: LexTable) {
+        // Split the characters into segments at every boundary of every character
+        // set. The null character gets its own segment, because it is never matched
+        // by negated character sets. The ASCII characters are separated from the rest,
+        // because they are classified by a lookup table.
+        let mut boundaries = vec![0, 1, 128, char::MAX as u32 + 1];
+        for state in &lex_table.states {
+            for (chars, _) in &state.advance_actions {
+                for range in chars.ranges() {
+                    boundaries.push(range.start);
+                    boundaries.push(range.end);
+                }
+            }
+        }
+        boundaries.sort_unstable();
+        boundaries.dedup();
+        let segment_count = boundaries.len() - 1;
+        let segment_for_char = |c: u32| match boundaries.binary_search(&c) {
+            Ok(i) => i,
+            Err(i) => i - 1,
+        };
+
+        // For each segment, list the transitions that it takes in every state.
+        let mut segment_transitions = vec![Vec::new(); segment_count];
+        for (state_id, state) in lex_table.states.iter().enumerate() {
+            for (chars, action) in &state.advance_actions {
+                let is_included = !chars.contains(char::MAX);
+                let mut entry = action.state as u16 + 1;
+                if !action.in_main_token {
+                    entry |= LEX_TABLE_SKIP;
+                }
+                for range in chars.ranges() {
+                    for segment in segment_for_char(range.start)..segment_for_char(range.end) {
+                        if segment > 0 || is_included {
+                            segment_transitions[segment].push((state_id, entry));
+                        }
+                    }
+                }
+            }
+        }
+
+        // Segments that take the same transitions in every state belong to the
+        // same character class.
+        let mut class_ids = HashMap::new();
+        let segment_classes = segment_transitions
+            .iter()
+            .map(|transitions| {
+                let class_count = class_ids.len();
+                *class_ids.entry(transitions).or_insert(class_count)
+            })
+            .collect::<Vec<_>>();
+        let class_count = class_ids.len();
+
+        // Build each state's row of transitions, sharing identical rows.
+        let mut state_rows = vec![vec![0u16; class_count]; lex_table.states.len()];
+        for (segment, transitions) in segment_transitions.iter().enumerate() {
+            for (state_id, entry) in transitions {
+                state_rows[*state_id][segment_classes[segment]] = *entry;
+            }
+        }
+        let mut rows = Vec::new();
+        let mut row_ids = HashMap::new();
+        let state_row_ids = state_rows
+            .iter()
+            .map(|row| {
+                *row_ids.entry(row).or_insert_with(|| {
+                    rows.push(row);
+                    rows.len() - 1
+                })
+            })
+            .collect::<Vec<_>>();
+
+        // When a state loops back to itself through a single transition, the ASCII
+        // characters in that transition can be skipped over in bulk.
+        let mut ascii_sets = Vec::<[u8; 16]>::new();
+        let state_loop_sets = lex_table
+            .states
+            .iter()
+            .enumerate()
+            .map(|(state_id, state)| {
+                let mut loops = state
+                    .advance_actions
+                    .iter()
+                    .filter(|(_, action)| action.state == state_id);
+                let (chars, _) = loops.next()?;
+                if loops.next().is_some() {
+                    return None;
+                }
+                let mut ascii_set = [0u8; 16];
+                for c in 1..128u8 {
+                    if chars.contains(c as char) {
+                        ascii_set[(c & 15) as usize] |= 1 << (c >> 4);
+                    }
+                }
+                if ascii_set == [0; 16] {
+                    return None;
+                }
+                Some(
+                    ascii_sets
+                        .iter()
+                        .position(|set| *set == ascii_set)
+                        .unwrap_or_else(|| {
+                            ascii_sets.push(ascii_set);
+                            ascii_sets.len() - 1
+                        }),
+                )
+            })
+            .collect::<Vec<_>>();
+
+        add_line!(
+            self,
+            "static const uint16_t {}_character_classes[128] = {{",
+            name
+        );
+        indent!(self);
+        let ascii_classes = (0..128)
+            .map(|c| segment_classes[segment_for_char(c)])
+            .collect::<Vec<_>>();
+        self.add_number_list(&ascii_classes);
+        dedent!(self);
+        add_line!(self, "}};");
+        add_line!(self, "");
+
+        let mut class_ranges = Vec::<(u32, usize)>::new();
+        for segment in segment_for_char(128)..segment_count {
+            let class = segment_classes[segment];
+            if class_ranges.last().map_or(true, |(_, c)| *c != class) {
+                class_ranges.push((boundaries[segment], class));
+            }
+        }
+        add_line!(
+            self,
+            "static const TSCharacterClassRange {}_character_class_ranges[{}] = {{",
+            name,
+            class_ranges.len()
+        );
+        indent!(self);
+        for (start, class) in &class_ranges {
+            add_line!(self, "{{0x{:x}, {}}},", start, class);
+        }
+        dedent!(self);
+        add_line!(self, "}};");
+        add_line!(self, "");
+
+        add_line!(
+            self,
+            "static const uint16_t {}_transitions[{}][{}] = {{",
+            name,
+            rows.len(),
+            class_count
+        );
+        indent!(self);
+        for (i, row) in rows.iter().enumerate() {
+            add_line!(self, "[{}] = {{", i);
+            indent!(self);
+            self.add_number_list(&row[..]);
+            dedent!(self);
+            add_line!(self, "}},");
+        }
+        dedent!(self);
+        add_line!(self, "}};");
+        add_line!(self, "");
+
+        if !ascii_sets.is_empty() {
+            add_line!(
+                self,
+                "static const uint8_t {}_ascii_sets[{}][16] = {{",
+                name,
+                ascii_sets.len()
+            );
+            indent!(self);
+            for set in &ascii_sets {
+                add_whitespace!(self);
+                add!(self, "{{");
+                for (i, byte) in set.iter().enumerate() {
+                    if i > 0 {
+                        add!(self, ", ");
+                    }
+                    add!(self, "0x{:02x}", byte);
+                }
+                add!(self, "}},\n");
+            }
+            dedent!(self);
+            add_line!(self, "}};");
+            add_line!(self, "");
+        }
+
+        add_line!(
+            self,
+            "static const TSLexTableState {}_states[{}] = {{",
+            name,
+            lex_table.states.len()
+        );
+        indent!(self);
+        for (i, state) in lex_table.states.iter().enumerate() {
+            add_whitespace!(self);
+            add!(self, "[{}] = {{.transition_row = {}", i, state_row_ids[i]);
+            if let Some(accept_action) = state.accept_action {
+                add!(
+                    self,
+                    ", .accept_symbol = {}, .accepts = true",
+                    self.symbol_ids[&accept_action]
+                );
+            }
+            if let Some(eof_action) = &state.eof_action {
+                add!(
+                    self,
+                    ", .eof_state = {}, .has_eof_state = true",
+                    eof_action.state
+                );
+            }
+            if let Some(loop_set) = state_loop_sets[i] {
+                add!(self, ", .loop_set = {}, .has_loop_set = true", loop_set);
+            }
+            add!(self, "}},\n");
+        }
+        dedent!(self);
+        add_line!(self, "}};");
+        add_line!(self, "");
+
+        add_line!(self, "static const TSLexTable {}_table = {{", name);
+        indent!(self);
+        add_line!(self, ".states = {}_states,", name);
+        add_line!(self, ".transitions = &{}_transitions[0][0],", name);
+        add_line!(
+            self,
+            ".ascii_character_classes = {}_character_classes,",
+            name
+        );
+        add_line!(
+            self,
+            ".character_class_ranges = {}_character_class_ranges,",
+            name
+        );
+        if !ascii_sets.is_empty() {
+            add_line!(self, ".ascii_sets = {}_ascii_sets,", name);
+        }
+        add_line!(
+            self,
+            ".character_class_range_count = {},",
+            class_ranges.len()
+        );
+        add_line!(self, ".character_class_count = {},", class_count);
+        dedent!(self);
+        add_line!(self, "}};");
+        add_line!(self, "");
+    }
+
+    fn add_number_list<T: std::fmt::Display>(&mut self, numbers: &[T]) {
+        for line in numbers.chunks(16) {
+            add_whitespace!(self);
+            for (i, n) in line.iter().enumerate() {
+                if i > 0 {
+                    add!(self, " ");
+                }
+                add!(self, "{},", n);
+            }
+            add!(self, "\n");
+        }
+    }
+
     fn symbol_for_advance_action(
         &self,
         action: &AdvanceAction,
@@ -813,6 +1151,7 @@ impl Generator {
 
     fn add_lex_state(
         &mut self,
+        name: &str,
         state: LexState,
         transition_info: &Vec<TransitionSummary>,
         large_character_sets: &Vec<LargeCharacterSetInfo>,
@@ -843,7 +1182,7 @@ impl Generator {
                     self.symbol_ids[&info.symbol],
                     info.index
                 );
-                self.add_advance_action(&action);
+                self.add_advance_action(name, &action, transition);
                 add!(self, "\n");
                 continue;
             }
@@ -855,7 +1194,7 @@ impl Generator {
                 self.add_character_range_conditions(&transition.ranges, transition.is_included, 2);
                 add!(self, ") ");
             }
-            self.add_advance_action(&action);
+            self.add_advance_action(name, &action, transition);
             add!(self, "\n");
         }
 
@@ -990,8 +1329,31 @@ impl Generator {
         }
     }
 
-    fn add_advance_action(&mut self, action: &AdvanceAction) {
-        if action.in_main_token {
+    fn add_advance_action(
+        &mut self,
+        name: &str,
+        action: &AdvanceAction,
+        transition: &TransitionSummary,
+    ) {
+        if let Some(ascii_set_id) = transition.ascii_set_id {
+            if action.in_main_token {
+                add!(
+                    self,
+                    "ADVANCE_WHILE_IN_SET({}, {}_ascii_sets[{}]);",
+                    action.state,
+                    name,
+                    ascii_set_id
+                );
+            } else {
+                add!(
+                    self,
+                    "SKIP_WHILE_IN_SET({}, {}_ascii_sets[{}])",
+                    action.state,
+                    name,
+                    ascii_set_id
+                );
+            }
+        } else if action.in_main_token {
             add!(self, "ADVANCE({});", action.state);
         } else {
             add!(self, "SKIP({})", action.state);
@@ -1163,7 +1525,14 @@ impl Generator {
         add_line!(self, "}};");
         add_line!(self, "");
 
-        if self.large_state_count < self.parse_table.states.len() {
+        if self.large_state_count < self.parse_table.states.len()
+            && self.abi_version >= ABI_VERSION_WITH_SMALL_STATE_MASKS
+        {
+            self.add_masked_small_parse_table(
+                &mut parse_table_entries,
+                &mut next_parse_action_list_index,
+            );
+        } else if self.large_state_count < self.parse_table.states.len() {
             add_line!(self, "static const uint16_t ts_small_parse_table[] = {{");
             indent!(self);
 
@@ -1266,6 +1635,157 @@ impl Generator {
         self.add_parse_action_list(parse_table_entries);
     }
 
+    // In the masked representation, each small state stores the id of a bitmask
+    // of its valid symbols, followed by the table values of those symbols, in
+    // symbol order. Identical masks and identical states are shared. Each 16-bit
+    // word of a mask is paired with the number of bits set in the preceding words,
+    // so that the runtime can locate a symbol's value without searching.
+    fn add_masked_small_parse_table(
+        &mut self,
+        parse_table_entries: &mut HashMap<ParseTableEntry, usize>,
+        next_parse_action_list_index: &mut usize,
+    ) {
+        let word_count = (self.parse_table.symbols.len() + 15) / 16;
+        let mut masks = Vec::new();
+        let mut mask_ids = HashMap::new();
+        let mut rows = Vec::new();
+        let mut row_indices = HashMap::new();
+        let mut small_state_indices = Vec::new();
+        let mut next_row_index = 0;
+        let mut terminal_entries = Vec::new();
+        let mut values = Vec::new();
+        for (i, state) in self
+            .parse_table
+            .states
+            .iter()
+            .enumerate()
+            .skip(self.large_state_count)
+        {
+            // Ensure that the action lists are numbered in a deterministic order,
+            // since the entries are internally represented as a hash map.
+            terminal_entries.clear();
+            terminal_entries.extend(state.terminal_entries.iter());
+            terminal_entries.sort_unstable_by_key(|e| self.symbol_order.get(e.0));
+
+            values.clear();
+            for (symbol, entry) in &terminal_entries {
+                let entry_id = self.get_parse_action_list_id(
+                    entry,
+                    parse_table_entries,
+                    next_parse_action_list_index,
+                );
+                // The end of a non-terminal extra has the same id as the end of
+                // the input.
+                let symbol_id = if symbol.kind == SymbolType::EndOfNonTerminalExtra {
+                    0
+                } else {
+                    self.symbol_order[symbol]
+                };
+                values.push((symbol_id, SymbolType::Terminal, entry_id));
+            }
+            for (symbol, action) in &state.nonterminal_entries {
+                let state_id = match action {
+                    GotoAction::Goto(state_id) => *state_id,
+                    GotoAction::ShiftExtra => i,
+                };
+                values.push((self.symbol_order[symbol], SymbolType::NonTerminal, state_id));
+            }
+            values.sort_unstable();
+            values.dedup_by_key(|(symbol_id, _, _)| *symbol_id);
+
+            let mut mask = vec![0u16; word_count];
+            for (symbol_id, _, _) in &values {
+                mask[symbol_id / 16] |= 1 << (symbol_id % 16);
+            }
+            let mask_id = *mask_ids.entry(mask.clone()).or_insert_with(|| {
+                masks.push(mask);
+                masks.len() - 1
+            });
+
+            let row = values
+                .iter()
+                .map(|(_, kind, value)| (*kind, *value))
+                .collect::<Vec<_>>();
+            let row_index = *row_indices
+                .entry((mask_id, row.clone()))
+                .or_insert_with(|| {
+                    let index = next_row_index;
+                    next_row_index += 1 + row.len();
+                    rows.push((index, mask_id, row));
+                    index
+                });
+            small_state_indices.push(row_index);
+        }
+
+        add_line!(
+            self,
+            "static const uint16_t ts_small_parse_table_masks[] = {{"
+        );
+        indent!(self);
+        for (i, mask) in masks.iter().enumerate() {
+            add_line!(self, "[{}] =", i * word_count * 2);
+            indent!(self);
+            let mut preceding_count = 0;
+            for words in mask.chunks(8) {
+                add_whitespace!(self);
+                for (j, word) in words.iter().enumerate() {
+                    if j > 0 {
+                        add!(self, " ");
+                    }
+                    add!(self, "0x{:04x}, {},", word, preceding_count);
+                    preceding_count += word.count_ones();
+                }
+                add!(self, "\n");
+            }
+            dedent!(self);
+        }
+        dedent!(self);
+        add_line!(self, "}};");
+        add_line!(self, "");
+
+        add_line!(self, "static const uint16_t ts_small_parse_table[] = {{");
+        indent!(self);
+        for (index, mask_id, row) in &rows {
+            add_line!(self, "[{}] = {},", index, mask_id);
+            indent!(self);
+            for values in row.chunks(8) {
+                add_whitespace!(self);
+                for (j, (kind, value)) in values.iter().enumerate() {
+                    if j > 0 {
+                        add!(self, " ");
+                    }
+                    if *kind == SymbolType::NonTerminal {
+                        add!(self, "STATE({}),", value);
+                    } else {
+                        add!(self, "ACTIONS({}),", value);
+                    }
+                }
+                add!(self, "\n");
+            }
+            dedent!(self);
+        }
+        dedent!(self);
+        add_line!(self, "}};");
+        add_line!(self, "");
+
+        add_line!(
+            self,
+            "static const uint32_t ts_small_parse_table_map[] = {{"
+        );
+        indent!(self);
+        for (i, index) in small_state_indices.iter().enumerate() {
+            add_line!(
+                self,
+                "[SMALL_STATE({})] = {},",
+                self.large_state_count + i,
+                index
+            );
+        }
+        dedent!(self);
+        add_line!(self, "}};");
+        add_line!(self, "");
+    }
+
     fn add_parse_action_list(&mut self, parse_table_entries: Vec<(usize, ParseTableEntry)>) {
         add_line!(
             self,
@@ -1404,9 +1924,13 @@ impl Generator {
 
         // Lexing
         add_line!(self, ".lex_modes = ts_lex_modes,");
-        add_line!(self, ".lex_fn = ts_lex,");
+        if !self.use_lex_tables {
+            add_line!(self, ".lex_fn = ts_lex,");
+        }
         if let Some(keyword_capture_token) = self.keyword_capture_token {
-            add_line!(self, ".keyword_lex_fn = ts_lex_keywords,");
+            if !self.use_lex_tables {
+                add_line!(self, ".keyword_lex_fn = ts_lex_keywords,");
+            }
             add_line!(
                 self,
                 ".keyword_capture_token = {},",
@@ -1432,6 +1956,22 @@ impl Generator {
             add_line!(self, ".primary_state_ids = ts_primary_state_ids,");
         }
 
+        if self.use_lex_tables {
+            add_line!(self, ".lex_table = &ts_lex_table,");
+            if self.keyword_capture_token.is_some() {
+                add_line!(self, ".keyword_lex_table = &ts_lex_keywords_table,");
+            }
+        }
+
+        if self.large_state_count < self.parse_table.states.len()
+            && self.abi_version >= ABI_VERSION_WITH_SMALL_STATE_MASKS
+        {
+            add_line!(
+                self,
+                ".small_parse_table_masks = ts_small_parse_table_masks,"
+            );
+        }
+
         dedent!(self);
         add_line!(self, "}};");
         add_line!(self, "return &language;");
@@ -1641,6 +2181,8 @@ impl Generator {
 /// * `abi_version` - The language ABI version that should be generated. Usually
 ///    you want Tree-sitter's current version, but right after making an ABI
 ///    change, it may be useful to generate code with the previous ABI.
+/// * `use_lex_tables` - Whether the lexers should be generated as transition
+///    tables, interpreted by the runtime, rather than as C functions.
 pub(crate) fn render_c_code(
     name: &str,
     parse_table: ParseTable,
@@ -1651,6 +2193,7 @@ pub(crate) fn render_c_code(
     lexical_grammar: LexicalGrammar,
     default_aliases: AliasMap,
     abi_version: usize,
+    use_lex_tables: bool,
 ) -> String {
     if !(ABI_VERSION_MIN..=ABI_VERSION_MAX).contains(&abi_version) {
         panic!(
@@ -1677,6 +2220,7 @@ pub(crate) fn render_c_code(
         symbol_map: HashMap::new(),
         unique_aliases: Vec::new(),
         field_names: Vec::new(),
+        use_lex_tables,
         abi_version,
     }
     .generate()
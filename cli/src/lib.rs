@@ -2,6 +2,7 @@ pub mod generate;
 pub mod highlight;
 pub mod logger;
 pub mod parse;
+pub mod parse_cache;
 pub mod playground;
 pub mod query;
 pub mod query_testing;
@@ -9,6 +10,7 @@ pub mod tags;
 pub mod test;
 pub mod test_highlight;
 pub mod test_tags;
+pub mod trace;
 pub mod util;
 pub mod wasm;
 
@@ -1,13 +1,14 @@
 use anyhow::{anyhow, Context, Error, Result};
-use clap::{App, AppSettings, Arg, SubCommand};
+use clap::{App, AppSettings, Arg, ArgMatches, SubCommand};
 use glob::glob;
 use std::path::{Path, PathBuf};
-use std::{env, fs, u64};
+use std::{env, fs, io, u64};
 use tree_sitter::{ffi, Point};
 use tree_sitter_cli::parse::{ParseFileOptions, ParseOutput};
+use tree_sitter_cli::parse_cache::{self, ParseCache};
 use tree_sitter_cli::{
     generate, highlight, logger, parse, playground, query, tags, test, test_highlight, test_tags,
-    util, wasm,
+    trace, util, wasm,
 };
 use tree_sitter_config::Config;
 use tree_sitter_loader as loader;
@@ -78,6 +79,16 @@ fn run() -> Result<()> {
         .long("quiet")
         .short("q");
 
+    let cache_arg = Arg::with_name("cache")
+        .help("Reuse syntax trees from previous runs that are stored in an on-disk cache")
+        .long("cache");
+
+    let cache_size_arg = Arg::with_name("cache-size")
+        .help("The maximum size of the parse cache, in megabytes")
+        .long("cache-size")
+        .takes_value(true)
+        .requires("cache");
+
     let matches = App::new("tree-sitter")
         .author("Max Brunsfeld <maxbrunsfeld@gmail.com>")
         .about("Generates and tests parsers")
@@ -107,6 +118,11 @@ fn run() -> Result<()> {
                             tree_sitter::LANGUAGE_VERSION,
                         )),
                 )
+                .arg(
+                    Arg::with_name("lex-tables")
+                        .long("lex-tables")
+                        .help("Generate table-driven lexers instead of lexing functions"),
+                )
                 .arg(Arg::with_name("no-bindings").long("no-bindings"))
                 .arg(
                     Arg::with_name("build")
@@ -148,9 +164,17 @@ fn run() -> Result<()> {
                 .arg(&debug_graph_arg)
                 .arg(Arg::with_name("output-dot").long("dot"))
                 .arg(Arg::with_name("output-xml").long("xml").short("x"))
+                .arg(
+                    Arg::with_name("trace")
+                        .help("Record a compact trace of the parser's actions in the given file")
+                        .long("trace")
+                        .takes_value(true),
+                )
                 .arg(
                     Arg::with_name("stat")
-                        .help("Show parsing statistic")
+                        .help(
+                            "Show parsing statistics, and the parser's work counters for each file",
+                        )
                         .long("stat")
                         .short("s"),
                 )
@@ -162,6 +186,8 @@ fn run() -> Result<()> {
                 )
                 .arg(&time_arg)
                 .arg(&quiet_arg)
+                .arg(&cache_arg)
+                .arg(&cache_size_arg)
                 .arg(
                     Arg::with_name("edits")
                         .help("Apply edits in the format: \"row,col del_count insert_text\"")
@@ -178,6 +204,28 @@ fn run() -> Result<()> {
                         .takes_value(true),
                 ),
         )
+        .subcommand(
+            SubCommand::with_name("decode-trace")
+                .about("Print a trace that was recorded with `parse --trace`")
+                .arg(
+                    Arg::with_name("trace-path")
+                        .help("Path to the trace file")
+                        .index(1)
+                        .required(true),
+                )
+                .arg(
+                    Arg::with_name("path")
+                        .help("The source file that was parsed, used to select the language")
+                        .index(2)
+                        .required(true),
+                )
+                .arg(&scope_arg)
+                .arg(
+                    Arg::with_name("output-dot")
+                        .help("Print a DOT graph of the parse stack versions' states")
+                        .long("dot"),
+                ),
+        )
         .subcommand(
             SubCommand::with_name("query")
                 .alias("q")
@@ -190,6 +238,14 @@ fn run() -> Result<()> {
                 )
                 .arg(&time_arg)
                 .arg(&quiet_arg)
+                .arg(&cache_arg)
+                .arg(&cache_size_arg)
+                .arg(
+                    Arg::with_name("stat")
+                        .help("Show parse cache statistics")
+                        .long("stat")
+                        .short("s"),
+                )
                 .arg(&paths_file_arg)
                 .arg(&paths_arg.clone().index(2))
                 .arg(
@@ -338,11 +394,13 @@ fn run() -> Result<()> {
                     })
                 },
             )?;
+            let use_lex_tables = matches.is_present("lex-tables");
             let generate_bindings = !matches.is_present("no-bindings");
             generate::generate_parser_in_directory(
                 &current_dir,
                 grammar_path,
                 abi_version,
+                use_lex_tables,
                 generate_bindings,
                 report_symbol_name,
                 js_runtime,
@@ -458,11 +516,17 @@ fn run() -> Result<()> {
 
             let should_track_stats = matches.is_present("stat");
             let mut stats = parse::Stats::default();
+            let mut cache = parse_cache_from_args(&matches)?;
 
             for path in paths {
                 let path = Path::new(&path);
                 let language =
                     loader.select_language(path, &current_dir, matches.value_of("scope"))?;
+                if let Some(cache) = &mut cache {
+                    if let Some(grammar_hash) = loader.grammar_hash(language)? {
+                        cache.add_language(language, grammar_hash);
+                    }
+                }
 
                 let opts = ParseFileOptions {
                     language,
@@ -471,11 +535,14 @@ fn run() -> Result<()> {
                     max_path_length,
                     output,
                     print_time: time,
+                    print_parser_stats: should_track_stats,
                     timeout,
                     debug,
                     debug_graph,
+                    trace_path: matches.value_of("trace").map(Path::new),
                     cancellation_flag: Some(&cancellation_flag),
                     encoding,
+                    cache: cache.as_mut(),
                 };
 
                 let this_file_errored = parse::parse_file_at_path(opts)?;
@@ -490,8 +557,15 @@ fn run() -> Result<()> {
                 has_error |= this_file_errored;
             }
 
+            if let Some(cache) = &mut cache {
+                cache.evict()?;
+            }
+
             if should_track_stats {
-                println!("{}", stats)
+                println!("{}", stats);
+                if let Some(cache) = &cache {
+                    println!("{}", cache.stats);
+                }
             }
 
             if has_error {
@@ -499,6 +573,25 @@ fn run() -> Result<()> {
             }
         }
 
+        ("decode-trace", Some(matches)) => {
+            let loader_config = config.get()?;
+            loader.find_all_languages(&loader_config)?;
+            let language = loader.select_language(
+                Path::new(matches.value_of("path").unwrap()),
+                &current_dir,
+                matches.value_of("scope"),
+            )?;
+            let events =
+                trace::read_trace_file(Path::new(matches.value_of("trace-path").unwrap()))?;
+            let stdout = io::stdout();
+            let mut stdout = stdout.lock();
+            if matches.is_present("output-dot") {
+                trace::print_trace_graph(language, &events, &mut stdout)?;
+            } else {
+                trace::print_trace_log(language, &events, &mut stdout)?;
+            }
+        }
+
         ("query", Some(matches)) => {
             let ordered_captures = matches.values_of("captures").is_some();
             let quiet = matches.values_of("quiet").is_some();
@@ -525,6 +618,12 @@ fn run() -> Result<()> {
                 Some(Point::new(start, 0)..Point::new(end, 0))
             });
             let should_test = matches.is_present("test");
+            let mut cache = parse_cache_from_args(&matches)?;
+            if let Some(cache) = &mut cache {
+                if let Some(grammar_hash) = loader.grammar_hash(language)? {
+                    cache.add_language(language, grammar_hash);
+                }
+            }
             query::query_files_at_paths(
                 language,
                 paths,
@@ -535,7 +634,14 @@ fn run() -> Result<()> {
                 should_test,
                 quiet,
                 time,
+                cache.as_mut(),
             )?;
+            if let Some(cache) = &mut cache {
+                cache.evict()?;
+                if matches.is_present("stat") {
+                    println!("{}", cache.stats);
+                }
+            }
         }
 
         ("tags", Some(matches)) => {
@@ -737,3 +843,19 @@ fn collect_paths<'a>(
 
     Err(anyhow!("Must provide one or more paths"))
 }
+
+fn parse_cache_from_args(matches: &ArgMatches) -> Result<Option<ParseCache>> {
+    if !matches.is_present("cache") {
+        return Ok(None);
+    }
+    let max_size_mb = match matches.value_of("cache-size") {
+        Some(size) => size
+            .parse::<u64>()
+            .with_context(|| format!("Invalid cache size {:?}", size))?,
+        None => parse_cache::DEFAULT_MAX_SIZE_MB,
+    };
+    Ok(Some(ParseCache::new(
+        ParseCache::default_directory()?,
+        max_size_mb * 1024 * 1024,
+    )))
+}
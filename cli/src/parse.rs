@@ -1,11 +1,14 @@
-use super::util;
+use super::parse_cache::ParseCache;
+use super::{trace, util};
 use anyhow::{anyhow, Context, Result};
 use std::io::{self, Write};
 use std::path::Path;
 use std::sync::atomic::AtomicUsize;
 use std::time::Instant;
 use std::{fmt, fs, usize};
-use tree_sitter::{ffi, InputEdit, Language, LogType, Parser, Point, Tree};
+use tree_sitter::{
+    ffi, InputEdit, Language, LogType, Parser, ParserStats, Point, SexpOptions, Tree,
+};
 
 #[derive(Debug)]
 pub struct Edit {
@@ -45,14 +48,17 @@ pub struct ParseFileOptions<'a> {
     pub max_path_length: usize,
     pub output: ParseOutput,
     pub print_time: bool,
+    pub print_parser_stats: bool,
     pub timeout: u64,
     pub debug: bool,
     pub debug_graph: bool,
+    pub trace_path: Option<&'a Path>,
     pub cancellation_flag: Option<&'a AtomicUsize>,
     pub encoding: Option<u32>,
+    pub cache: Option<&'a mut ParseCache>,
 }
 
-pub fn parse_file_at_path(opts: ParseFileOptions) -> Result<bool> {
+pub fn parse_file_at_path(mut opts: ParseFileOptions) -> Result<bool> {
     let mut _log_session = None;
     let mut parser = Parser::new();
     parser.set_language(opts.language)?;
@@ -80,6 +86,11 @@ pub fn parse_file_at_path(opts: ParseFileOptions) -> Result<bool> {
         })));
     }
 
+    // Record a trace of the parser's actions if `--trace` was passed.
+    if opts.trace_path.is_some() {
+        parser.start_tracing(trace::TRACE_CAPACITY);
+    }
+
     let time = Instant::now();
 
     #[inline(always)]
@@ -102,7 +113,26 @@ pub fn parse_file_at_path(opts: ParseFileOptions) -> Result<bool> {
                 .collect::<Vec<_>>();
             parser.parse_utf16(&source_code_utf16, None)
         }
-        _ => parser.parse(&source_code, None),
+        _ => {
+            // When the parser's own output is requested, always parse the file.
+            let cache = opts
+                .cache
+                .take()
+                .filter(|_| !opts.debug && !opts.debug_graph && opts.trace_path.is_none());
+            match cache {
+                Some(cache) => match cache.get(opts.language, &source_code) {
+                    Some(tree) => Some(tree),
+                    None => {
+                        let tree = parser.parse(&source_code, None);
+                        if let Some(tree) = &tree {
+                            cache.insert(opts.language, &source_code, tree)?;
+                        }
+                        tree
+                    }
+                },
+                None => parser.parse(&source_code, None),
+            }
+        }
     };
 
     let stdout = io::stdout();
@@ -128,113 +158,17 @@ pub fn parse_file_at_path(opts: ParseFileOptions) -> Result<bool> {
         let mut cursor = tree.walk();
 
         if matches!(opts.output, ParseOutput::Normal) {
-            let mut needs_newline = false;
-            let mut indent_level = 0;
-            let mut did_visit_children = false;
-            loop {
-                let node = cursor.node();
-                let is_named = node.is_named();
-                if did_visit_children {
-                    if is_named {
-                        stdout.write(b")")?;
-                        needs_newline = true;
-                    }
-                    if cursor.goto_next_sibling() {
-                        did_visit_children = false;
-                    } else if cursor.goto_parent() {
-                        did_visit_children = true;
-                        indent_level -= 1;
-                    } else {
-                        break;
-                    }
-                } else {
-                    if is_named {
-                        if needs_newline {
-                            stdout.write(b"\n")?;
-                        }
-                        for _ in 0..indent_level {
-                            stdout.write(b"  ")?;
-                        }
-                        let start = node.start_position();
-                        let end = node.end_position();
-                        if let Some(field_name) = cursor.field_name() {
-                            write!(&mut stdout, "{}: ", field_name)?;
-                        }
-                        write!(
-                            &mut stdout,
-                            "({} [{}, {}] - [{}, {}]",
-                            node.kind(),
-                            start.row,
-                            start.column,
-                            end.row,
-                            end.column
-                        )?;
-                        needs_newline = true;
-                    }
-                    if cursor.goto_first_child() {
-                        did_visit_children = false;
-                        indent_level += 1;
-                    } else {
-                        did_visit_children = true;
-                    }
-                }
-            }
-            cursor.reset(tree.root_node());
+            let options = SexpOptions {
+                include_ranges: true,
+                indent: true,
+                node_types: true,
+            };
+            tree.root_node().write_sexp(options, &mut stdout)?;
             println!("");
         }
 
         if matches!(opts.output, ParseOutput::Xml) {
-            let mut needs_newline = false;
-            let mut indent_level = 0;
-            let mut did_visit_children = false;
-            let mut tags: Vec<&str> = Vec::new();
-            loop {
-                let node = cursor.node();
-                let is_named = node.is_named();
-                if did_visit_children {
-                    if is_named {
-                        let tag = tags.pop();
-                        write!(&mut stdout, "</{}>\n", tag.expect("there is a tag"))?;
-                        needs_newline = true;
-                    }
-                    if cursor.goto_next_sibling() {
-                        did_visit_children = false;
-                    } else if cursor.goto_parent() {
-                        did_visit_children = true;
-                        indent_level -= 1;
-                    } else {
-                        break;
-                    }
-                } else {
-                    if is_named {
-                        if needs_newline {
-                            stdout.write(b"\n")?;
-                        }
-                        for _ in 0..indent_level {
-                            stdout.write(b"  ")?;
-                        }
-                        write!(&mut stdout, "<{}", node.kind())?;
-                        if let Some(field_name) = cursor.field_name() {
-                            write!(&mut stdout, " type=\"{}\"", field_name)?;
-                        }
-                        write!(&mut stdout, ">")?;
-                        tags.push(node.kind());
-                        needs_newline = true;
-                    }
-                    if cursor.goto_first_child() {
-                        did_visit_children = false;
-                        indent_level += 1;
-                    } else {
-                        did_visit_children = true;
-                        let start = node.start_byte();
-                        let end = node.end_byte();
-                        let value =
-                            std::str::from_utf8(&source_code[start..end]).expect("has a string");
-                        write!(&mut stdout, "{}", html_escape::encode_text(value))?;
-                    }
-                }
-            }
-            cursor.reset(tree.root_node());
+            tree.root_node().write_xml(&source_code, &mut stdout)?;
             println!("");
         }
 
@@ -293,6 +227,14 @@ pub fn parse_file_at_path(opts: ParseFileOptions) -> Result<bool> {
             write!(&mut stdout, "\n")?;
         }
 
+        if opts.print_parser_stats {
+            write_parser_stats(&mut stdout, &opts, &parser.stats())?;
+        }
+
+        if let Some(trace_path) = opts.trace_path {
+            trace::write_trace_file(trace_path, &parser.trace_events())?;
+        }
+
         return Ok(first_error.is_some());
     } else if opts.print_time {
         let duration = time.elapsed();
@@ -306,9 +248,43 @@ pub fn parse_file_at_path(opts: ParseFileOptions) -> Result<bool> {
         )?;
     }
 
+    if opts.print_parser_stats {
+        write_parser_stats(&mut stdout, &opts, &parser.stats())?;
+    }
+
+    if let Some(trace_path) = opts.trace_path {
+        trace::write_trace_file(trace_path, &parser.trace_events())?;
+    }
+
     Ok(false)
 }
 
+fn write_parser_stats(
+    stdout: &mut impl Write,
+    opts: &ParseFileOptions,
+    stats: &ParserStats,
+) -> Result<()> {
+    writeln!(
+        stdout,
+        "{:width$}\tlexed {} tokens ({} bytes, {} cached); {} shifts; {} reductions; \
+         {} max stack versions; reused {} subtrees ({} bytes); {} recoveries; \
+         {} subtree allocations",
+        opts.path.to_str().unwrap(),
+        stats.lex_count,
+        stats.lexed_byte_count,
+        stats.token_cache_hit_count,
+        stats.shift_count,
+        stats.reduce_count,
+        stats.max_version_count,
+        stats.reused_subtree_count,
+        stats.reused_byte_count,
+        stats.recover_count,
+        stats.subtree_allocation_count,
+        width = opts.max_path_length
+    )?;
+    Ok(())
+}
+
 pub fn perform_edit(tree: &mut Tree, input: &mut Vec<u8>, edit: &Edit) -> InputEdit {
     let start_byte = edit.position;
     let old_end_byte = edit.position + edit.deleted_length;
@@ -0,0 +1,255 @@
+use anyhow::{anyhow, Context, Result};
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
+use std::time::{Duration, SystemTime};
+use std::{env, fmt, fs, io, process};
+use tree_sitter::{Language, Tree};
+use tree_sitter_loader::hash_bytes;
+
+pub const DEFAULT_MAX_SIZE_MB: u64 = 512;
+
+const ENTRY_EXTENSION: &'static str = "tree";
+const TEMP_EXTENSION: &'static str = "tmp";
+
+// The size of the source code digest at the start of each entry.
+const DIGEST_SIZE: usize = 16;
+
+// How old an entry must be before reading it marks it as recently used again.
+const DEFAULT_REFRESH_INTERVAL: Duration = Duration::from_secs(60 * 60);
+
+// How old a temporary file must be before it is assumed to have been left
+// behind by a failed write, rather than being written by another process.
+const DEFAULT_TEMP_FILE_GRACE_PERIOD: Duration = Duration::from_secs(10 * 60);
+
+/// An on-disk cache of serialized syntax trees.
+///
+/// Each entry is addressed by the language's ABI version, a hash of the
+/// grammar that was used to parse it, and a hash of the source file's
+/// contents, so an entry never needs to be invalidated. Instead, unused
+/// entries are evicted once the cache exceeds its size limit.
+///
+/// Because the hash in an entry's name is only 64 bits, each entry also starts
+/// with a 128-bit digest of the source code, which is checked before the tree
+/// is used.
+pub struct ParseCache {
+    directory: PathBuf,
+    max_size: u64,
+    grammar_hashes: HashMap<Language, u64>,
+    /// Entries are evicted in order of their modification times. When an
+    /// entry is read, it is rewritten to update its modification time, but
+    /// only if it was last written longer ago than this interval.
+    pub refresh_interval: Duration,
+    /// Temporary files that haven't been modified for this long are deleted
+    /// during eviction. Newer ones may still be in the middle of being written.
+    pub temp_file_grace_period: Duration,
+    pub stats: CacheStats,
+}
+
+#[derive(Debug, Default)]
+pub struct CacheStats {
+    pub hits: usize,
+    pub misses: usize,
+    pub written_bytes: usize,
+    pub evicted_entries: usize,
+}
+
+impl fmt::Display for CacheStats {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        let lookups = self.hits + self.misses;
+        write!(
+            f,
+            "Parse cache: {} hits; {} misses; hit percentage: {:.2}%; {} bytes written; {} entries evicted",
+            self.hits,
+            self.misses,
+            if lookups > 0 {
+                (self.hits as f64) / (lookups as f64) * 100.0
+            } else {
+                0.0
+            },
+            self.written_bytes,
+            self.evicted_entries
+        )
+    }
+}
+
+impl ParseCache {
+    pub fn new(directory: PathBuf, max_size: u64) -> Self {
+        Self {
+            directory,
+            max_size,
+            grammar_hashes: HashMap::new(),
+            refresh_interval: DEFAULT_REFRESH_INTERVAL,
+            temp_file_grace_period: DEFAULT_TEMP_FILE_GRACE_PERIOD,
+            stats: CacheStats::default(),
+        }
+    }
+
+    pub fn default_directory() -> Result<PathBuf> {
+        match env::var("TREE_SITTER_PARSE_CACHE_DIR") {
+            Ok(path) => Ok(PathBuf::from(path)),
+            _ => Ok(dirs::cache_dir()
+                .ok_or(anyhow!("Cannot determine cache directory"))?
+                .join("tree-sitter")
+                .join("trees")),
+        }
+    }
+
+    /// Record the hash of the grammar that a language was generated from.
+    /// Trees are only cached for languages whose grammar hash is known.
+    pub fn add_language(&mut self, language: Language, grammar_hash: u64) {
+        self.grammar_hashes.insert(language, grammar_hash);
+    }
+
+    /// Load the tree for the given source code from the cache, if it exists.
+    pub fn get(&mut self, language: Language, source: &[u8]) -> Option<Tree> {
+        let path = self.entry_path(language, source)?;
+        let data = fs::read(&path).unwrap_or_default();
+        let tree = if data.len() >= DIGEST_SIZE
+            && data[0..DIGEST_SIZE] == source_digest(source).to_le_bytes()
+        {
+            Tree::deserialize(language, &data[DIGEST_SIZE..])
+        } else {
+            None
+        };
+        if tree.is_some() {
+            self.stats.hits += 1;
+            let is_stale = fs::metadata(&path)
+                .and_then(|metadata| metadata.modified())
+                .ok()
+                .and_then(|modified| modified.elapsed().ok())
+                .map_or(false, |age| age >= self.refresh_interval);
+            if is_stale {
+                write_entry(&path, &data).ok();
+            }
+        } else {
+            self.stats.misses += 1;
+        }
+        tree
+    }
+
+    /// Store the tree for the given source code in the cache.
+    pub fn insert(&mut self, language: Language, source: &[u8], tree: &Tree) -> Result<()> {
+        let path = match self.entry_path(language, source) {
+            Some(path) => path,
+            None => return Ok(()),
+        };
+        fs::create_dir_all(&self.directory)
+            .with_context(|| format!("Failed to create cache directory {:?}", self.directory))?;
+
+        let mut data = source_digest(source).to_le_bytes().to_vec();
+        data.extend(tree.serialize());
+        write_entry(&path, &data)
+            .with_context(|| format!("Failed to write cache entry {:?}", path))?;
+        self.stats.written_bytes += data.len();
+        Ok(())
+    }
+
+    /// Delete the least recently used entries until the cache is no larger than
+    /// its size limit.
+    ///
+    /// Temporary files that were left behind by failed writes are deleted as
+    /// well. Temporary files that were modified within the grace period are
+    /// left alone, and don't count towards the size limit, because another
+    /// process may still be writing them.
+    pub fn evict(&mut self) -> Result<()> {
+        let entries = match fs::read_dir(&self.directory) {
+            Ok(entries) => entries,
+            Err(_) => return Ok(()),
+        };
+
+        let now = SystemTime::now();
+        let mut total_size = 0;
+        let mut stale_temp_paths = Vec::new();
+        let mut entries = entries
+            .filter_map(|entry| {
+                let entry = entry.ok()?;
+                let path = entry.path();
+                let extension = path.extension()?;
+                let metadata = entry.metadata().ok()?;
+                let modified = metadata.modified().ok()?;
+                if extension == TEMP_EXTENSION {
+                    let is_stale = now
+                        .duration_since(modified)
+                        .map_or(false, |age| age >= self.temp_file_grace_period);
+                    if is_stale {
+                        stale_temp_paths.push(path);
+                    }
+                    return None;
+                }
+                if extension != ENTRY_EXTENSION {
+                    return None;
+                }
+                total_size += metadata.len();
+                Some((modified, metadata.len(), path))
+            })
+            .collect::<Vec<_>>();
+
+        for path in stale_temp_paths {
+            if remove_file(&path)? {
+                self.stats.evicted_entries += 1;
+            }
+        }
+        if total_size <= self.max_size {
+            return Ok(());
+        }
+
+        entries.sort_unstable();
+        for (_, size, path) in entries {
+            if total_size <= self.max_size {
+                break;
+            }
+            if remove_file(&path)? {
+                self.stats.evicted_entries += 1;
+            }
+            total_size -= size;
+        }
+        Ok(())
+    }
+
+    fn entry_path(&self, language: Language, source: &[u8]) -> Option<PathBuf> {
+        let grammar_hash = self.grammar_hashes.get(&language)?;
+        let mut path = self.directory.join(format!(
+            "{}-{:016x}-{:016x}-{:x}",
+            language.version(),
+            grammar_hash,
+            hash_bytes(source),
+            source.len()
+        ));
+        path.set_extension(ENTRY_EXTENSION);
+        Some(path)
+    }
+}
+
+// Remove a file from the cache, returning false if it was already removed,
+// which happens when several processes evict entries at the same time.
+fn remove_file(path: &Path) -> Result<bool> {
+    match fs::remove_file(path) {
+        Ok(()) => Ok(true),
+        Err(error) if error.kind() == io::ErrorKind::NotFound => Ok(false),
+        Err(error) => {
+            Err(error).with_context(|| format!("Failed to remove cache entry {:?}", path))
+        }
+    }
+}
+
+// Write an entry to a temporary file first, and then move it into place, so
+// that other processes that are using the same cache never read a
+// partially-written entry.
+fn write_entry(path: &Path, data: &[u8]) -> io::Result<()> {
+    let temp_path = path.with_extension(format!("{}.{}", process::id(), TEMP_EXTENSION));
+    let result = fs::write(&temp_path, data).and_then(|_| fs::rename(&temp_path, path));
+    if result.is_err() {
+        fs::remove_file(&temp_path).ok();
+    }
+    result
+}
+
+// A 128-bit FNV-1a hash, which is stable across compiler versions, and is
+// much less likely to collide than the hash in an entry's name.
+fn source_digest(bytes: &[u8]) -> u128 {
+    bytes
+        .iter()
+        .fold(0x6c62272e07bb014262b821756295c58d, |hash, byte| {
+            (hash ^ *byte as u128).wrapping_mul(0x1000000000000000000013b)
+        })
+}
@@ -1,3 +1,4 @@
+use crate::parse_cache::ParseCache;
 use crate::query_testing;
 use anyhow::{Context, Result};
 use std::{
@@ -19,6 +20,7 @@ pub fn query_files_at_paths(
     should_test: bool,
     quiet: bool,
     print_time: bool,
+    mut cache: Option<&mut ParseCache>,
 ) -> Result<()> {
     let stdout = io::stdout();
     let mut stdout = stdout.lock();
@@ -45,7 +47,17 @@ pub fn query_files_at_paths(
 
         let source_code =
             fs::read(&path).with_context(|| format!("Error reading source file {:?}", path))?;
-        let tree = parser.parse(&source_code, None).unwrap();
+        let tree = match cache.as_deref_mut() {
+            Some(cache) => match cache.get(language, &source_code) {
+                Some(tree) => tree,
+                None => {
+                    let tree = parser.parse(&source_code, None).unwrap();
+                    cache.insert(language, &source_code, &tree)?;
+                    tree
+                }
+            },
+            None => parser.parse(&source_code, None).unwrap(),
+        };
 
         let start = Instant::now();
         if ordered_captures {
@@ -69,6 +69,10 @@ pub fn record<T>(f: impl FnOnce() -> T) -> T {
     value
 }
 
+pub fn outstanding_allocation_count() -> usize {
+    RECORDER.with(|recorder| recorder.outstanding_allocations.lock().unwrap().len())
+}
+
 fn record_alloc(ptr: *mut c_void) {
     RECORDER.with(|recorder| {
         if recorder.enabled.load(SeqCst) {
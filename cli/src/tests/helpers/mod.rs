@@ -20,6 +20,8 @@ lazy_static! {
     pub static ref START_SEED: usize = new_seed();
     pub static ref EDIT_COUNT: usize = int_env_var("TREE_SITTER_EDITS").unwrap_or(3);
     pub static ref ITERATION_COUNT: usize = int_env_var("TREE_SITTER_ITERATIONS").unwrap_or(10);
+    pub static ref STREAM_BYTE_COUNT: usize =
+        int_env_var("TREE_SITTER_STREAM_BYTES").unwrap_or(4 * 1024 * 1024);
 }
 
 fn int_env_var(name: &'static str) -> Option<usize> {
@@ -1,4 +1,5 @@
-use super::helpers::fixtures::get_language;
+use super::helpers::fixtures::{get_language, get_test_language};
+use crate::generate::{generate_parser_for_grammar, generate_parser_for_grammar_with_abi_version};
 use tree_sitter::Parser;
 
 #[test]
@@ -40,6 +41,126 @@ fn test_lookahead_iterator() {
         .eq(expected_symbols));
 }
 
+#[test]
+fn test_parse_table_lookups_match_previous_abi_version() {
+    let grammar = r##"
+        {
+            "name": "test_small_parse_states",
+            "extras": [{ "type": "PATTERN", "value": "\\s" }],
+            "rules": {
+                "program": { "type": "REPEAT", "content": { "type": "SYMBOL", "name": "statement" } },
+                "statement": {
+                    "type": "SEQ",
+                    "members": [
+                        { "type": "SYMBOL", "name": "expression" },
+                        { "type": "STRING", "value": ";" }
+                    ]
+                },
+                "expression": {
+                    "type": "CHOICE",
+                    "members": [
+                        { "type": "SYMBOL", "name": "identifier" },
+                        { "type": "SYMBOL", "name": "number" },
+                        { "type": "SYMBOL", "name": "call" },
+                        { "type": "SYMBOL", "name": "binary" },
+                        {
+                            "type": "SEQ",
+                            "members": [
+                                { "type": "STRING", "value": "(" },
+                                { "type": "SYMBOL", "name": "expression" },
+                                { "type": "STRING", "value": ")" }
+                            ]
+                        }
+                    ]
+                },
+                "call": {
+                    "type": "PREC",
+                    "value": 3,
+                    "content": {
+                        "type": "SEQ",
+                        "members": [
+                            { "type": "SYMBOL", "name": "identifier" },
+                            { "type": "STRING", "value": "(" },
+                            { "type": "SYMBOL", "name": "expression" },
+                            { "type": "STRING", "value": ")" }
+                        ]
+                    }
+                },
+                "binary": {
+                    "type": "CHOICE",
+                    "members": [
+                        {
+                            "type": "PREC_LEFT",
+                            "value": 1,
+                            "content": {
+                                "type": "SEQ",
+                                "members": [
+                                    { "type": "SYMBOL", "name": "expression" },
+                                    { "type": "CHOICE", "members": [
+                                        { "type": "STRING", "value": "+" },
+                                        { "type": "STRING", "value": "-" }
+                                    ] },
+                                    { "type": "SYMBOL", "name": "expression" }
+                                ]
+                            }
+                        },
+                        {
+                            "type": "PREC_LEFT",
+                            "value": 2,
+                            "content": {
+                                "type": "SEQ",
+                                "members": [
+                                    { "type": "SYMBOL", "name": "expression" },
+                                    { "type": "CHOICE", "members": [
+                                        { "type": "STRING", "value": "*" },
+                                        { "type": "STRING", "value": "/" }
+                                    ] },
+                                    { "type": "SYMBOL", "name": "expression" }
+                                ]
+                            }
+                        }
+                    ]
+                },
+                "identifier": { "type": "PATTERN", "value": "[a-z]+" },
+                "number": { "type": "PATTERN", "value": "\\d+" }
+            }
+        }
+    "##;
+
+    let (parser_name, parser_code) = generate_parser_for_grammar(grammar).unwrap();
+    let (old_parser_name, old_parser_code) = generate_parser_for_grammar_with_abi_version(
+        &grammar.replace(&parser_name, &format!("{}_abi_14", parser_name)),
+        14,
+    )
+    .unwrap();
+    assert!(parser_code.contains("ts_small_parse_table_masks"));
+    assert!(!old_parser_code.contains("ts_small_parse_table_masks"));
+
+    let language = get_test_language(&parser_name, &parser_code, None);
+    let old_language = get_test_language(&old_parser_name, &old_parser_code, None);
+    assert_eq!(
+        language.parse_state_count(),
+        old_language.parse_state_count()
+    );
+    assert_eq!(language.node_kind_count(), old_language.node_kind_count());
+
+    for state in 1..language.parse_state_count() as u16 {
+        for symbol in 0..language.node_kind_count() as u16 {
+            assert_eq!(
+                language.next_state(state, symbol),
+                old_language.next_state(state, symbol),
+                "state {}, symbol {}",
+                state,
+                symbol
+            );
+        }
+        assert!(language
+            .lookahead_iterator(state)
+            .unwrap()
+            .eq(old_language.lookahead_iterator(state).unwrap()));
+    }
+}
+
 #[test]
 fn test_lookahead_iterator_modifiable_only_by_mut() {
     let mut parser = Parser::new();
@@ -4,7 +4,7 @@ use super::helpers::random::Rand;
 use crate::generate::generate_parser_for_grammar;
 use crate::parse::perform_edit;
 use std::fs;
-use tree_sitter::{Node, Parser, Point, Tree};
+use tree_sitter::{Node, Parser, Point, SexpOptions, Tree};
 
 const JSON_EXAMPLE: &'static str = r#"
 
@@ -248,6 +248,81 @@ fn test_node_parent_of_child_by_field_name() {
     );
 }
 
+#[test]
+fn test_node_parent_and_siblings_with_parent_cache() {
+    let mut parser = Parser::new();
+    parser.set_language(get_language("javascript")).unwrap();
+    let source = "let x = foo(a, b\nif (c) { d(); } else e(\nfunction f() { return [1, 2,\n}";
+    let tree = parser.parse(source, None).unwrap();
+
+    let summarize = |node: Option<Node>| node.map(|node| (node.kind(), node.byte_range()));
+    let navigate = |node: Node| {
+        (
+            summarize(node.parent()),
+            summarize(node.next_sibling()),
+            summarize(node.prev_sibling()),
+            summarize(node.next_named_sibling()),
+            summarize(node.prev_named_sibling()),
+        )
+    };
+
+    let expected = get_all_nodes(&tree)
+        .into_iter()
+        .map(navigate)
+        .collect::<Vec<_>>();
+
+    // Indexing the tree's parents must not change the results. Indexing them
+    // again has no effect.
+    for _ in 0..2 {
+        tree.index_parents();
+        for (i, node) in get_all_nodes(&tree).into_iter().enumerate() {
+            assert_eq!(navigate(node), expected[i]);
+            for child in node.children(&mut node.walk()) {
+                assert_eq!(child.parent(), Some(node));
+            }
+        }
+    }
+}
+
+#[test]
+fn test_node_child_access_within_wide_nodes() {
+    let mut parser = Parser::new();
+    parser.set_language(get_language("javascript")).unwrap();
+
+    // Error recovery skips these tokens, which can produce nodes with many
+    // children, for which random access to children is indexed.
+    let source = format!("let x = ({}", "a ) ] b , ; ".repeat(100));
+    let tree = parser.parse(&source, None).unwrap();
+    let node = get_all_nodes(&tree)
+        .into_iter()
+        .max_by_key(|node| node.child_count())
+        .unwrap();
+    assert!(node.child_count() >= 64);
+
+    let children = node.children(&mut node.walk()).collect::<Vec<_>>();
+    let named_children = node.named_children(&mut node.walk()).collect::<Vec<_>>();
+    for _ in 0..2 {
+        for (i, child) in children.iter().enumerate() {
+            assert_eq!(node.child(i), Some(*child));
+        }
+        for (i, child) in named_children.iter().enumerate() {
+            assert_eq!(node.named_child(i), Some(*child));
+        }
+        assert_eq!(node.child(children.len()), None);
+        assert_eq!(node.named_child(named_children.len()), None);
+
+        for child in children
+            .iter()
+            .filter(|child| child.end_byte() > child.start_byte())
+        {
+            let descendant = node
+                .descendant_for_byte_range(child.start_byte(), child.end_byte())
+                .unwrap();
+            assert_eq!(descendant.byte_range(), child.byte_range());
+        }
+    }
+}
+
 #[test]
 fn test_node_field_name_for_child() {
     let mut parser = Parser::new();
@@ -633,6 +708,237 @@ fn test_node_sexp() {
     assert_eq!(identifier_node.to_sexp(), "(identifier)");
 }
 
+#[test]
+fn test_node_write_sexp() {
+    let mut parser = Parser::new();
+    parser.set_language(get_language("javascript")).unwrap();
+    let source = "{a: null};\n";
+    let tree = parser.parse(source, None).unwrap();
+    let root_node = tree.root_node();
+
+    let write_sexp = |node: Node, options: SexpOptions| {
+        let mut output = Vec::new();
+        node.write_sexp(options, &mut output).unwrap();
+        String::from_utf8(output).unwrap()
+    };
+
+    let mut cursor = tree.walk();
+    loop {
+        let node = cursor.node();
+        assert_eq!(write_sexp(node, SexpOptions::default()), node.to_sexp());
+        if !cursor.goto_first_child() {
+            while !cursor.goto_next_sibling() {
+                if !cursor.goto_parent() {
+                    break;
+                }
+            }
+            if cursor.node() == root_node {
+                break;
+            }
+        }
+    }
+
+    let options = SexpOptions {
+        include_ranges: true,
+        indent: true,
+        node_types: false,
+    };
+    assert_eq!(
+        write_sexp(root_node, options),
+        concat!(
+            "(program [0, 0] - [1, 0]\n",
+            "  (expression_statement [0, 0] - [0, 10]\n",
+            "    (object [0, 0] - [0, 9]\n",
+            "      (pair [0, 1] - [0, 8]\n",
+            "        key: (property_identifier [0, 1] - [0, 2])\n",
+            "        value: (null [0, 4] - [0, 8])))))",
+        )
+    );
+
+    let pair_node = root_node.named_descendant_for_byte_range(3, 3).unwrap();
+    let options = SexpOptions {
+        include_ranges: true,
+        indent: false,
+        node_types: false,
+    };
+    assert_eq!(pair_node.kind(), "pair");
+    assert_eq!(
+        write_sexp(pair_node, options),
+        "(pair [0, 1] - [0, 8] key: (property_identifier [0, 1] - [0, 2]) value: (null [0, 4] - [0, 8]))"
+    );
+
+    // Errors from the output stop the writing and are returned.
+    struct FailingOutput(usize);
+    impl std::io::Write for FailingOutput {
+        fn write(&mut self, _: &[u8]) -> std::io::Result<usize> {
+            self.0 += 1;
+            Err(std::io::Error::new(std::io::ErrorKind::Other, "full"))
+        }
+        fn flush(&mut self) -> std::io::Result<()> {
+            Ok(())
+        }
+    }
+    let mut output = FailingOutput(0);
+    let error = root_node
+        .write_sexp(SexpOptions::default(), &mut output)
+        .unwrap_err();
+    assert_eq!(error.to_string(), "full");
+    assert_eq!(output.0, 1);
+}
+
+#[test]
+fn test_node_write_sexp_with_node_types() {
+    let mut parser = Parser::new();
+    parser.set_language(get_language("javascript")).unwrap();
+    let options = SexpOptions {
+        include_ranges: false,
+        indent: false,
+        node_types: true,
+    };
+
+    // Error tokens are written with their kind, instead of as `UNEXPECTED`.
+    let tree = parser.parse(b"var \0 something;", None).unwrap();
+    let mut output = Vec::new();
+    tree.root_node().write_sexp(options, &mut output).unwrap();
+    assert_eq!(
+        String::from_utf8(output).unwrap(),
+        "(program (variable_declaration (ERROR (ERROR)) (variable_declarator name: (identifier))))"
+    );
+
+    // With ranges and indentation, the output is the same as that of a tree
+    // cursor visiting the named nodes.
+    let options = SexpOptions {
+        include_ranges: true,
+        indent: true,
+        node_types: true,
+    };
+    for source in [
+        "{a: null};\nb < c;\n",
+        "var \0 something;",
+        "function a(b {\n  return c\n}\n",
+        "if (a) { b(c, d; }\nclass E extends { f() {} }\n",
+        "const g = `h ${i} j`;\n// k\nl = /m+/g;\n",
+    ] {
+        let tree = parser.parse(source, None).unwrap();
+        let mut output = Vec::new();
+        tree.root_node().write_sexp(options, &mut output).unwrap();
+        assert_eq!(
+            String::from_utf8(output).unwrap(),
+            cursor_sexp(&tree),
+            "source: {source:?}"
+        );
+    }
+}
+
+#[test]
+fn test_node_write_xml() {
+    let mut parser = Parser::new();
+    parser.set_language(get_language("javascript")).unwrap();
+    let source = "{a: null};\nb < c;\n";
+    let tree = parser.parse(source, None).unwrap();
+
+    let mut output = Vec::new();
+    tree.root_node()
+        .write_xml(source.as_bytes(), &mut output)
+        .unwrap();
+    assert_eq!(
+        String::from_utf8(output).unwrap(),
+        concat!(
+            "<program>\n",
+            "  <expression_statement>\n",
+            "    <object>{\n",
+            "      <pair>\n",
+            "        <property_identifier type=\"key\">a</property_identifier>\n",
+            ":\n",
+            "        <null type=\"value\">null</null>\n",
+            "</pair>\n",
+            "}</object>\n",
+            ";</expression_statement>\n",
+            "\n",
+            "  <expression_statement>\n",
+            "    <binary_expression>\n",
+            "      <identifier type=\"left\">b</identifier>\n",
+            "&lt;\n",
+            "      <identifier type=\"right\">c</identifier>\n",
+            "</binary_expression>\n",
+            ";</expression_statement>\n",
+            "</program>\n",
+        )
+    );
+
+    for source in [
+        "var \0 something;",
+        "function a(b {\n  return c\n}\n",
+        "if (a) { b(c, d; }\nclass E extends { f() {} }\n",
+        "const g = `h ${i} j`;\n// k\nl = /m+/g;\n",
+    ] {
+        let tree = parser.parse(source, None).unwrap();
+        let mut output = Vec::new();
+        tree.root_node()
+            .write_xml(source.as_bytes(), &mut output)
+            .unwrap();
+        assert_eq!(
+            String::from_utf8(output).unwrap(),
+            cursor_xml(&tree, source.as_bytes()),
+            "source: {source:?}"
+        );
+    }
+}
+
+#[test]
+fn test_node_write_xml_with_hidden_tokens() {
+    let (parser_name, parser_code) = generate_parser_for_grammar(
+        r#"
+        {
+            "name": "test_grammar_with_hidden_tokens",
+            "extras": [
+                {"type": "PATTERN", "value": "\\s+"}
+            ],
+            "rules": {
+                "list": {
+                    "type": "REPEAT",
+                    "content": {"type": "SYMBOL", "name": "item"}
+                },
+                "item": {
+                    "type": "SEQ",
+                    "members": [
+                        {"type": "SYMBOL", "name": "_word"},
+                        {"type": "SYMBOL", "name": "_word"}
+                    ]
+                },
+                "_word": {"type": "PATTERN", "value": "[a-z]+"}
+            }
+        }
+        "#,
+    )
+    .unwrap();
+
+    let mut parser = Parser::new();
+    parser
+        .set_language(get_test_language(&parser_name, &parser_code, None))
+        .unwrap();
+
+    // The text between a node's hidden tokens is written along with them.
+    let source = "ab  cd\nef\tgh";
+    let tree = parser.parse(source, None).unwrap();
+    let mut output = Vec::new();
+    tree.root_node()
+        .write_xml(source.as_bytes(), &mut output)
+        .unwrap();
+    let output = String::from_utf8(output).unwrap();
+    assert_eq!(
+        output,
+        concat!(
+            "<list>\n",
+            "  <item>ab  cd</item>\n",
+            "\n",
+            "  <item>ef\tgh</item>\n",
+            "</list>\n",
+        )
+    );
+    assert_eq!(output, cursor_xml(&tree, source.as_bytes()));
+}
+
 #[test]
 fn test_node_field_names() {
     let (parser_name, parser_code) = generate_parser_for_grammar(
@@ -901,6 +1207,102 @@ fn get_all_nodes(tree: &Tree) -> Vec<Node> {
     return result;
 }
 
+// Write the named nodes of a tree, with their ranges, one per line, by
+// walking the tree with a cursor.
+fn cursor_sexp(tree: &Tree) -> String {
+    let mut result = String::new();
+    let mut cursor = tree.walk();
+    let mut depth = 0;
+    let mut visited_children = false;
+    loop {
+        let node = cursor.node();
+        if visited_children {
+            if node.is_named() {
+                result += ")";
+            }
+            if cursor.goto_next_sibling() {
+                visited_children = false;
+            } else if cursor.goto_parent() {
+                depth -= 1;
+            } else {
+                break;
+            }
+        } else {
+            if node.is_named() {
+                if !result.is_empty() {
+                    result += "\n";
+                }
+                result += &"  ".repeat(depth);
+                if let Some(field_name) = cursor.field_name() {
+                    result += &format!("{field_name}: ");
+                }
+                let (start, end) = (node.start_position(), node.end_position());
+                result += &format!(
+                    "({} [{}, {}] - [{}, {}]",
+                    node.kind(),
+                    start.row,
+                    start.column,
+                    end.row,
+                    end.column
+                );
+            }
+            if cursor.goto_first_child() {
+                depth += 1;
+            } else {
+                visited_children = true;
+            }
+        }
+    }
+    result
+}
+
+// Write the named nodes of a tree as XML elements, and the text of the nodes
+// without children, by walking the tree with a cursor.
+fn cursor_xml(tree: &Tree, source: &[u8]) -> String {
+    let mut result = String::new();
+    let mut cursor = tree.walk();
+    let mut depth = 0;
+    let mut visited_children = false;
+    loop {
+        let node = cursor.node();
+        if visited_children {
+            if node.is_named() {
+                result += &format!("</{}>\n", node.kind());
+            }
+            if cursor.goto_next_sibling() {
+                visited_children = false;
+            } else if cursor.goto_parent() {
+                depth -= 1;
+            } else {
+                break;
+            }
+        } else {
+            if node.is_named() {
+                if !result.is_empty() {
+                    result += "\n";
+                }
+                result += &"  ".repeat(depth);
+                result += &format!("<{}", node.kind());
+                if let Some(field_name) = cursor.field_name() {
+                    result += &format!(" type=\"{field_name}\"");
+                }
+                result += ">";
+            }
+            if cursor.goto_first_child() {
+                depth += 1;
+            } else {
+                visited_children = true;
+                let text = node.utf8_text(source).unwrap();
+                result += &text
+                    .replace('&', "&amp;")
+                    .replace('<', "&lt;")
+                    .replace('>', "&gt;");
+            }
+        }
+    }
+    result
+}
+
 fn parse_json_example() -> Tree {
     let mut parser = Parser::new();
     parser.set_language(get_language("json")).unwrap();
@@ -0,0 +1,208 @@
+use super::helpers::fixtures::get_language;
+use crate::parse_cache::ParseCache;
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::thread;
+use std::time::{Duration, SystemTime};
+use tree_sitter::{Language, Parser, Tree};
+
+const SOURCES: &[&str] = &[
+    "let a = 1;\n",
+    "function b(c) { return c + 1; }\n",
+    "class D { e() { return [f, g]; } }\n",
+];
+
+#[test]
+fn test_parse_cache_hits_and_misses() {
+    let directory = tempfile::tempdir().unwrap();
+    let language = get_language("javascript");
+    let mut cache = ParseCache::new(directory.path().to_owned(), u64::MAX);
+    let source = SOURCES[0].as_bytes();
+    let tree = parse(language, source);
+
+    // Trees aren't cached for languages whose grammar hash is unknown.
+    cache.insert(language, source, &tree).unwrap();
+    assert!(cache.get(language, source).is_none());
+    assert!(entry_paths(directory.path()).is_empty());
+    assert_eq!((cache.stats.hits, cache.stats.misses), (0, 0));
+
+    cache.add_language(language, 1);
+    assert!(cache.get(language, source).is_none());
+    assert_eq!((cache.stats.hits, cache.stats.misses), (0, 1));
+
+    cache.insert(language, source, &tree).unwrap();
+    let path = entry_paths(directory.path()).pop().unwrap();
+    let written_time = modified_time(&path);
+    let cached_tree = cache.get(language, source).unwrap();
+    assert_eq!(
+        cached_tree.root_node().to_sexp(),
+        tree.root_node().to_sexp()
+    );
+    assert_eq!((cache.stats.hits, cache.stats.misses), (1, 1));
+    assert_eq!(entry_paths(directory.path()).len(), 1);
+
+    // Recently written entries aren't rewritten when they are read.
+    assert_eq!(modified_time(&path), written_time);
+
+    // Entries are specific to the source code and to the grammar.
+    assert!(cache.get(language, b"let b = 1;\n").is_none());
+    cache.add_language(language, 2);
+    assert!(cache.get(language, source).is_none());
+    assert_eq!((cache.stats.hits, cache.stats.misses), (1, 3));
+}
+
+#[test]
+fn test_parse_cache_checks_the_source_digest() {
+    let directory = tempfile::tempdir().unwrap();
+    let language = get_language("javascript");
+    let mut cache = ParseCache::new(directory.path().to_owned(), u64::MAX);
+    cache.add_language(language, 1);
+
+    let source = SOURCES[0].as_bytes();
+    cache
+        .insert(language, source, &parse(language, source))
+        .unwrap();
+    let path = entry_paths(directory.path()).pop().unwrap();
+
+    // Simulate a collision between the hashes in the entries' names, by
+    // storing the entry for some other source code in this entry's place.
+    let other_source = SOURCES[1].as_bytes();
+    cache
+        .insert(language, other_source, &parse(language, other_source))
+        .unwrap();
+    let other_path = entry_paths(directory.path())
+        .into_iter()
+        .find(|p| *p != path)
+        .unwrap();
+    fs::copy(&other_path, &path).unwrap();
+    assert!(cache.get(language, source).is_none());
+    assert!(cache.get(language, other_source).is_some());
+
+    // Truncated entries are ignored.
+    fs::write(&path, &fs::read(&other_path).unwrap()[0..4]).unwrap();
+    assert!(cache.get(language, source).is_none());
+}
+
+#[test]
+fn test_parse_cache_evicts_least_recently_used_entries() {
+    let directory = tempfile::tempdir().unwrap();
+    let language = get_language("javascript");
+    let mut cache = ParseCache::new(directory.path().to_owned(), u64::MAX);
+    cache.add_language(language, 1);
+    cache.refresh_interval = Duration::ZERO;
+
+    // Insert the entries from oldest to newest.
+    let mut paths = Vec::new();
+    for source in SOURCES {
+        let source = source.as_bytes();
+        cache
+            .insert(language, source, &parse(language, source))
+            .unwrap();
+        let path = entry_paths(directory.path())
+            .into_iter()
+            .find(|p| !paths.contains(p))
+            .unwrap();
+        wait_for_later_modified_time(&path);
+        paths.push(path);
+    }
+
+    // Nothing is evicted while the cache is within its size limit.
+    let total_size = paths.iter().map(|p| file_size(p)).sum::<u64>();
+    cache.evict().unwrap();
+    assert_eq!(entry_paths(directory.path()).len(), 3);
+
+    // Reading the oldest entry makes it the most recently used one.
+    assert!(cache.get(language, SOURCES[0].as_bytes()).is_some());
+    assert!(modified_time(&paths[0]) > modified_time(&paths[2]));
+    let mut cache = ParseCache::new(
+        directory.path().to_owned(),
+        total_size - file_size(&paths[1]),
+    );
+    cache.add_language(language, 1);
+    cache.evict().unwrap();
+    assert_eq!(cache.stats.evicted_entries, 1);
+    assert!(cache.get(language, SOURCES[0].as_bytes()).is_some());
+    assert!(cache.get(language, SOURCES[1].as_bytes()).is_none());
+    assert!(cache.get(language, SOURCES[2].as_bytes()).is_some());
+
+    // Once the size limit is exceeded, entries are evicted until the cache is
+    // back within it, not until it is empty.
+    let mut cache = ParseCache::new(directory.path().to_owned(), file_size(&paths[0]));
+    cache.add_language(language, 1);
+    cache.evict().unwrap();
+    assert_eq!(cache.stats.evicted_entries, 1);
+    assert_eq!(entry_paths(directory.path()), vec![paths[0].clone()]);
+}
+
+#[test]
+fn test_parse_cache_evicts_stale_temporary_files() {
+    let directory = tempfile::tempdir().unwrap();
+    let language = get_language("javascript");
+    let source = SOURCES[0].as_bytes();
+    let mut cache = ParseCache::new(directory.path().to_owned(), u64::MAX);
+    cache.add_language(language, 1);
+    cache
+        .insert(language, source, &parse(language, source))
+        .unwrap();
+    let entry_path = entry_paths(directory.path()).pop().unwrap();
+
+    let temp_path = directory.path().join("entry.1234.tmp");
+    fs::write(&temp_path, "partially written").unwrap();
+    let other_path = directory.path().join("README");
+    fs::write(&other_path, "not part of the cache").unwrap();
+
+    // Recent temporary files may still be being written by other processes,
+    // so they are neither deleted nor counted towards the size limit.
+    let mut cache = ParseCache::new(directory.path().to_owned(), file_size(&entry_path));
+    cache.evict().unwrap();
+    assert_eq!(cache.stats.evicted_entries, 0);
+    assert!(temp_path.exists());
+    assert!(entry_path.exists());
+
+    // Once they are older than the grace period, they are deleted, even if the
+    // cache is within its size limit.
+    cache.temp_file_grace_period = Duration::ZERO;
+    cache.evict().unwrap();
+    assert_eq!(cache.stats.evicted_entries, 1);
+    assert!(!temp_path.exists());
+    assert!(entry_path.exists());
+    assert!(other_path.exists());
+}
+
+fn parse(language: Language, source: &[u8]) -> Tree {
+    let mut parser = Parser::new();
+    parser.set_language(language).unwrap();
+    parser.parse(source, None).unwrap()
+}
+
+fn entry_paths(directory: &Path) -> Vec<PathBuf> {
+    let mut result = fs::read_dir(directory)
+        .unwrap()
+        .map(|entry| entry.unwrap().path())
+        .filter(|path| path.extension() == Some("tree".as_ref()))
+        .collect::<Vec<_>>();
+    result.sort();
+    result
+}
+
+fn file_size(path: &Path) -> u64 {
+    fs::metadata(path).unwrap().len()
+}
+
+fn modified_time(path: &Path) -> SystemTime {
+    fs::metadata(path).unwrap().modified().unwrap()
+}
+
+// Wait until files that are written afterwards have later modification times
+// than the given file, even on file systems with coarse timestamps.
+fn wait_for_later_modified_time(path: &Path) {
+    let probe_path = path.with_extension("probe");
+    loop {
+        thread::sleep(Duration::from_millis(10));
+        fs::write(&probe_path, "").unwrap();
+        if modified_time(&probe_path) > modified_time(path) {
+            break;
+        }
+    }
+    fs::remove_file(&probe_path).unwrap();
+}
@@ -3,16 +3,24 @@ use super::helpers::{
     edits::invert_edit,
     edits::ReadRecorder,
     fixtures::{get_language, get_test_grammar, get_test_language},
+    STREAM_BYTE_COUNT,
 };
 use crate::{
-    generate::generate_parser_for_grammar,
+    generate::{
+        generate_parser_for_grammar, generate_parser_for_grammar_with_abi_version,
+        generate_parser_for_grammar_with_lex_tables,
+    },
     parse::{perform_edit, Edit},
 };
 use std::{
+    cell::Cell,
     sync::atomic::{AtomicUsize, Ordering},
     thread, time,
 };
-use tree_sitter::{IncludedRangesError, InputEdit, LogType, Parser, Point, Range};
+use tree_sitter::{
+    IncludedRangesError, InputEdit, LogType, Node, ParseStep, Parser, ParserPool, Point, Range,
+    TraceEventType,
+};
 use tree_sitter_proc_macro::retry;
 
 #[test]
@@ -212,6 +220,48 @@ fn test_parsing_with_callback_returning_owned_strings() {
     );
 }
 
+#[test]
+fn test_parsing_contiguous_text_matches_parsing_chunked_text() {
+    let mut parser = Parser::new();
+    parser.set_language(get_language("javascript")).unwrap();
+
+    let text = "const ñame = 'café';\n\tlet x = `€${ñame}😀`; // ∂\r\nfoo(x);\n";
+
+    // The contiguous text is read directly by the lexer, while the chunks,
+    // which split some multi-byte characters, are read through the callback.
+    let contiguous_tree = parser.parse(text, None).unwrap();
+    let chunked_tree = parser
+        .parse_with(
+            &mut |i, _| &text.as_bytes()[i.min(text.len())..(i + 3).min(text.len())],
+            None,
+        )
+        .unwrap();
+
+    fn leaves(node: Node, result: &mut Vec<(std::ops::Range<usize>, Point, Point)>) {
+        if node.child_count() == 0 {
+            result.push((
+                node.byte_range(),
+                node.start_position(),
+                node.end_position(),
+            ));
+        }
+        for i in 0..node.child_count() {
+            leaves(node.child(i).unwrap(), result);
+        }
+    }
+
+    let mut contiguous_leaves = Vec::new();
+    let mut chunked_leaves = Vec::new();
+    leaves(contiguous_tree.root_node(), &mut contiguous_leaves);
+    leaves(chunked_tree.root_node(), &mut chunked_leaves);
+    assert_eq!(contiguous_leaves, chunked_leaves);
+    assert_eq!(
+        contiguous_tree.root_node().to_sexp(),
+        chunked_tree.root_node().to_sexp()
+    );
+    assert!(!contiguous_tree.root_node().has_error());
+}
+
 #[test]
 fn test_parsing_text_with_byte_order_mark() {
     let mut parser = Parser::new();
@@ -538,6 +588,65 @@ fn test_parsing_after_detecting_error_in_the_middle_of_a_string_token() {
     assert_eq!(tree3.root_node().to_sexp(), tree.root_node().to_sexp(),);
 }
 
+#[test]
+fn test_parsing_with_arena_allocation() {
+    allocations::record(|| {
+        let mut parser = Parser::new();
+        parser.set_language(get_language("python")).unwrap();
+        assert!(!parser.arena_allocation());
+        parser.set_arena_allocation(true);
+        assert!(parser.arena_allocation());
+
+        let mut source =
+            b"def a():\n    b = [1, 2]\n    if b:\n        return c(b)\n\nclass D:\n    pass\n"
+                .to_vec();
+        let tree = parser.parse(&source, None).unwrap();
+        let tree_copy = tree.clone();
+        let original_sexp = tree.root_node().to_sexp();
+
+        // Edit a copy of the arena-allocated tree, and reuse it to parse the new
+        // source code, both with and without arena allocation.
+        let edit = Edit {
+            position: std::str::from_utf8(&source).unwrap().find("2]").unwrap(),
+            deleted_length: 1,
+            inserted_text: b"3, 4".to_vec(),
+        };
+        let undo = invert_edit(&source, &edit);
+        let mut edited_tree = tree.clone();
+        perform_edit(&mut edited_tree, &mut source, &edit);
+        let arena_tree = parser.parse(&source, Some(&edited_tree)).unwrap();
+        parser.set_arena_allocation(false);
+        let heap_tree = parser.parse(&source, Some(&edited_tree)).unwrap();
+        let fresh_tree = parser.parse(&source, None).unwrap();
+
+        // The new trees share nodes with the old trees, and must remain valid
+        // after the old trees are dropped.
+        drop(tree);
+        drop(edited_tree);
+        assert_eq!(
+            arena_tree.root_node().to_sexp(),
+            fresh_tree.root_node().to_sexp()
+        );
+        assert_eq!(
+            heap_tree.root_node().to_sexp(),
+            fresh_tree.root_node().to_sexp()
+        );
+        assert_eq!(tree_copy.root_node().to_sexp(), original_sexp);
+
+        // Undo the edit, reusing the tree that was produced by the incremental
+        // arena-allocated parse.
+        parser.set_arena_allocation(true);
+        let mut reverted_tree = arena_tree.clone();
+        perform_edit(&mut reverted_tree, &mut source, &undo);
+        let reverted_tree = parser.parse(&source, Some(&reverted_tree)).unwrap();
+        drop(arena_tree);
+        drop(heap_tree);
+        assert_eq!(reverted_tree.root_node().to_sexp(), original_sexp);
+        drop(tree_copy);
+        assert_eq!(reverted_tree.root_node().to_sexp(), original_sexp);
+    });
+}
+
 // Thread safety
 
 #[test]
@@ -591,6 +700,93 @@ fn test_parsing_on_multiple_threads() {
     assert_eq!(child_count_differences, &[1, 2, 3, 4]);
 }
 
+#[test]
+fn test_parsing_in_parallel() {
+    // Generate a document that is large enough to be split into several chunks,
+    // with values that span multiple lines.
+    let mut source = String::from("[\n");
+    for i in 0..20000 {
+        source += &format!("  {{\"id\": {}, \"tags\": [\"a\",\n    \"b\"]}},\n", i);
+    }
+    source += "  null\n]\n";
+
+    let mut parser = Parser::new();
+    parser.set_language(get_language("json")).unwrap();
+    let tree = parser.parse(&source, None).unwrap();
+    let parallel_tree = parser.parse_parallel(&source, 4).unwrap();
+    assert!(!parallel_tree.root_node().has_error());
+    assert_eq!(
+        parallel_tree.root_node().to_sexp(),
+        tree.root_node().to_sexp()
+    );
+
+    let array = tree.root_node().child(0).unwrap();
+    let parallel_array = parallel_tree.root_node().child(0).unwrap();
+    let mut cursor = array.walk();
+    let mut parallel_cursor = parallel_array.walk();
+    for (child, parallel_child) in array
+        .children(&mut cursor)
+        .zip(parallel_array.children(&mut parallel_cursor))
+    {
+        assert_eq!(child.byte_range(), parallel_child.byte_range());
+        assert_eq!(child.start_position(), parallel_child.start_position());
+        assert_eq!(child.end_position(), parallel_child.end_position());
+    }
+
+    // Syntax errors are handled the same way as when parsing on one thread.
+    source.replace_range(source.len() / 2..source.len() / 2 + 1, "]");
+    let tree = parser.parse(&source, None).unwrap();
+    let parallel_tree = parser.parse_parallel(&source, 4).unwrap();
+    assert!(parallel_tree.root_node().has_error());
+    assert_eq!(
+        parallel_tree.root_node().to_sexp(),
+        tree.root_node().to_sexp()
+    );
+}
+
+#[test]
+fn test_parsing_with_a_parser_pool() {
+    let pool = ParserPool::new(3);
+    let documents = (0..30)
+        .map(|i| match i % 3 {
+            0 => (get_language("json"), format!("[{}]", "1, ".repeat(i) + "2")),
+            1 => (
+                get_language("javascript"),
+                format!("let x{} = y * {};", i, i),
+            ),
+            _ => (get_language("rust"), format!("fn f{}() {{ g({}); }}", i, i)),
+        })
+        .collect::<Vec<_>>();
+
+    let jobs = documents
+        .iter()
+        .map(|(language, source)| pool.parse(*language, source.clone(), None))
+        .collect::<Vec<_>>();
+
+    let mut parser = Parser::new();
+    for ((language, source), job) in documents.iter().zip(jobs) {
+        parser.set_language(*language).unwrap();
+        let tree = parser.parse(source, None).unwrap();
+        assert_eq!(
+            job.wait().unwrap().root_node().to_sexp(),
+            tree.root_node().to_sexp()
+        );
+    }
+
+    // Parse jobs can be cancelled.
+    let long_document = format!("[{}0]", "0, ".repeat(1_000_000));
+    let job = pool.parse(get_language("json"), long_document, None);
+    job.cancel();
+    assert!(job.wait().is_none());
+
+    // The pool can still be used after a job has been cancelled.
+    let job = pool.parse(get_language("json"), "[null]", None);
+    assert_eq!(
+        job.wait().unwrap().root_node().to_sexp(),
+        "(document (array (null)))"
+    );
+}
+
 #[test]
 fn test_parsing_cancelled_by_another_thread() {
     let cancellation_flag = std::sync::Arc::new(AtomicUsize::new(0));
@@ -811,6 +1007,344 @@ fn test_parsing_with_timeout_and_no_completion() {
     });
 }
 
+#[test]
+fn test_parsing_in_steps() {
+    allocations::record(|| {
+        let mut parser = Parser::new();
+        parser.set_language(get_language("javascript")).unwrap();
+
+        let source = "const a = [1, 2, 3];\nfunction b(c) { return c * 2; }\n".repeat(50);
+        let expected_tree = parser.parse(&source, None).unwrap();
+
+        // Each step makes progress, until the parse is complete.
+        let mut step_count = 0;
+        let mut progress = Vec::new();
+        let tree = loop {
+            step_count += 1;
+            match parser.parse_step(&source, None, 10).unwrap() {
+                ParseStep::Complete(tree) => break tree,
+                ParseStep::Incomplete(progress_bytes) => progress.push(progress_bytes),
+            }
+        };
+        assert!(step_count > 100);
+        assert!(progress.windows(2).all(|pair| pair[0] <= pair[1]));
+        assert!(progress.last().unwrap() <= &source.len());
+        assert_eq!(
+            tree.root_node().to_sexp(),
+            expected_tree.root_node().to_sexp()
+        );
+
+        // An unfinished parse can be abandoned.
+        assert!(matches!(
+            parser.parse_step(&source, None, 10),
+            Some(ParseStep::Incomplete(_))
+        ));
+        parser.reset();
+        let tree = loop {
+            if let ParseStep::Complete(tree) = parser.parse_step("[1]", None, 10).unwrap() {
+                break tree;
+            }
+        };
+        assert_eq!(
+            tree.root_node().to_sexp(),
+            "(program (expression_statement (array (number))))"
+        );
+
+        // Parsing without a language fails.
+        let mut parser = Parser::new();
+        assert!(parser.parse_step(&source, None, 10).is_none());
+    });
+}
+
+#[test]
+#[retry(10)]
+fn test_parsing_many_documents() {
+    allocations::record(|| {
+        let mut parser = Parser::new();
+        parser.set_language(get_language("json")).unwrap();
+
+        let documents = ["[1, 2]", "{\"a\": null}", "[", "true"];
+        let sexps = parser
+            .parse_many(&documents)
+            .map(|(tree, _)| tree.unwrap().root_node().to_sexp())
+            .collect::<Vec<_>>();
+        for (document, sexp) in documents.iter().zip(sexps) {
+            let tree = parser.parse(document, None).unwrap();
+            assert_eq!(sexp, tree.root_node().to_sexp());
+        }
+
+        // The documents are parsed in batches, and the trees are yielded in
+        // the same order as the documents.
+        let documents = (0..100).map(|i| format!("[{i}]")).collect::<Vec<_>>();
+        let sexps = parser
+            .parse_many(&documents)
+            .map(|(tree, _)| tree.unwrap().root_node().to_sexp())
+            .collect::<Vec<_>>();
+        assert_eq!(sexps.len(), documents.len());
+        for (document, sexp) in documents.iter().zip(sexps) {
+            let tree = parser.parse(document, None).unwrap();
+            assert_eq!(sexp, tree.root_node().to_sexp());
+        }
+
+        // When a document's parse times out, it is skipped, and the next
+        // document is parsed from the beginning.
+        let long_document = format!("[{}0]", "0, ".repeat(10000));
+        parser.set_timeout_micros(5);
+        let sexps = parser
+            .parse_many(&[long_document.as_str(), "[null]"])
+            .map(|(tree, _)| tree.map(|tree| tree.root_node().to_sexp()))
+            .collect::<Vec<_>>();
+        assert_eq!(
+            sexps,
+            &[None, Some("(document (array (null)))".to_string())]
+        );
+    });
+}
+
+#[test]
+fn test_parsing_reuses_tokens_lexed_by_other_stack_versions() {
+    let mut parser = Parser::new();
+    parser.set_language(get_language("javascript")).unwrap();
+
+    // The parameter list of an arrow function is ambiguous with a parenthesized
+    // expression until the arrow is reached, so two stack versions lex the same
+    // tokens.
+    let source_code = "let f = (alpha, beta, gamma) => alpha;\n".repeat(10);
+    let tree = parser.parse(&source_code, None).unwrap();
+    assert!(!tree.root_node().has_error());
+    let stats = parser.stats();
+    assert!(stats.token_cache_hit_count > 0);
+    assert!(stats.token_cache_miss_count > 0);
+
+    // The counters only describe the most recent parse.
+    parser.parse("alpha;", None).unwrap();
+    let new_stats = parser.stats();
+    assert!(new_stats.token_cache_miss_count > 0);
+    assert!(new_stats.token_cache_miss_count < stats.token_cache_miss_count);
+}
+
+#[test]
+fn test_parsing_stats() {
+    let mut parser = Parser::new();
+    parser.set_language(get_language("javascript")).unwrap();
+
+    let mut source_code = b"let f = (alpha, beta) => alpha;\nlet g = [1, 2, 3];\n".repeat(10);
+    let mut tree = parser.parse(&source_code, None).unwrap();
+    let stats = parser.stats();
+    assert!(stats.lex_count > 0);
+    assert!(stats.lexed_byte_count >= source_code.len());
+    assert!(stats.shift_count > 0);
+    assert!(stats.reduce_count > 0);
+    assert!(stats.max_version_count > 1);
+    assert!(stats.subtree_allocation_count > 0);
+    assert_eq!(stats.reused_subtree_count, 0);
+    assert_eq!(stats.reused_byte_count, 0);
+    assert_eq!(stats.recover_count, 0);
+
+    // After an edit, most of the old tree is reused, and much less lexing
+    // is needed.
+    let position = source_code.len() - 4;
+    perform_edit(
+        &mut tree,
+        &mut source_code,
+        &Edit {
+            position,
+            deleted_length: 1,
+            inserted_text: b"4".to_vec(),
+        },
+    );
+    parser.parse(&source_code, Some(&tree)).unwrap();
+    let new_stats = parser.stats();
+    assert!(new_stats.reused_subtree_count > 0);
+    assert!(new_stats.reused_byte_count > source_code.len() / 2);
+    assert!(new_stats.lex_count < stats.lex_count / 2);
+
+    // Errors cause the parser to attempt recovery.
+    parser.parse("let f = (alpha, => alpha;", None).unwrap();
+    assert!(parser.stats().recover_count > 0);
+}
+
+#[test]
+fn test_parsing_with_a_trace() {
+    let mut parser = Parser::new();
+    parser.set_language(get_language("javascript")).unwrap();
+
+    parser.start_tracing(1024);
+    parser.parse("let x = [1, 2];", None).unwrap();
+    let events = parser.trace_events();
+    assert_eq!(events.first().unwrap().event_type, TraceEventType::NewParse);
+    assert_eq!(events.last().unwrap().event_type, TraceEventType::Done);
+    assert!(events
+        .iter()
+        .any(|event| event.event_type == TraceEventType::Accept));
+
+    let shifted_kinds = events
+        .iter()
+        .filter(|event| event.event_type == TraceEventType::Shift)
+        .map(|event| parser.language().unwrap().node_kind_for_id(event.symbol))
+        .collect::<Vec<_>>();
+    assert_eq!(
+        shifted_kinds,
+        &[
+            Some("let"),
+            Some("identifier"),
+            Some("="),
+            Some("["),
+            Some("number"),
+            Some(","),
+            Some("number"),
+            Some("]"),
+            Some(";"),
+        ]
+    );
+
+    // When the buffer is full, only the most recent events are kept.
+    parser.start_tracing(4);
+    parser.parse("let x = [1, 2];", None).unwrap();
+    let recent_events = parser.trace_events();
+    assert_eq!(recent_events.len(), 4);
+    assert_eq!(recent_events, &events[events.len() - 4..]);
+
+    parser.stop_tracing();
+    parser.parse("let x = [1, 2];", None).unwrap();
+    assert!(parser.trace_events().is_empty());
+}
+
+#[test]
+fn test_parsing_with_a_node_stream() {
+    let mut parser = Parser::new();
+    parser.set_language(get_language("javascript")).unwrap();
+
+    let source_code = "let a = 1;\nfunction b() { return a; }\n// c\nclass D {}\n".repeat(20);
+
+    // Record each streamed node, along with how much of the input had been
+    // read when it was streamed.
+    let bytes_read = Cell::new(0);
+    let mut streamed_nodes = Vec::new();
+    parser.set_node_stream(Some(Box::new(|node| {
+        streamed_nodes.push((node.to_sexp(), node.byte_range(), bytes_read.get()));
+    })));
+    let tree = parser
+        .parse_with(
+            &mut |offset, _| {
+                let end = source_code.len().min(offset + 16);
+                bytes_read.set(bytes_read.get().max(end));
+                &source_code.as_bytes()[offset.min(end)..end]
+            },
+            None,
+        )
+        .unwrap();
+    parser.set_node_stream(None);
+
+    // The streamed nodes are the children of the root node.
+    let mut cursor = tree.walk();
+    let children = tree
+        .root_node()
+        .children(&mut cursor)
+        .map(|child| (child.to_sexp(), child.byte_range()))
+        .collect::<Vec<_>>();
+    assert_eq!(children.len(), 80);
+    assert_eq!(
+        streamed_nodes
+            .iter()
+            .map(|(sexp, range, _)| (sexp.clone(), range.clone()))
+            .collect::<Vec<_>>(),
+        children
+    );
+
+    // Most of the nodes were streamed long before the end of the input was read.
+    assert!(streamed_nodes[0].2 < source_code.len() / 4);
+    assert!(streamed_nodes[60].2 < source_code.len());
+
+    // Nodes are streamed exactly once, even when there are syntax errors.
+    let mut streamed_kinds = Vec::new();
+    parser.set_node_stream(Some(Box::new(|node| streamed_kinds.push(node.kind()))));
+    let source_code = "let a = 1;\nclass { )\nlet b = 2;\nfunction c() {}\n(";
+    let tree = parser.parse(source_code, None).unwrap();
+    parser.set_node_stream(None);
+    let mut cursor = tree.walk();
+    assert_eq!(
+        streamed_kinds,
+        tree.root_node()
+            .children(&mut cursor)
+            .map(|child| child.kind())
+            .collect::<Vec<_>>()
+    );
+}
+
+#[test]
+fn test_parsing_an_unbounded_stream_in_bounded_memory() {
+    // Set TREE_SITTER_STREAM_BYTES to run this on a larger input, such as a
+    // gigabyte of records.
+    let record = b"{\"id\": 1, \"tags\": [\"a\", \"b\"], \"point\": {\"x\": 1.5, \"y\": null}}\n";
+    let record_count = *STREAM_BYTE_COUNT / record.len();
+    let byte_count = record_count * record.len();
+
+    allocations::record(|| {
+        let mut parser = Parser::new();
+        parser.set_language(get_language("json")).unwrap();
+        parser.set_discard_streamed_nodes(true);
+
+        // After each record is streamed, sample the number of allocations that
+        // the parser is holding.
+        let mut streamed_count = 0;
+        let mut allocation_counts = Vec::with_capacity(record_count);
+        parser.set_node_stream(Some(Box::new(|node| {
+            assert_eq!(node.kind(), "object");
+            assert_eq!(node.start_byte(), streamed_count * record.len());
+            streamed_count += 1;
+            allocation_counts.push(allocations::outstanding_allocation_count());
+        })));
+        let tree = parser
+            .parse_with(
+                &mut |offset, _| {
+                    if offset < byte_count {
+                        &record[offset % record.len()..]
+                    } else {
+                        &[]
+                    }
+                },
+                None,
+            )
+            .unwrap();
+        parser.set_node_stream(None);
+
+        assert_eq!(streamed_count, record_count);
+        assert_eq!(tree.root_node().end_byte(), byte_count);
+        assert!(tree.root_node().child_count() <= 1);
+
+        // Once the parser has warmed up, its memory usage doesn't grow.
+        let warm_up_count = record_count / 10;
+        let warm_allocation_count = allocation_counts[..warm_up_count].iter().max().unwrap();
+        assert!(allocation_counts[warm_up_count..]
+            .iter()
+            .all(|count| count <= warm_allocation_count));
+    });
+}
+
+#[test]
+fn test_parsing_deeply_nested_ambiguous_code() {
+    allocations::record(|| {
+        let mut parser = Parser::new();
+        parser.set_language(get_language("javascript")).unwrap();
+
+        // Until the `=` is reached, each bracket could begin either an array or
+        // an array pattern, so the stack forks and merges at every level.
+        let depth = 500;
+        let source_code = format!("{}a{} = b;", "[".repeat(depth), "]".repeat(depth));
+        for _ in 0..2 {
+            let tree = parser.parse(&source_code, None).unwrap();
+            let assignment = tree.root_node().child(0).unwrap().child(0).unwrap();
+            assert!(!tree.root_node().has_error());
+            assert_eq!(assignment.kind(), "assignment_expression");
+            assert_eq!(
+                assignment.child_by_field_name("left").unwrap().kind(),
+                "array_pattern"
+            );
+        }
+    });
+}
+
 // Included Ranges
 
 #[test]
@@ -1303,6 +1837,210 @@ fn test_parsing_with_included_ranges_and_missing_tokens() {
     assert_eq!(root.child(3).unwrap().start_byte(), 4);
 }
 
+#[test]
+fn test_parsing_with_lex_states_that_advance_over_character_sets() {
+    let grammar = r##"
+        {
+            "name": "test_advance_while_in_set",
+            "rules": {
+                "source_file": { "type": "REPEAT", "content": { "type": "SYMBOL", "name": "_item" } },
+                "_item": {
+                    "type": "CHOICE",
+                    "members": [
+                        { "type": "SYMBOL", "name": "identifier" },
+                        { "type": "SYMBOL", "name": "number" },
+                        { "type": "SYMBOL", "name": "comment" }
+                    ]
+                },
+                "identifier": { "type": "PATTERN", "value": "[a-zA-Z_é][a-zA-Z0-9_é]*" },
+                "number": { "type": "PATTERN", "value": "[0-9]+" },
+                "comment": { "type": "PATTERN", "value": "#[^\\n]*" }
+            },
+            "extras": [ { "type": "PATTERN", "value": "\\s" } ]
+        }
+    "##;
+
+    let (parser_name, parser_code) = generate_parser_for_grammar(grammar).unwrap();
+    assert!(parser_code.contains("ADVANCE_WHILE_IN_SET("));
+    assert!(parser_code.contains("SKIP_WHILE_IN_SET("));
+
+    // Older ABI versions step through every character.
+    let (old_parser_name, old_parser_code) = generate_parser_for_grammar_with_abi_version(
+        &grammar.replace(&parser_name, &format!("{}_abi_14", parser_name)),
+        14,
+    )
+    .unwrap();
+    assert!(!old_parser_code.contains("WHILE_IN_SET"));
+
+    let mut old_parser = Parser::new();
+    old_parser
+        .set_language(get_test_language(&old_parser_name, &old_parser_code, None))
+        .unwrap();
+    let mut parser = Parser::new();
+    parser
+        .set_language(get_test_language(&parser_name, &parser_code, None))
+        .unwrap();
+
+    let mut text = String::new();
+    for i in 0..50 {
+        text += &format!("abc_{i}défgh{} 123{i}  # comment {i} é\n", "x".repeat(i));
+        text += &" ".repeat(i);
+        text += "\n\t\n";
+    }
+
+    fn leaves(node: Node, result: &mut Vec<(std::ops::Range<usize>, Point, Point)>) {
+        if node.child_count() == 0 {
+            result.push((
+                node.byte_range(),
+                node.start_position(),
+                node.end_position(),
+            ));
+        }
+        for i in 0..node.child_count() {
+            leaves(node.child(i).unwrap(), result);
+        }
+    }
+
+    let mut expected_leaves = Vec::new();
+    let expected_tree = old_parser.parse(&text, None).unwrap();
+    leaves(expected_tree.root_node(), &mut expected_leaves);
+    assert!(!expected_tree.root_node().has_error());
+
+    // Runs of characters may be split across chunks or included ranges.
+    let mut contiguous_leaves = Vec::new();
+    let mut chunked_leaves = Vec::new();
+    let contiguous_tree = parser.parse(&text, None).unwrap();
+    let chunked_tree = parser
+        .parse_with(
+            &mut |i, _| &text.as_bytes()[i.min(text.len())..(i + 7).min(text.len())],
+            None,
+        )
+        .unwrap();
+    leaves(contiguous_tree.root_node(), &mut contiguous_leaves);
+    leaves(chunked_tree.root_node(), &mut chunked_leaves);
+    assert_eq!(contiguous_leaves, expected_leaves);
+    assert_eq!(chunked_leaves, expected_leaves);
+
+    let point_at = |byte: usize| {
+        let prefix = &text.as_bytes()[..byte];
+        let row = prefix.iter().filter(|&&b| b == b'\n').count();
+        let column = byte
+            - prefix
+                .iter()
+                .rposition(|&b| b == b'\n')
+                .map_or(0, |i| i + 1);
+        Point::new(row, column)
+    };
+    let ranges = [(0, 90), (100, 290), (300, text.len())]
+        .iter()
+        .map(|&(start_byte, end_byte)| Range {
+            start_byte,
+            end_byte,
+            start_point: point_at(start_byte),
+            end_point: point_at(end_byte),
+        })
+        .collect::<Vec<_>>();
+    old_parser.set_included_ranges(&ranges).unwrap();
+    parser.set_included_ranges(&ranges).unwrap();
+    let mut expected_leaves = Vec::new();
+    let mut actual_leaves = Vec::new();
+    leaves(
+        old_parser.parse(&text, None).unwrap().root_node(),
+        &mut expected_leaves,
+    );
+    leaves(
+        parser.parse(&text, None).unwrap().root_node(),
+        &mut actual_leaves,
+    );
+    assert_eq!(actual_leaves, expected_leaves);
+}
+
+#[test]
+fn test_parsing_with_table_driven_lexers() {
+    let grammar = r##"
+        {
+            "name": "test_lex_tables",
+            "word": "identifier",
+            "rules": {
+                "source_file": { "type": "REPEAT", "content": { "type": "SYMBOL", "name": "_item" } },
+                "_item": {
+                    "type": "CHOICE",
+                    "members": [
+                        { "type": "SYMBOL", "name": "identifier" },
+                        { "type": "SYMBOL", "name": "string" },
+                        { "type": "STRING", "value": "if" },
+                        { "type": "STRING", "value": "=>" },
+                        { "type": "STRING", "value": "=" }
+                    ]
+                },
+                "identifier": { "type": "PATTERN", "value": "[\\p{L}_][\\p{L}\\d_]*" },
+                "string": { "type": "PATTERN", "value": "\"([^\"\\\\\\n]|\\\\.)*\"" },
+                "comment": { "type": "PATTERN", "value": "#[^\\n]*" }
+            },
+            "extras": [
+                { "type": "PATTERN", "value": "\\s" },
+                { "type": "SYMBOL", "name": "comment" }
+            ]
+        }
+    "##;
+
+    let (parser_name, parser_code) = generate_parser_for_grammar(grammar).unwrap();
+    let (table_parser_name, table_parser_code) = generate_parser_for_grammar_with_lex_tables(
+        &grammar.replace(&parser_name, &format!("{}_tables", parser_name)),
+    )
+    .unwrap();
+    assert!(table_parser_code.contains("ts_lex_table"));
+    assert!(table_parser_code.contains("ts_lex_keywords_table"));
+    assert!(!table_parser_code.contains("START_LEXER()"));
+
+    let mut parser = Parser::new();
+    parser
+        .set_language(get_test_language(&parser_name, &parser_code, None))
+        .unwrap();
+    let mut table_parser = Parser::new();
+    table_parser
+        .set_language(get_test_language(
+            &table_parser_name,
+            &table_parser_code,
+            None,
+        ))
+        .unwrap();
+
+    for text in [
+        "if iffy = \"a\\\"b\" => ñame # comment\n\tif",
+        "日本 \"unterminated\nif\u{0}x ~ =>= \"\" #",
+        "",
+    ] {
+        let tree = parser.parse(text, None).unwrap();
+        let table_tree = table_parser.parse(text, None).unwrap();
+        let mut cursor = tree.walk();
+        let mut table_cursor = table_tree.walk();
+        loop {
+            let node = cursor.node();
+            let table_node = table_cursor.node();
+            assert_eq!(node.kind(), table_node.kind());
+            assert_eq!(node.byte_range(), table_node.byte_range());
+            assert_eq!(node.start_position(), table_node.start_position());
+            assert_eq!(node.end_position(), table_node.end_position());
+            if cursor.goto_first_child() {
+                assert!(table_cursor.goto_first_child());
+                continue;
+            }
+            while !cursor.goto_next_sibling() {
+                assert!(!table_cursor.goto_next_sibling());
+                if !cursor.goto_parent() {
+                    break;
+                }
+                assert!(table_cursor.goto_parent());
+            }
+            if cursor.node() == tree.root_node() {
+                break;
+            }
+            assert!(table_cursor.goto_next_sibling());
+        }
+    }
+}
+
 #[test]
 fn test_grammars_that_can_hang_on_eof() {
     let (parser_name, parser_code) = generate_parser_for_grammar(
@@ -1,4 +1,4 @@
-use super::helpers::{allocations, fixtures::get_language};
+use super::helpers::{allocations, fixtures::get_language, random::Rand, START_SEED};
 use tree_sitter::Parser;
 
 #[test]
@@ -12,3 +12,50 @@ fn test_pathological_example_1() {
         parser.parse(source, None).unwrap();
     });
 }
+
+#[test]
+fn test_pathological_input_with_a_recovery_budget() {
+    let mut rand = Rand::new(*START_SEED);
+    let mut source = Vec::new();
+    while source.len() < 64 * 1024 {
+        source.extend(rand.words(100));
+        source.push(b'\n');
+    }
+
+    allocations::record(|| {
+        let mut parser = Parser::new();
+        parser.set_language(get_language("javascript")).unwrap();
+        parser.set_recovery_budget(100);
+        assert_eq!(parser.recovery_budget(), 100);
+
+        // Even after the budget is spent, the tree spans the entire input.
+        let tree = parser.parse(&source, None).unwrap();
+        assert!(tree.root_node().has_error());
+        assert_eq!(tree.root_node().end_byte(), source.len());
+        let budget_stats = parser.stats();
+
+        // Without the budget, the parser explores more recoveries, each of
+        // which lexes tokens of its own.
+        parser.set_recovery_budget(0);
+        let unlimited_tree = parser.parse(&source, None).unwrap();
+        assert_eq!(unlimited_tree.root_node().end_byte(), source.len());
+        let unlimited_stats = parser.stats();
+        assert!(
+            budget_stats.lex_count < unlimited_stats.lex_count,
+            "{budget_stats:?} {unlimited_stats:?}"
+        );
+        parser.set_recovery_budget(100);
+
+        // Valid input doesn't require any recovery, so it is parsed the same
+        // way regardless of the budget.
+        let source = "function a(b) { return b + c; }\nconst d = a(1);\n";
+        let tree = parser.parse(source, None).unwrap();
+        parser.set_recovery_budget(0);
+        let unlimited_tree = parser.parse(source, None).unwrap();
+        assert!(!tree.root_node().has_error());
+        assert_eq!(
+            tree.root_node().to_sexp(),
+            unlimited_tree.root_node().to_sexp()
+        );
+    });
+}
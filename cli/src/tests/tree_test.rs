@@ -1,8 +1,12 @@
+use super::helpers::allocations;
 use super::helpers::edits::invert_edit;
 use super::helpers::fixtures::get_language;
 use crate::parse::{perform_edit, Edit};
 use std::str;
-use tree_sitter::{InputEdit, Parser, Point, Range, Tree};
+use tree_sitter::{
+    ExportOptions, InputEdit, Parser, Point, Query, QueryCursor, Range, ReclaimStatus, Tree,
+    TreeCursor,
+};
 
 #[test]
 fn test_tree_edit() {
@@ -520,6 +524,77 @@ fn test_tree_cursor_child_for_point() {
     );
 }
 
+#[test]
+fn test_tree_cursor_next_matching() {
+    let mut parser = Parser::new();
+    let language = get_language("javascript");
+    parser.set_language(language).unwrap();
+    let source = "function a(b) {\n  function c() { d(); }\n}\nfunction e() {}\n";
+    let tree = parser.parse(source, None).unwrap();
+    let identifier = language.id_for_node_kind("identifier", true);
+    let function = language.id_for_node_kind("function_declaration", true);
+    let text = |cursor: &TreeCursor| cursor.node().utf8_text(source.as_bytes()).unwrap();
+
+    let mut cursor = tree.walk();
+    let mut identifiers = Vec::new();
+    while cursor.goto_next_matching(&[identifier], false, false) {
+        assert_eq!(cursor.node().kind(), "identifier");
+        identifiers.push(text(&cursor));
+    }
+    assert_eq!(identifiers, &["a", "b", "c", "d", "e"]);
+
+    // When no match is found, the cursor returns to its original node.
+    assert_eq!(cursor.node(), tree.root_node());
+
+    // Nodes nested within other matches can be skipped.
+    let mut functions = Vec::new();
+    let mut skip_children = false;
+    while cursor.goto_next_matching(&[function], true, skip_children) {
+        functions.push(
+            cursor
+                .node()
+                .child_by_field_name("name")
+                .unwrap()
+                .start_byte(),
+        );
+        skip_children = true;
+    }
+    assert_eq!(
+        functions,
+        &[source.find("a(").unwrap(), source.find("e(").unwrap()]
+    );
+
+    // With no kinds, every node matches, in the same order as a manual walk.
+    let mut expected = Vec::new();
+    let mut walk = tree.walk();
+    'outer: loop {
+        if walk.goto_first_child() {
+            expected.push(walk.node());
+            continue;
+        }
+        while !walk.goto_next_sibling() {
+            if !walk.goto_parent() {
+                break 'outer;
+            }
+        }
+        expected.push(walk.node());
+    }
+    let mut nodes = Vec::new();
+    while cursor.goto_next_matching(&[], false, false) {
+        nodes.push(cursor.node());
+    }
+    assert_eq!(nodes, expected);
+
+    // Only the current node's descendants are searched.
+    let first_function = tree.root_node().child(0).unwrap();
+    let mut cursor = first_function.walk();
+    identifiers.clear();
+    while cursor.goto_next_matching(&[identifier], false, false) {
+        identifiers.push(text(&cursor));
+    }
+    assert_eq!(identifiers, &["a", "b", "c", "d"]);
+}
+
 #[test]
 fn test_tree_node_equality() {
     let mut parser = Parser::new();
@@ -532,6 +607,166 @@ fn test_tree_node_equality() {
     assert_ne!(node1.child(0).unwrap(), node2);
 }
 
+#[test]
+fn test_tree_drop_deferred() {
+    allocations::record(|| {
+        let mut parser = Parser::new();
+        parser.set_language(get_language("json")).unwrap();
+
+        let source = format!(
+            "[{}1]",
+            "{\"a\": [1, 2, \"b\"], \"c\": null},\n".repeat(100)
+        );
+        let tree = parser.parse(&source, None).unwrap();
+        let tree_copy = tree.clone();
+
+        // The tree's nodes are still referenced by the copy.
+        tree.drop_deferred();
+        assert_eq!(tree_sitter::reclaim_step(10), ReclaimStatus::Done);
+        assert_eq!(tree_copy.root_node().named_child_count(), 1);
+
+        // The nodes are freed a few at a time.
+        tree_copy.drop_deferred();
+        let mut step_count = 0;
+        while tree_sitter::reclaim_step(10) == ReclaimStatus::Pending {
+            step_count += 1;
+        }
+        assert!(step_count > 10);
+    });
+}
+
+#[test]
+fn test_tree_serialization() {
+    allocations::record(|| {
+        let mut parser = Parser::new();
+        parser.set_language(get_language("python")).unwrap();
+
+        let mut source = b"class A:\n    def b(self):\n        return c\n\nd = [e, f]\n".to_vec();
+        let tree = parser.parse(&source, None).unwrap();
+        let data = tree.serialize();
+
+        let mut restored = Tree::deserialize(get_language("python"), &data).unwrap();
+        assert_eq!(restored.root_node().to_sexp(), tree.root_node().to_sexp());
+        assert_eq!(restored.included_ranges(), tree.included_ranges());
+        assert_eq!(restored.serialize(), data);
+
+        // The restored tree can be queried.
+        let query = Query::new(get_language("python"), "(identifier) @id").unwrap();
+        let mut cursor = QueryCursor::new();
+        let identifiers = cursor
+            .captures(&query, restored.root_node(), source.as_slice())
+            .map(|(m, i)| m.captures[i].node.utf8_text(&source).unwrap().to_string())
+            .collect::<Vec<_>>();
+        assert_eq!(identifiers, &["A", "b", "self", "c", "d", "e", "f"]);
+
+        // The restored tree can be used for an incremental parse, which
+        // depends on the states of the external scanner being restored.
+        perform_edit(
+            &mut restored,
+            &mut source,
+            &Edit {
+                position: index_of(&source, "c\n"),
+                deleted_length: 1,
+                inserted_text: b"[g]".to_vec(),
+            },
+        );
+        let new_tree = parser.parse(&source, Some(&restored)).unwrap();
+        assert_eq!(
+            new_tree.root_node().to_sexp(),
+            parser.parse(&source, None).unwrap().root_node().to_sexp()
+        );
+
+        // Invalid data is rejected.
+        assert!(Tree::deserialize(get_language("javascript"), &data).is_none());
+        assert!(Tree::deserialize(get_language("python"), &data[0..data.len() - 1]).is_none());
+        assert!(Tree::deserialize(get_language("python"), &data[0..data.len() / 2]).is_none());
+        assert!(Tree::deserialize(get_language("python"), b"").is_none());
+    });
+}
+
+#[test]
+fn test_tree_export() {
+    let mut parser = Parser::new();
+    parser.set_language(get_language("python")).unwrap();
+    let source = "class A:\n    def b(self):\n        return c(d, e=1)\n\nf = [g, h]\n";
+    let tree = parser.parse(source, None).unwrap();
+
+    for named_only in [false, true] {
+        let flat = tree.export(ExportOptions {
+            named_only,
+            max_depth: 0,
+        });
+
+        // The nodes are exported in document order.
+        let mut expected = Vec::new();
+        let mut cursor = tree.walk();
+        loop {
+            let node = cursor.node();
+            if node.is_named() || !named_only {
+                expected.push((
+                    node.kind(),
+                    node.byte_range(),
+                    node.start_position(),
+                    node.end_position(),
+                    cursor.field_name(),
+                ));
+            }
+            if cursor.goto_first_child() || cursor.goto_next_sibling() {
+                continue;
+            }
+            while cursor.goto_parent() && !cursor.goto_next_sibling() {}
+            if cursor.node() == tree.root_node() {
+                break;
+            }
+        }
+        let nodes = flat
+            .nodes()
+            .map(|node| {
+                (
+                    node.kind(),
+                    node.byte_range(),
+                    node.start_position(),
+                    node.end_position(),
+                    node.field_name(),
+                )
+            })
+            .collect::<Vec<_>>();
+        assert_eq!(nodes, expected);
+
+        // The exported nodes are linked to their parents and children.
+        let root = flat.root_node();
+        assert_eq!(root.parent(), None);
+        assert_eq!(
+            root.children().map(|node| node.kind()).collect::<Vec<_>>(),
+            &["class_definition", "expression_statement"]
+        );
+        for node in flat.nodes() {
+            for child in node.children() {
+                assert_eq!(child.parent(), Some(node));
+                assert!(child.index() > node.index());
+            }
+        }
+    }
+
+    // The export can be limited to the nodes near the root.
+    let flat = tree.export(ExportOptions {
+        named_only: true,
+        max_depth: 2,
+    });
+    assert_eq!(
+        flat.nodes().map(|node| node.kind()).collect::<Vec<_>>(),
+        &[
+            "module",
+            "class_definition",
+            "identifier",
+            "block",
+            "expression_statement",
+            "assignment",
+        ]
+    );
+    assert_eq!(flat.parents(), &[u32::MAX, 0, 1, 1, 0, 4]);
+}
+
 #[test]
 fn test_get_changed_ranges() {
     let source_code = b"{a: null};\n".to_vec();
@@ -0,0 +1,239 @@
+use anyhow::{anyhow, Context, Result};
+use std::collections::HashMap;
+use std::fs;
+use std::io::Write;
+use std::path::Path;
+use tree_sitter::{Language, TraceEvent, TraceEventType};
+
+// The number of events that `tree-sitter parse --trace` retains.
+pub const TRACE_CAPACITY: usize = 64 * 1024;
+
+const TRACE_FILE_MAGIC: &[u8; 8] = b"TSTRACE1";
+const TRACE_EVENT_SIZE: usize = 16;
+
+// Write the events to a file, in the same fixed-size layout that the
+// parser uses for its trace buffer.
+pub fn write_trace_file(path: &Path, events: &[TraceEvent]) -> Result<()> {
+    let mut bytes = Vec::with_capacity(TRACE_FILE_MAGIC.len() + events.len() * TRACE_EVENT_SIZE);
+    bytes.extend_from_slice(TRACE_FILE_MAGIC);
+    for event in events {
+        bytes.extend_from_slice(&(event.event_type as u16).to_le_bytes());
+        bytes.extend_from_slice(&event.state.to_le_bytes());
+        bytes.extend_from_slice(&event.symbol.to_le_bytes());
+        bytes.extend_from_slice(&(event.version as u16).to_le_bytes());
+        bytes.extend_from_slice(&(event.byte as u32).to_le_bytes());
+        bytes.extend_from_slice(&event.value.to_le_bytes());
+    }
+    fs::write(path, bytes).with_context(|| format!("Failed to write trace file {:?}", path))
+}
+
+pub fn read_trace_file(path: &Path) -> Result<Vec<TraceEvent>> {
+    let bytes = fs::read(path).with_context(|| format!("Failed to read trace file {:?}", path))?;
+    if !bytes.starts_with(TRACE_FILE_MAGIC)
+        || (bytes.len() - TRACE_FILE_MAGIC.len()) % TRACE_EVENT_SIZE != 0
+    {
+        return Err(anyhow!("{:?} is not a valid trace file", path));
+    }
+
+    let u16_at = |record: &[u8], i: usize| u16::from_le_bytes([record[i], record[i + 1]]);
+    let u32_at = |record: &[u8], i: usize| {
+        u32::from_le_bytes([record[i], record[i + 1], record[i + 2], record[i + 3]])
+    };
+    bytes[TRACE_FILE_MAGIC.len()..]
+        .chunks_exact(TRACE_EVENT_SIZE)
+        .map(|record| {
+            let event_type = TraceEventType::from_u16(u16_at(record, 0))
+                .ok_or_else(|| anyhow!("Invalid event type in trace file {:?}", path))?;
+            Ok(TraceEvent {
+                event_type,
+                state: u16_at(record, 2),
+                symbol: u16_at(record, 4),
+                version: u16_at(record, 6) as usize,
+                byte: u32_at(record, 8) as usize,
+                value: u32_at(record, 12),
+            })
+        })
+        .collect()
+}
+
+// Print the events in the same format as the parser's log messages. Row and
+// column numbers aren't recorded in the trace, so byte offsets are printed
+// instead.
+pub fn print_trace_log(
+    language: Language,
+    events: &[TraceEvent],
+    out: &mut impl Write,
+) -> Result<()> {
+    for event in events {
+        let symbol = symbol_name(language, event.symbol);
+        match event.event_type {
+            TraceEventType::NewParse => writeln!(out, "new_parse")?,
+            TraceEventType::ParseAfterEdit => writeln!(out, "parse_after_edit")?,
+            TraceEventType::ResumeParsing => writeln!(out, "resume_parsing")?,
+            TraceEventType::ProcessVersion => writeln!(
+                out,
+                "process version:{}, version_count:{}, state:{}, byte:{}",
+                event.version, event.value, event.state, event.byte
+            )?,
+            TraceEventType::LexedLookahead => writeln!(
+                out,
+                "lexed_lookahead sym:{}, size:{}",
+                symbol.escape_default(),
+                event.value
+            )?,
+            TraceEventType::ReuseNode => writeln!(out, "reuse_node symbol:{}", symbol)?,
+            TraceEventType::BreakdownTopOfStack => {
+                writeln!(out, "breakdown_top_of_stack tree:{}", symbol)?
+            }
+            TraceEventType::Shift => writeln!(out, "shift state:{}", event.state)?,
+            TraceEventType::ShiftExtra => writeln!(out, "shift_extra")?,
+            TraceEventType::Reduce => {
+                writeln!(out, "reduce sym:{}, child_count:{}", symbol, event.value)?
+            }
+            TraceEventType::Accept => writeln!(out, "accept")?,
+            TraceEventType::DetectError => writeln!(out, "detect_error")?,
+            TraceEventType::RecoverToPrevious => writeln!(
+                out,
+                "recover_to_previous state:{}, depth:{}",
+                event.state, event.value
+            )?,
+            TraceEventType::RecoverWithMissing => writeln!(
+                out,
+                "recover_with_missing symbol:{}, state:{}",
+                symbol, event.state
+            )?,
+            TraceEventType::RecoverEof => writeln!(out, "recover_eof")?,
+            TraceEventType::SkipToken => writeln!(out, "skip_token symbol:{}", symbol)?,
+            TraceEventType::Resume => writeln!(out, "resume version:{}", event.version)?,
+            TraceEventType::Condense => writeln!(out, "condense")?,
+            TraceEventType::Done => writeln!(out, "done")?,
+        }
+    }
+    Ok(())
+}
+
+// Print a DOT graph of the states that each stack version passed through.
+// Each node is a state that a version was in at a given byte offset, and
+// each edge is labeled with the actions that led from one state to the next.
+// The trace doesn't record the full structure of the stack, so merged
+// versions are not shown.
+pub fn print_trace_graph(
+    language: Language,
+    events: &[TraceEvent],
+    out: &mut impl Write,
+) -> Result<()> {
+    let mut node_count = 0;
+    let mut current_nodes = HashMap::<usize, (usize, u16)>::new();
+    let mut pending_labels = HashMap::<usize, Vec<String>>::new();
+
+    writeln!(out, "digraph trace {{")?;
+    writeln!(out, "rankdir=\"LR\";")?;
+    writeln!(out, "node [shape=box, fontname=\"monospace\"];")?;
+    writeln!(out, "edge [fontname=\"monospace\"];")?;
+
+    let mut add_node = |out: &mut dyn Write,
+                        current_nodes: &mut HashMap<usize, (usize, u16)>,
+                        labels: Vec<String>,
+                        event: &TraceEvent,
+                        byte: usize,
+                        color: &str|
+     -> Result<()> {
+        let id = node_count;
+        node_count += 1;
+        writeln!(
+            out,
+            "node_{} [label=\"version {}\\nstate {}\\nbyte {}\", color={}];",
+            id, event.version, event.state, byte, color
+        )?;
+        if let Some((previous_id, _)) = current_nodes.get(&event.version) {
+            writeln!(
+                out,
+                "node_{} -> node_{} [label=\"{}\"];",
+                previous_id,
+                id,
+                labels.join("\\n")
+            )?;
+        }
+        current_nodes.insert(event.version, (id, event.state));
+        Ok(())
+    };
+
+    for event in events {
+        let symbol = escape_dot_label(symbol_name(language, event.symbol));
+        let labels = pending_labels.entry(event.version).or_default();
+        match event.event_type {
+            TraceEventType::NewParse | TraceEventType::ParseAfterEdit => {
+                current_nodes.clear();
+                pending_labels.clear();
+            }
+            TraceEventType::ProcessVersion | TraceEventType::Resume => {
+                let state_changed = current_nodes
+                    .get(&event.version)
+                    .map_or(true, |(_, state)| *state != event.state);
+                if state_changed {
+                    let labels = pending_labels.remove(&event.version).unwrap_or_default();
+                    add_node(out, &mut current_nodes, labels, event, event.byte, "black")?;
+                }
+            }
+            TraceEventType::Shift | TraceEventType::ShiftExtra => {
+                labels.push(format!("shift {}", symbol));
+                let labels = pending_labels.remove(&event.version).unwrap_or_default();
+                let byte = event.byte + event.value as usize;
+                add_node(out, &mut current_nodes, labels, event, byte, "black")?;
+            }
+            TraceEventType::Reduce => {
+                labels.push(format!("reduce {} ({})", symbol, event.value));
+            }
+            TraceEventType::ReuseNode => labels.push(format!("reuse {}", symbol)),
+            TraceEventType::BreakdownTopOfStack => labels.push(format!("breakdown {}", symbol)),
+            TraceEventType::DetectError => {
+                labels.push(format!("error at {}", symbol));
+                let labels = pending_labels.remove(&event.version).unwrap_or_default();
+                add_node(out, &mut current_nodes, labels, event, event.byte, "red")?;
+            }
+            TraceEventType::RecoverToPrevious
+            | TraceEventType::RecoverWithMissing
+            | TraceEventType::SkipToken => {
+                labels.push(match event.event_type {
+                    TraceEventType::RecoverToPrevious => format!("recover (depth {})", event.value),
+                    TraceEventType::RecoverWithMissing => format!("insert missing {}", symbol),
+                    _ => format!("skip {}", symbol),
+                });
+                let labels = pending_labels.remove(&event.version).unwrap_or_default();
+                add_node(out, &mut current_nodes, labels, event, event.byte, "orange")?;
+            }
+            TraceEventType::Accept => {
+                labels.push("accept".to_string());
+                let labels = pending_labels.remove(&event.version).unwrap_or_default();
+                add_node(out, &mut current_nodes, labels, event, event.byte, "green")?;
+            }
+            TraceEventType::LexedLookahead
+            | TraceEventType::ResumeParsing
+            | TraceEventType::RecoverEof
+            | TraceEventType::Condense
+            | TraceEventType::Done => {}
+        }
+    }
+
+    writeln!(out, "}}")?;
+    Ok(())
+}
+
+fn symbol_name(language: Language, symbol: u16) -> &'static str {
+    language.node_kind_for_id(symbol).unwrap_or("?")
+}
+
+fn escape_dot_label(text: &str) -> String {
+    let mut result = String::with_capacity(text.len());
+    for c in text.chars() {
+        match c {
+            '"' | '\\' => {
+                result.push('\\');
+                result.push(c);
+            }
+            '\n' => result.push_str("\\n"),
+            _ => result.push(c),
+        }
+    }
+    result
+}
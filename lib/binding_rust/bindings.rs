@@ -68,6 +68,14 @@ pub struct TSInput {
     >,
     pub encoding: TSInputEncoding,
 }
+pub const TSParseStatus_TSParseStatusComplete: TSParseStatus = 0;
+pub const TSParseStatus_TSParseStatusIncomplete: TSParseStatus = 1;
+pub const TSParseStatus_TSParseStatusFailed: TSParseStatus = 2;
+pub type TSParseStatus = ::std::os::raw::c_uint;
+pub const TSReclaimStatus_TSReclaimStatusDone: TSReclaimStatus = 0;
+pub const TSReclaimStatus_TSReclaimStatusPending: TSReclaimStatus = 1;
+pub const TSReclaimStatus_TSReclaimStatusBusy: TSReclaimStatus = 2;
+pub type TSReclaimStatus = ::std::os::raw::c_uint;
 pub const TSLogType_TSLogTypeParse: TSLogType = 0;
 pub const TSLogType_TSLogTypeLex: TSLogType = 1;
 pub type TSLogType = ::std::os::raw::c_uint;
@@ -83,6 +91,58 @@ pub struct TSLogger {
         ),
     >,
 }
+pub const TSTraceEventType_TSTraceEventTypeNewParse: TSTraceEventType = 0;
+pub const TSTraceEventType_TSTraceEventTypeParseAfterEdit: TSTraceEventType = 1;
+pub const TSTraceEventType_TSTraceEventTypeResumeParsing: TSTraceEventType = 2;
+pub const TSTraceEventType_TSTraceEventTypeProcessVersion: TSTraceEventType = 3;
+pub const TSTraceEventType_TSTraceEventTypeLexedLookahead: TSTraceEventType = 4;
+pub const TSTraceEventType_TSTraceEventTypeReuseNode: TSTraceEventType = 5;
+pub const TSTraceEventType_TSTraceEventTypeBreakdownTopOfStack: TSTraceEventType = 6;
+pub const TSTraceEventType_TSTraceEventTypeShift: TSTraceEventType = 7;
+pub const TSTraceEventType_TSTraceEventTypeShiftExtra: TSTraceEventType = 8;
+pub const TSTraceEventType_TSTraceEventTypeReduce: TSTraceEventType = 9;
+pub const TSTraceEventType_TSTraceEventTypeAccept: TSTraceEventType = 10;
+pub const TSTraceEventType_TSTraceEventTypeDetectError: TSTraceEventType = 11;
+pub const TSTraceEventType_TSTraceEventTypeRecoverToPrevious: TSTraceEventType = 12;
+pub const TSTraceEventType_TSTraceEventTypeRecoverWithMissing: TSTraceEventType = 13;
+pub const TSTraceEventType_TSTraceEventTypeRecoverEof: TSTraceEventType = 14;
+pub const TSTraceEventType_TSTraceEventTypeSkipToken: TSTraceEventType = 15;
+pub const TSTraceEventType_TSTraceEventTypeResume: TSTraceEventType = 16;
+pub const TSTraceEventType_TSTraceEventTypeCondense: TSTraceEventType = 17;
+pub const TSTraceEventType_TSTraceEventTypeDone: TSTraceEventType = 18;
+pub type TSTraceEventType = ::std::os::raw::c_uint;
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct TSTraceEvent {
+    pub type_: u16,
+    pub state: TSStateId,
+    pub symbol: TSSymbol,
+    pub version: u16,
+    pub byte: u32,
+    pub value: u32,
+}
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct TSTraceBuffer {
+    pub events: *mut TSTraceEvent,
+    pub capacity: u32,
+    pub event_count: u64,
+}
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct TSParserStats {
+    pub lex_count: u32,
+    pub lexed_byte_count: u32,
+    pub shift_count: u32,
+    pub reduce_count: u32,
+    pub max_version_count: u32,
+    pub reused_subtree_count: u32,
+    pub reused_byte_count: u32,
+    pub recover_count: u32,
+    pub subtree_allocation_count: u32,
+    pub token_cache_hit_count: u32,
+    pub token_cache_miss_count: u32,
+}
 #[repr(C)]
 #[derive(Debug, Copy, Clone)]
 pub struct TSInputEdit {
@@ -109,6 +169,63 @@ pub struct TSTreeCursor {
 }
 #[repr(C)]
 #[derive(Debug)]
+pub struct TSNodeStream {
+    pub payload: *mut ::std::os::raw::c_void,
+    pub emit: ::std::option::Option<
+        unsafe extern "C" fn(payload: *mut ::std::os::raw::c_void, node: TSNode),
+    >,
+}
+pub const TSTreeCursorMatchFlag_TSTreeCursorMatchNamed: TSTreeCursorMatchFlag = 1;
+pub const TSTreeCursorMatchFlag_TSTreeCursorMatchSkipChildren: TSTreeCursorMatchFlag = 2;
+pub type TSTreeCursorMatchFlag = ::std::os::raw::c_uint;
+pub const TSFlatNodeFlag_TSFlatNodeFlagNamed: TSFlatNodeFlag = 1;
+pub const TSFlatNodeFlag_TSFlatNodeFlagExtra: TSFlatNodeFlag = 2;
+pub const TSFlatNodeFlag_TSFlatNodeFlagMissing: TSFlatNodeFlag = 4;
+pub const TSFlatNodeFlag_TSFlatNodeFlagHasError: TSFlatNodeFlag = 8;
+pub type TSFlatNodeFlag = ::std::os::raw::c_uint;
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct TSTreeExportOptions {
+    pub named_only: bool,
+    pub max_depth: u32,
+}
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct TSFlatTree {
+    pub capacity: u32,
+    pub node_count: u32,
+    pub symbols: *mut TSSymbol,
+    pub start_bytes: *mut u32,
+    pub end_bytes: *mut u32,
+    pub start_points: *mut TSPoint,
+    pub end_points: *mut TSPoint,
+    pub parents: *mut u32,
+    pub first_children: *mut u32,
+    pub next_siblings: *mut u32,
+    pub field_ids: *mut TSFieldId,
+    pub flags: *mut u8,
+}
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct TSWriter {
+    pub payload: *mut ::std::os::raw::c_void,
+    pub write: ::std::option::Option<
+        unsafe extern "C" fn(
+            payload: *mut ::std::os::raw::c_void,
+            data: *const ::std::os::raw::c_char,
+            length: u32,
+        ) -> bool,
+    >,
+}
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct TSSexpOptions {
+    pub include_ranges: bool,
+    pub indent: bool,
+    pub node_types: bool,
+}
+#[repr(C)]
+#[derive(Debug)]
 pub struct TSQueryCapture {
     pub node: TSNode,
     pub index: u32,
@@ -200,6 +317,49 @@ extern "C" {
         encoding: TSInputEncoding,
     ) -> *mut TSTree;
 }
+extern "C" {
+    #[doc = " Use the parser to parse some source code, doing at most a limited amount of\n work before returning, so that parsing a large document can be interleaved\n with other work on the same thread.\n\n The `old_tree` and `input` parameters work the same as in `ts_parser_parse`.\n The `operation_budget` parameter is the number of parse actions that this\n call may perform. The budget is only checked after each stack version has\n advanced by one token, so a call can slightly exceed it. The final call,\n which assembles the syntax tree, takes longer than the others.\n\n This function returns:\n 1. `TSParseStatusComplete` if parsing has finished. The resulting syntax\n    tree is written to `tree`.\n 2. `TSParseStatusIncomplete` if the budget was used up before parsing\n    finished, or if parsing was halted by the parser's timeout or\n    cancellation flag. Call this function again with the same arguments to\n    continue parsing, or call `ts_parser_reset` to discard the parse.\n 3. `TSParseStatusFailed` if the parser does not have a language assigned.\n\n If `progress_bytes` is not `NULL`, then the number of bytes of the input\n that have been parsed so far is written to it. This never decreases from\n one call to the next, so it can be used to report progress.\n"]
+    pub fn ts_parser_parse_step(
+        self_: *mut TSParser,
+        old_tree: *const TSTree,
+        input: TSInput,
+        operation_budget: u32,
+        tree: *mut *mut TSTree,
+        progress_bytes: *mut u32,
+    ) -> TSParseStatus;
+}
+extern "C" {
+    #[doc = " Use the parser to parse some UTF8 source code stored in one contiguous\n buffer, doing at most a limited amount of work before returning. The\n `string` and `length` parameters work the same as in\n `ts_parser_parse_string`, and the other parameters and the return value\n work the same as in `ts_parser_parse_step`."]
+    pub fn ts_parser_parse_string_step(
+        self_: *mut TSParser,
+        old_tree: *const TSTree,
+        string: *const ::std::os::raw::c_char,
+        length: u32,
+        operation_budget: u32,
+        tree: *mut *mut TSTree,
+        progress_bytes: *mut u32,
+    ) -> TSParseStatus;
+}
+extern "C" {
+    #[doc = " Use the parser to parse a sequence of independent documents, each stored\n as UTF8 text in a contiguous buffer.\n\n This is equivalent to calling `ts_parser_parse_string` once for each of the\n `count` documents, without an old tree. The `strings` and `lengths` arrays\n contain each document's text and its length in bytes. Because the text is\n contiguous, the lexer reads it directly, without going through a `TSInput`\n callback. The parser also keeps its internal buffers between documents, so\n parsing many small documents this way avoids most of the cost of setting up\n each parse.\n\n The resulting trees are written to `trees`, which must have room for\n `count` trees. If `parse_times_micros` is not `NULL`, then the time spent\n parsing each document is written to it, in microseconds.\n\n Returns the number of documents that were parsed. This is less than `count`\n if parsing was halted by the parser's timeout or cancellation flag. In that\n case, the next document's tree is `NULL`, and its parse can be resumed by\n passing the same text to `ts_parser_parse_string`, or discarded using\n `ts_parser_reset`."]
+    pub fn ts_parser_parse_batch(
+        self_: *mut TSParser,
+        strings: *const *const ::std::os::raw::c_char,
+        lengths: *const u32,
+        count: u32,
+        trees: *mut *mut TSTree,
+        parse_times_micros: *mut u64,
+    ) -> u32;
+}
+extern "C" {
+    #[doc = " Use the parser to parse some UTF8 source code stored in one contiguous\n buffer, using up to `thread_count` threads, including the current one.\n\n The input is split into chunks at line boundaries, and each chunk is\n parsed on its own thread. The chunks' trees are then combined into a single\n syntax tree by reparsing the whole input on the current thread, reusing the\n chunks' nodes wherever they are valid in their actual context. Except for\n the way that syntax errors are recovered from, the resulting tree is the\n same as the one produced by `ts_parser_parse_string`.\n\n This is only worthwhile for very large inputs. Small inputs, inputs for\n languages with external scanners, and parsers with included ranges are\n parsed normally on the current thread.\n\n If parsing is halted by the parser's timeout or cancellation flag, then\n this function returns `NULL`. If that happens while the chunks are being\n parsed, their progress is discarded. Otherwise, calling this function again\n resumes parsing, like `ts_parser_parse`."]
+    pub fn ts_parser_parse_parallel(
+        self_: *mut TSParser,
+        string: *const ::std::os::raw::c_char,
+        length: u32,
+        thread_count: u32,
+    ) -> *mut TSTree;
+}
 extern "C" {
     #[doc = " Instruct the parser to start the next parse from the beginning.\n\n If the parser previously failed because of a timeout or a cancellation, then\n by default, it will resume where it left off on the next call to\n `ts_parser_parse` or other parsing functions. If you don't want to resume,\n and instead intend to use this parser to parse some other document, you must\n call `ts_parser_reset` first."]
     pub fn ts_parser_reset(self_: *mut TSParser);
@@ -212,6 +372,14 @@ extern "C" {
     #[doc = " Get the duration in microseconds that parsing is allowed to take."]
     pub fn ts_parser_timeout_micros(self_: *const TSParser) -> u64;
 }
+extern "C" {
+    #[doc = " Set the maximum amount of work that the parser should spend exploring\n different ways of recovering from each region of invalid input.\n\n Each token that the parser processes while recovering from an error, and\n each alternative interpretation that it tries, costs one unit of this\n budget. Once the budget for a region of invalid input is spent, the parser\n switches to a cheaper strategy: it skips tokens until it reaches one that\n would be valid in some enclosing construct, and resumes parsing there. The\n budget is restored once the parser is back to parsing valid input. Unlike\n a timeout, this always produces a tree, although the ERROR nodes in it may\n be larger than they would be otherwise.\n\n A budget of zero, which is the default, means that error recovery is not\n limited."]
+    pub fn ts_parser_set_recovery_budget(self_: *mut TSParser, budget: u32);
+}
+extern "C" {
+    #[doc = " Get the parser's recovery budget."]
+    pub fn ts_parser_recovery_budget(self_: *const TSParser) -> u32;
+}
 extern "C" {
     #[doc = " Set the parser's current cancellation flag pointer.\n\n If a non-null pointer is assigned, then the parser will periodically read\n from this pointer during parsing. If it reads a non-zero value, it will\n halt early, returning NULL. See `ts_parser_parse` for more information."]
     pub fn ts_parser_set_cancellation_flag(self_: *mut TSParser, flag: *const usize);
@@ -220,6 +388,14 @@ extern "C" {
     #[doc = " Get the parser's current cancellation flag pointer."]
     pub fn ts_parser_cancellation_flag(self_: *const TSParser) -> *const usize;
 }
+extern "C" {
+    #[doc = " Set whether the parser should allocate the nodes of the trees that it\n produces from arenas.\n\n When this is enabled, each parse allocates its nodes from a set of large\n slabs, instead of allocating them individually. Deleting the resulting tree\n with `ts_tree_delete` frees these slabs all at once, which is much cheaper\n than freeing every node. This is most useful when parsing many short-lived\n documents.\n\n Trees produced this way can still be edited and passed as the old tree to\n `ts_parser_parse`. Memory that is shared between an old tree and a new tree\n is kept alive until both trees have been deleted. This means that a long\n sequence of incremental parses can hold onto the memory of many previous\n trees, so after a number of consecutive incremental parses, the parser will\n occasionally parse the document from scratch to let that memory be freed."]
+    pub fn ts_parser_set_arena_allocation(self_: *mut TSParser, enabled: bool);
+}
+extern "C" {
+    #[doc = " Get whether the parser allocates the nodes of its trees from arenas."]
+    pub fn ts_parser_arena_allocation(self_: *const TSParser) -> bool;
+}
 extern "C" {
     #[doc = " Set the logger that a parser should use during parsing.\n\n The parser does not take ownership over the logger payload. If a logger was\n previously assigned, the caller is responsible for releasing any memory\n owned by the previous logger."]
     pub fn ts_parser_set_logger(self_: *mut TSParser, logger: TSLogger);
@@ -232,6 +408,34 @@ extern "C" {
     #[doc = " Set the file descriptor to which the parser should write debugging graphs\n during parsing. The graphs are formatted in the DOT language. You may want\n to pipe these graphs directly to a `dot(1)` process in order to generate\n SVG output. You can turn off this logging by passing a negative number."]
     pub fn ts_parser_print_dot_graphs(self_: *mut TSParser, file: ::std::os::raw::c_int);
 }
+extern "C" {
+    #[doc = " Get counters describing the work that the parser did during the most recent\n parse: how many times it ran the lexer and how many bytes the lexer read,\n how many shift and reduce actions it performed, the largest number of stack\n versions that it tracked at once, how many subtrees (and bytes) it reused\n from the old tree, how many times it attempted to recover from an error,\n and how many subtrees it allocated. The token cache counters record how\n often the parser reused a token that another stack version had already\n lexed at the same position, and how often it had to run the lexer instead.\n\n These counters are always maintained, so unlike the logger, they can be\n used to diagnose slow parses without affecting performance. If a parse is\n resumed after a timeout or cancellation, the counters include the work\n done before the parse was halted."]
+    pub fn ts_parser_stats(self_: *const TSParser, stats: *mut TSParserStats);
+}
+extern "C" {
+    #[doc = " Set a buffer into which the parser should write a fixed-size record of each\n significant event during parsing, such as lexing a token, or performing a\n shift or a reduction. This is much cheaper than logging, because nothing is\n formatted, so it can be left enabled in order to capture the events that\n led up to an unusually slow parse.\n\n The buffer is used as a ring: event number `n` is written to the index\n `n % capacity`, and the buffer's `event_count` is incremented. Once the\n buffer is full, the oldest events are overwritten. The caller retains\n ownership of the buffer, which must stay valid until it is replaced. Pass\n `NULL` to stop tracing.\n\n Each event's `value` depends on its type: the size of a lexed, reused or\n shifted node, the child count of a reduction, the stack depth of an error recovery,\n or the number of stack versions that were being processed."]
+    pub fn ts_parser_set_trace_buffer(self_: *mut TSParser, buffer: *mut TSTraceBuffer);
+}
+extern "C" {
+    #[doc = " Get the parser's current trace buffer."]
+    pub fn ts_parser_trace_buffer(self_: *const TSParser) -> *mut TSTraceBuffer;
+}
+extern "C" {
+    #[doc = " Set a callback that the parser should call with each top-level node of the\n document as soon as that node is complete, while the rest of the document\n is still being parsed. This allows other work, like highlighting, to begin\n before parsing has finished.\n\n A top-level node is a visible child of the syntax tree's root node. It is\n considered complete once the parser has only one interpretation of the\n text up to the end of the node, and the node has been reduced into a\n repetition in the grammar's start rule. Any remaining top-level nodes are\n passed after the document has been fully parsed, just before\n `ts_parser_parse` returns. Each top-level node is passed exactly once, in\n document order, and it is identical to the corresponding child of the\n returned tree's root node. To guarantee this, error recovery never\n re-parses a node that has already been passed.\n\n The node is only valid for the duration of the call. Its descendants can be\n inspected, but its parent cannot. Pass a stream whose `emit` function is\n `NULL` to stop streaming."]
+    pub fn ts_parser_set_node_stream(self_: *mut TSParser, stream: TSNodeStream);
+}
+extern "C" {
+    #[doc = " Get the parser's current node stream."]
+    pub fn ts_parser_node_stream(self_: *const TSParser) -> TSNodeStream;
+}
+extern "C" {
+    #[doc = " Set whether the parser should free the top-level nodes that it passes to\n its node stream (see `ts_parser_set_node_stream`) as soon as they have been\n passed, instead of keeping them in the tree that is being built.\n\n This bounds the parser's memory usage by the size of the largest top-level\n node, rather than the size of the whole document, so it can be used to\n parse very long inputs, like logs or sequences of JSON records. The tree\n that is returned still spans the entire document, but its root node only\n contains the top-level nodes that could not be streamed until the end of\n the parse. The tree can't be used for incremental parsing. While this is\n enabled, arena allocation is not used, because arenas are only freed when\n the entire tree is deleted.\n\n Error recovery takes into account how many nodes have been built since an\n error, and the freed nodes are no longer counted, so on invalid input the\n parser may occasionally recover from an error differently than it would\n otherwise."]
+    pub fn ts_parser_set_discard_streamed_nodes(self_: *mut TSParser, discard: bool);
+}
+extern "C" {
+    #[doc = " Get whether the parser frees the top-level nodes that it passes to its node\n stream."]
+    pub fn ts_parser_discard_streamed_nodes(self_: *const TSParser) -> bool;
+}
 extern "C" {
     #[doc = " Create a shallow copy of the syntax tree. This is very fast.\n\n You need to copy a syntax tree in order to use it on more than one thread at\n a time, as syntax trees are not thread safe."]
     pub fn ts_tree_copy(self_: *const TSTree) -> *mut TSTree;
@@ -240,6 +444,14 @@ extern "C" {
     #[doc = " Delete the syntax tree, freeing all of the memory that it used."]
     pub fn ts_tree_delete(self_: *mut TSTree);
 }
+extern "C" {
+    #[doc = " Delete the syntax tree without freeing the memory that it used.\n\n Freeing a very large syntax tree means visiting every one of its nodes,\n which can take a noticeable amount of time. This function returns right\n away, and queues the tree's nodes to be freed later by `ts_reclaim_step`.\n This lets you delete trees on a latency-sensitive thread, and do the work\n of freeing them on another thread, or when the application is idle."]
+    pub fn ts_tree_delete_deferred(self_: *mut TSTree);
+}
+extern "C" {
+    #[doc = " Free some of the memory used by syntax trees that were deleted with\n `ts_tree_delete_deferred`.\n\n At most `budget` nodes are freed. This function returns:\n 1. `TSReclaimStatusDone` if there is no more memory waiting to be freed.\n 2. `TSReclaimStatusPending` if there is more memory waiting to be freed, in\n    which case this function should be called again.\n 3. `TSReclaimStatusBusy` if this function is already running on another\n    thread. In that case, nothing was freed, and callers that loop should\n    wait before calling it again.\n\n This function can be called from any thread."]
+    pub fn ts_reclaim_step(budget: u32) -> TSReclaimStatus;
+}
 extern "C" {
     #[doc = " Get the root node of the syntax tree."]
     pub fn ts_tree_root_node(self_: *const TSTree) -> TSNode;
@@ -264,6 +476,10 @@ extern "C" {
     #[doc = " Edit the syntax tree to keep it in sync with source code that has been\n edited.\n\n You must describe the edit both in terms of byte offsets and in terms of\n (row, column) coordinates."]
     pub fn ts_tree_edit(self_: *mut TSTree, edit: *const TSInputEdit);
 }
+extern "C" {
+    #[doc = " Build an index from each of the syntax tree's nodes to its parent, so that\n `ts_node_parent` and the sibling functions take constant time for the\n tree's nodes, instead of searching down from the root.\n\n Building the index takes time proportional to the size of the tree, and\n uses about 40 bytes per node, so it is only worthwhile when many parents\n or siblings will be requested. The index is discarded when the tree is\n edited. This function can be called while other threads are using the tree."]
+    pub fn ts_tree_index_parents(self_: *const TSTree);
+}
 extern "C" {
     #[doc = " Compare an old edited syntax tree to a new syntax tree representing the same\n document, returning an array of ranges whose syntactic structure has changed.\n\n For this to work correctly, the old syntax tree must have been edited such\n that its ranges match up to the new tree. Generally, you'll want to call\n this function right after calling one of the `ts_parser_parse` functions.\n You need to pass the old tree that was passed to parse, as well as the new\n tree that was returned from that function.\n\n The returned array is allocated using `malloc` and the caller is responsible\n for freeing it using `free`. The length of the array will be written to the\n given `length` pointer."]
     pub fn ts_tree_get_changed_ranges(
@@ -272,6 +488,27 @@ extern "C" {
         length: *mut u32,
     ) -> *mut TSRange;
 }
+extern "C" {
+    #[doc = " Serialize the syntax tree into a compact binary format, so that it can be\n stored and restored later using `ts_tree_deserialize` instead of parsing\n the document again.\n\n The format is versioned and doesn't depend on the host's byte order. It\n includes everything that the tree's nodes store, including the states of\n any external scanners, as well as the tree's included ranges.\n\n The returned buffer is allocated using `malloc` and the caller is\n responsible for freeing it using `free`. The length of the buffer will be\n written to the given `length` pointer."]
+    pub fn ts_tree_serialize(self_: *const TSTree, length: *mut u32)
+        -> *mut ::std::os::raw::c_char;
+}
+extern "C" {
+    #[doc = " Restore a syntax tree that was serialized using `ts_tree_serialize`.\n\n The language must be the same one that the tree was parsed with. Returns\n `NULL` if it isn't, or if the data is truncated or was written using a\n different version of the format.\n\n The tree's nodes are rebuilt from the data, so the data doesn't need to\n outlive the call, and it can point directly into a memory-mapped file. All\n of the nodes are allocated together, so the tree is cheap to delete. It can\n be queried, and edited and passed as the `old_tree` for an incremental\n parse, just like the tree that was serialized."]
+    pub fn ts_tree_deserialize(
+        language: *const TSLanguage,
+        data: *const ::std::os::raw::c_char,
+        length: u32,
+    ) -> *mut TSTree;
+}
+extern "C" {
+    #[doc = " Export the syntax tree's nodes into flat arrays, so that they can be\n processed without calling a function for each node.\n\n The caller provides the arrays in the given `TSFlatTree`, each of which\n must have room for `capacity` elements. Any array can be `NULL`, in which\n case that property isn't exported. The nodes are written in document order,\n starting with the root node, and the entry at each index in the arrays\n describes the same node:\n - `symbols`: The node's symbol, as returned by `ts_node_symbol`.\n - `start_bytes`, `end_bytes`, `start_points` and `end_points`: The node's\n   range.\n - `parents`, `first_children` and `next_siblings`: The indices of other\n   exported nodes, or `UINT32_MAX` if there are none.\n - `field_ids`: The id of the field that the node is assigned within its\n   parent, or zero.\n - `flags`: A combination of `TSFlatNodeFlag` values.\n\n If the options' `named_only` flag is set, anonymous nodes are omitted, and\n their named descendants are exported as children of their nearest exported\n ancestor. If the options' `max_depth` is non-zero, nodes that are more than\n that many levels below the root are omitted.\n\n The output's `node_count` is set to the number of nodes that were exported.\n Returns `false` if that exceeds the capacity, in which case only the first\n `capacity` nodes are written, and the export can be retried with larger\n arrays."]
+    pub fn ts_tree_export(
+        self_: *const TSTree,
+        options: TSTreeExportOptions,
+        output: *mut TSFlatTree,
+    ) -> bool;
+}
 extern "C" {
     #[doc = " Write a DOT graph describing the syntax tree to the given file."]
     pub fn ts_tree_print_dot_graph(arg1: *const TSTree, file_descriptor: ::std::os::raw::c_int);
@@ -316,6 +553,19 @@ extern "C" {
     #[doc = " Get an S-expression representing the node as a string.\n\n This string is allocated with `malloc` and the caller is responsible for\n freeing it using `free`."]
     pub fn ts_node_string(arg1: TSNode) -> *mut ::std::os::raw::c_char;
 }
+extern "C" {
+    #[doc = " Write an S-expression representing the node, in pieces, using the given\n writer.\n\n Unlike `ts_node_string`, this does not build the whole string in memory, so\n it can be used to print very large trees. The `TSWriter`'s `write` function\n is called with successive chunks of the output, which are not\n null-terminated. It should return `false` if the chunk could not be written,\n in which case writing stops and this function returns `false`.\n\n With the default options, the output is identical to that of\n `ts_node_string`. The `TSSexpOptions` parameter has the following fields:\n 1. `include_ranges`: Write each node's start and end position after its\n    type, in the form `[row, column] - [row, column]`.\n 2. `indent`: Write each node on its own line, indented by two spaces per\n    level of nesting, instead of separating nodes with single spaces.\n 3. `node_types`: Write each node's type as returned by `ts_node_type`,\n    instead of writing error tokens as `UNEXPECTED` with the unexpected\n    character and missing tokens as `MISSING` with their type. Missing\n    anonymous tokens are omitted, like any other anonymous node. The\n    nesting and the field names are the same as those seen by a\n    `TSTreeCursor`."]
+    pub fn ts_node_write_sexp(self_: TSNode, options: TSSexpOptions, writer: TSWriter) -> bool;
+}
+extern "C" {
+    #[doc = " Write an XML document representing the node, in pieces, using the given\n writer. The writer is used in the same way as in `ts_node_write_sexp`.\n\n Each named node is written as an element whose tag is the node's type,\n on its own line and indented by its depth. Each closing tag is followed by\n a newline. If the node is assigned a field within its parent, the field\n name is written as a `type` attribute. The entire text of each node without\n any visible descendants is written, with XML special characters escaped,\n within its nearest enclosing element. The text is taken from the `source`\n buffer, which must contain the UTF-8 source code that the tree was parsed\n from. Pass `NULL` to omit the text."]
+    pub fn ts_node_write_xml(
+        self_: TSNode,
+        source: *const ::std::os::raw::c_char,
+        source_length: u32,
+        writer: TSWriter,
+    ) -> bool;
+}
 extern "C" {
     #[doc = " Check if the node is null. Functions like `ts_node_child` and\n `ts_node_next_sibling` will return a null node to indicate that no such node\n was found."]
     pub fn ts_node_is_null(arg1: TSNode) -> bool;
@@ -353,7 +603,7 @@ extern "C" {
     pub fn ts_node_next_parse_state(arg1: TSNode) -> TSStateId;
 }
 extern "C" {
-    #[doc = " Get the node's immediate parent."]
+    #[doc = " Get the node's immediate parent.\n\n Unless the tree's parents have been indexed using `ts_tree_index_parents`,\n this searches down from the root of the tree, so it takes time proportional\n to the node's depth. The same applies to the sibling functions below."]
     pub fn ts_node_parent(arg1: TSNode) -> TSNode;
 }
 extern "C" {
@@ -511,6 +761,15 @@ extern "C" {
     pub fn ts_tree_cursor_goto_first_child_for_point(arg1: *mut TSTreeCursor, arg2: TSPoint)
         -> i64;
 }
+extern "C" {
+    #[doc = " Move the cursor to the next node in pre-order, after its current node,\n whose symbol is one of the given symbols. If no symbols are given, any\n node matches.\n\n The flags are a combination of `TSTreeCursorMatchFlag` values. With\n `TSTreeCursorMatchNamed`, only named nodes match. With\n `TSTreeCursorMatchSkipChildren`, the current node's descendants are\n skipped, so that matches nested within other matches can be skipped.\n\n The search is done without returning to the caller for each node, and\n skips any subtrees that can't contain one of the symbols, so it's much\n faster than visiting every node with the other cursor functions.\n\n This returns `true` if a matching node was found. Otherwise, it returns\n `false`, and the cursor is moved back to the original node that it was\n constructed with."]
+    pub fn ts_tree_cursor_next_matching(
+        self_: *mut TSTreeCursor,
+        symbols: *const TSSymbol,
+        symbol_count: u32,
+        flags: u32,
+    ) -> bool;
+}
 extern "C" {
     pub fn ts_tree_cursor_copy(arg1: *const TSTreeCursor) -> TSTreeCursor;
 }
@@ -764,5 +1023,5 @@ extern "C" {
     );
 }
 
-pub const TREE_SITTER_LANGUAGE_VERSION: usize = 14;
+pub const TREE_SITTER_LANGUAGE_VERSION: usize = 15;
 pub const TREE_SITTER_MIN_COMPATIBLE_LANGUAGE_VERSION: usize = 13;
@@ -0,0 +1,340 @@
+use super::{ffi, FieldId, Language, Point, Tree};
+use std::{iter, ops};
+
+const NONE: u32 = u32::MAX;
+
+/// Options that control which nodes are included by [Tree::export].
+#[doc(alias = "TSTreeExportOptions")]
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct ExportOptions {
+    /// Omit anonymous nodes. Their named descendants are exported as children
+    /// of their nearest exported ancestor.
+    pub named_only: bool,
+    /// Omit nodes that are more than this many levels below the root. Zero
+    /// means that there is no limit.
+    pub max_depth: usize,
+}
+
+/// The nodes of a syntax [Tree], exported into flat arrays.
+///
+/// The nodes are stored in document order, starting with the root node, and
+/// each node is identified by its index. Each property is stored in its own
+/// array, which can be accessed directly as a slice, so passes over the whole
+/// tree don't need to call into the library for each node.
+#[doc(alias = "TSFlatTree")]
+#[derive(Clone, Debug)]
+pub struct FlatTree {
+    language: Language,
+    kind_ids: Vec<u16>,
+    start_bytes: Vec<u32>,
+    end_bytes: Vec<u32>,
+    start_points: Vec<ffi::TSPoint>,
+    end_points: Vec<ffi::TSPoint>,
+    parents: Vec<u32>,
+    first_children: Vec<u32>,
+    next_siblings: Vec<u32>,
+    field_ids: Vec<u16>,
+    flags: Vec<u8>,
+}
+
+/// A single node within a [FlatTree].
+#[derive(Clone, Copy)]
+pub struct FlatNode<'a> {
+    tree: &'a FlatTree,
+    index: usize,
+}
+
+impl Tree {
+    /// Export the syntax tree's nodes into a [FlatTree].
+    #[doc(alias = "ts_tree_export")]
+    pub fn export(&self, options: ExportOptions) -> FlatTree {
+        let mut result = FlatTree::new(self.language());
+        self.export_into(options, &mut result);
+        result
+    }
+
+    /// Export the syntax tree's nodes into an existing [FlatTree], reusing its
+    /// memory.
+    #[doc(alias = "ts_tree_export")]
+    pub fn export_into(&self, options: ExportOptions, output: &mut FlatTree) {
+        let options = ffi::TSTreeExportOptions {
+            named_only: options.named_only,
+            max_depth: options.max_depth.min(NONE as usize) as u32,
+        };
+
+        // The root node's descendant count is an upper bound on the number of
+        // nodes that are exported, so this normally takes one pass.
+        output.clear();
+        output.language = self.language();
+        output.reserve(self.root_node().descendant_count());
+        loop {
+            let mut raw = output.as_raw();
+            let done = unsafe { ffi::ts_tree_export(self.0.as_ptr(), options, &mut raw) };
+            if done {
+                unsafe { output.set_len(raw.node_count as usize) };
+                break;
+            }
+            output.reserve(raw.node_count as usize);
+        }
+    }
+}
+
+impl FlatTree {
+    fn new(language: Language) -> Self {
+        Self {
+            language,
+            kind_ids: Vec::new(),
+            start_bytes: Vec::new(),
+            end_bytes: Vec::new(),
+            start_points: Vec::new(),
+            end_points: Vec::new(),
+            parents: Vec::new(),
+            first_children: Vec::new(),
+            next_siblings: Vec::new(),
+            field_ids: Vec::new(),
+            flags: Vec::new(),
+        }
+    }
+
+    /// Get the language that was used to parse the exported tree.
+    pub fn language(&self) -> Language {
+        self.language
+    }
+
+    /// Get the number of exported nodes.
+    pub fn len(&self) -> usize {
+        self.kind_ids.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.kind_ids.is_empty()
+    }
+
+    /// Get the node at the given index.
+    pub fn node(&self, index: usize) -> Option<FlatNode> {
+        (index < self.len()).then(|| FlatNode { tree: self, index })
+    }
+
+    /// Get the exported root node.
+    pub fn root_node(&self) -> FlatNode {
+        self.node(0).unwrap()
+    }
+
+    /// Iterate over all of the exported nodes, in document order.
+    pub fn nodes(&self) -> impl ExactSizeIterator<Item = FlatNode> {
+        (0..self.len()).map(move |index| FlatNode { tree: self, index })
+    }
+
+    /// Get the numerical kind id of each node.
+    pub fn kind_ids(&self) -> &[u16] {
+        &self.kind_ids
+    }
+
+    /// Get the byte offset where each node starts.
+    pub fn start_bytes(&self) -> &[u32] {
+        &self.start_bytes
+    }
+
+    /// Get the byte offset where each node ends.
+    pub fn end_bytes(&self) -> &[u32] {
+        &self.end_bytes
+    }
+
+    /// Get the index of each node's parent, or `u32::MAX` for the root node.
+    pub fn parents(&self) -> &[u32] {
+        &self.parents
+    }
+
+    /// Get the field id of each node within its parent, or zero if the node
+    /// isn't assigned to a field.
+    pub fn field_ids(&self) -> &[u16] {
+        &self.field_ids
+    }
+
+    fn clear(&mut self) {
+        unsafe { self.set_len(0) };
+    }
+
+    fn reserve(&mut self, capacity: usize) {
+        let additional = capacity.saturating_sub(self.len());
+        self.kind_ids.reserve(additional);
+        self.start_bytes.reserve(additional);
+        self.end_bytes.reserve(additional);
+        self.start_points.reserve(additional);
+        self.end_points.reserve(additional);
+        self.parents.reserve(additional);
+        self.first_children.reserve(additional);
+        self.next_siblings.reserve(additional);
+        self.field_ids.reserve(additional);
+        self.flags.reserve(additional);
+    }
+
+    fn capacity(&self) -> usize {
+        [
+            self.kind_ids.capacity(),
+            self.start_bytes.capacity(),
+            self.end_bytes.capacity(),
+            self.start_points.capacity(),
+            self.end_points.capacity(),
+            self.parents.capacity(),
+            self.first_children.capacity(),
+            self.next_siblings.capacity(),
+            self.field_ids.capacity(),
+            self.flags.capacity(),
+        ]
+        .iter()
+        .copied()
+        .min()
+        .unwrap()
+        .min(NONE as usize)
+    }
+
+    fn as_raw(&mut self) -> ffi::TSFlatTree {
+        ffi::TSFlatTree {
+            capacity: self.capacity() as u32,
+            node_count: 0,
+            symbols: self.kind_ids.as_mut_ptr(),
+            start_bytes: self.start_bytes.as_mut_ptr(),
+            end_bytes: self.end_bytes.as_mut_ptr(),
+            start_points: self.start_points.as_mut_ptr(),
+            end_points: self.end_points.as_mut_ptr(),
+            parents: self.parents.as_mut_ptr(),
+            first_children: self.first_children.as_mut_ptr(),
+            next_siblings: self.next_siblings.as_mut_ptr(),
+            field_ids: self.field_ids.as_mut_ptr(),
+            flags: self.flags.as_mut_ptr(),
+        }
+    }
+
+    // All of the elements are plain integers, so the vectors can be extended
+    // over memory that has been written by `ts_tree_export`.
+    unsafe fn set_len(&mut self, len: usize) {
+        self.kind_ids.set_len(len);
+        self.start_bytes.set_len(len);
+        self.end_bytes.set_len(len);
+        self.start_points.set_len(len);
+        self.end_points.set_len(len);
+        self.parents.set_len(len);
+        self.first_children.set_len(len);
+        self.next_siblings.set_len(len);
+        self.field_ids.set_len(len);
+        self.flags.set_len(len);
+    }
+
+    fn node_at(&self, index: u32) -> Option<FlatNode> {
+        (index != NONE).then(|| FlatNode {
+            tree: self,
+            index: index as usize,
+        })
+    }
+}
+
+impl<'a> FlatNode<'a> {
+    /// Get this node's index within its [FlatTree].
+    pub fn index(&self) -> usize {
+        self.index
+    }
+
+    /// Get this node's type as a numerical id.
+    pub fn kind_id(&self) -> u16 {
+        self.tree.kind_ids[self.index]
+    }
+
+    /// Get this node's type as a string.
+    pub fn kind(&self) -> &'static str {
+        self.tree
+            .language
+            .node_kind_for_id(self.kind_id())
+            .unwrap_or("")
+    }
+
+    pub fn start_byte(&self) -> usize {
+        self.tree.start_bytes[self.index] as usize
+    }
+
+    pub fn end_byte(&self) -> usize {
+        self.tree.end_bytes[self.index] as usize
+    }
+
+    pub fn byte_range(&self) -> ops::Range<usize> {
+        self.start_byte()..self.end_byte()
+    }
+
+    pub fn start_position(&self) -> Point {
+        self.tree.start_points[self.index].into()
+    }
+
+    pub fn end_position(&self) -> Point {
+        self.tree.end_points[self.index].into()
+    }
+
+    /// Get the numerical id of the field that this node is assigned within its
+    /// parent.
+    pub fn field_id(&self) -> Option<FieldId> {
+        FieldId::new(self.tree.field_ids[self.index])
+    }
+
+    /// Get the name of the field that this node is assigned within its parent.
+    pub fn field_name(&self) -> Option<&'static str> {
+        self.field_id()
+            .and_then(|id| self.tree.language.field_name_for_id(id.get()))
+    }
+
+    pub fn is_named(&self) -> bool {
+        self.has_flag(ffi::TSFlatNodeFlag_TSFlatNodeFlagNamed)
+    }
+
+    pub fn is_extra(&self) -> bool {
+        self.has_flag(ffi::TSFlatNodeFlag_TSFlatNodeFlagExtra)
+    }
+
+    pub fn is_missing(&self) -> bool {
+        self.has_flag(ffi::TSFlatNodeFlag_TSFlatNodeFlagMissing)
+    }
+
+    pub fn has_error(&self) -> bool {
+        self.has_flag(ffi::TSFlatNodeFlag_TSFlatNodeFlagHasError)
+    }
+
+    pub fn parent(&self) -> Option<Self> {
+        self.tree.node_at(self.tree.parents[self.index])
+    }
+
+    pub fn first_child(&self) -> Option<Self> {
+        self.tree.node_at(self.tree.first_children[self.index])
+    }
+
+    pub fn next_sibling(&self) -> Option<Self> {
+        self.tree.node_at(self.tree.next_siblings[self.index])
+    }
+
+    /// Iterate over this node's exported children.
+    pub fn children(&self) -> impl Iterator<Item = FlatNode<'a>> {
+        iter::successors(self.first_child(), |child| child.next_sibling())
+    }
+
+    fn has_flag(&self, flag: ffi::TSFlatNodeFlag) -> bool {
+        self.tree.flags[self.index] as ffi::TSFlatNodeFlag & flag != 0
+    }
+}
+
+impl PartialEq for FlatNode<'_> {
+    fn eq(&self, other: &Self) -> bool {
+        std::ptr::eq(self.tree, other.tree) && self.index == other.index
+    }
+}
+
+impl Eq for FlatNode<'_> {}
+
+impl std::fmt::Debug for FlatNode<'_> {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        write!(
+            f,
+            "{{FlatNode {} {} {:?} - {:?}}}",
+            self.index,
+            self.kind(),
+            self.start_position(),
+            self.end_position()
+        )
+    }
+}
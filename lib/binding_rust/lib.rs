@@ -1,21 +1,30 @@
 pub mod ffi;
+mod flat_tree;
+mod pool;
 mod util;
 
+pub use flat_tree::{ExportOptions, FlatNode, FlatTree};
+pub use pool::{ParseJob, ParserPool};
+
 #[cfg(unix)]
 use std::os::unix::io::AsRawFd;
 
 use std::{
-    char, error,
+    char,
+    collections::VecDeque,
+    error,
     ffi::CStr,
-    fmt, hash, iter,
+    fmt, hash, io, iter,
     marker::PhantomData,
-    mem::MaybeUninit,
+    mem::{self, MaybeUninit},
     num::NonZeroU16,
     ops,
     os::raw::{c_char, c_void},
     ptr::{self, NonNull},
     slice, str,
-    sync::atomic::AtomicUsize,
+    sync::atomic::{self, AtomicBool, AtomicUsize},
+    thread,
+    time::Duration,
     u16,
 };
 
@@ -77,6 +86,39 @@ pub struct InputEdit {
     pub new_end_position: Point,
 }
 
+/// Counters describing the work that a `Parser` did during its most recent parse.
+#[doc(alias = "TSParserStats")]
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct ParserStats {
+    pub lex_count: usize,
+    pub lexed_byte_count: usize,
+    pub shift_count: usize,
+    pub reduce_count: usize,
+    pub max_version_count: usize,
+    pub reused_subtree_count: usize,
+    pub reused_byte_count: usize,
+    pub recover_count: usize,
+    pub subtree_allocation_count: usize,
+    pub token_cache_hit_count: usize,
+    pub token_cache_miss_count: usize,
+}
+
+/// Options that control the format of [Node::write_sexp].
+#[doc(alias = "TSSexpOptions")]
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct SexpOptions {
+    /// Write each node's start and end position after its kind.
+    pub include_ranges: bool,
+    /// Write each node on its own line, indented by its depth, instead of
+    /// separating the nodes with single spaces.
+    pub indent: bool,
+    /// Write each node's kind as [Node::kind] returns it, instead of marking
+    /// error tokens with `UNEXPECTED` and missing tokens with `MISSING`.
+    /// Missing anonymous tokens are omitted, and the nesting and field names
+    /// are the same as those seen by a [TreeCursor].
+    pub node_types: bool,
+}
+
 /// A single node within a syntax `Tree`.
 #[doc(alias = "TSNode")]
 #[derive(Clone, Copy)]
@@ -87,11 +129,42 @@ pub struct Node<'tree>(ffi::TSNode, PhantomData<&'tree ()>);
 #[doc(alias = "TSParser")]
 pub struct Parser(NonNull<ffi::TSParser>);
 
+/// An iterator over the syntax trees of a sequence of documents, produced by
+/// [Parser::parse_many].
+pub struct ParseMany<'parser, I> {
+    parser: &'parser mut Parser,
+    texts: I,
+    results: VecDeque<(Option<Tree>, Duration)>,
+}
+
 /// A stateful object that is used to look up symbols valid in a specific parse state
 #[doc(alias = "TSLookaheadIterator")]
 pub struct LookaheadIterator(NonNull<ffi::TSLookaheadIterator>);
 struct LookaheadNamesIterator<'a>(&'a mut LookaheadIterator);
 
+/// The outcome of a call to [Parser::parse_step].
+#[doc(alias = "TSParseStatus")]
+#[derive(Debug)]
+pub enum ParseStep {
+    /// Parsing has finished, producing this syntax tree.
+    Complete(Tree),
+    /// Parsing has not finished. This contains the number of bytes of the
+    /// input that have been parsed so far.
+    Incomplete(usize),
+}
+
+/// The outcome of a call to [reclaim_step].
+#[doc(alias = "TSReclaimStatus")]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum ReclaimStatus {
+    /// There is no more memory waiting to be freed.
+    Done,
+    /// There is more memory waiting to be freed.
+    Pending,
+    /// Memory is already being freed on another thread, so nothing was freed.
+    Busy,
+}
+
 /// A type of log message.
 #[derive(Debug, PartialEq, Eq)]
 pub enum LogType {
@@ -99,11 +172,64 @@ pub enum LogType {
     Lex,
 }
 
+/// A type of event that can be recorded in a parser's trace.
+#[doc(alias = "TSTraceEventType")]
+#[derive(Clone, Copy, Debug, PartialEq, Eq, Hash)]
+#[repr(u16)]
+pub enum TraceEventType {
+    NewParse,
+    ParseAfterEdit,
+    ResumeParsing,
+    ProcessVersion,
+    LexedLookahead,
+    ReuseNode,
+    BreakdownTopOfStack,
+    Shift,
+    ShiftExtra,
+    Reduce,
+    Accept,
+    DetectError,
+    RecoverToPrevious,
+    RecoverWithMissing,
+    RecoverEof,
+    SkipToken,
+    Resume,
+    Condense,
+    Done,
+}
+
+/// A compact record of a single event during parsing. See `Parser::start_tracing`.
+///
+/// The meaning of `value` depends on the type of event: it is the size of a lexed,
+/// reused or shifted node, the child count of a reduction, the stack depth of an error
+/// recovery, or the number of stack versions that were being processed.
+#[doc(alias = "TSTraceEvent")]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct TraceEvent {
+    pub event_type: TraceEventType,
+    pub state: u16,
+    pub symbol: u16,
+    pub version: usize,
+    pub byte: usize,
+    pub value: u32,
+}
+
+// A trace buffer, along with the storage for its events. The header must come
+// first, so that the pointer that is passed to the parser can be converted back.
+#[repr(C)]
+struct TraceBuffer {
+    header: ffi::TSTraceBuffer,
+    events: Vec<ffi::TSTraceEvent>,
+}
+
 type FieldId = NonZeroU16;
 
 /// A callback that receives log messages during parser.
 type Logger<'a> = Box<dyn FnMut(LogType, &str) + 'a>;
 
+/// A callback that receives each top-level node as soon as it has been parsed.
+type NodeStream<'a> = Box<dyn FnMut(Node) + 'a>;
+
 /// A stateful object for walking a syntax `Tree` efficiently.
 #[doc(alias = "TSTreeCursor")]
 pub struct TreeCursor<'cursor>(ffi::TSTreeCursor, PhantomData<&'cursor ()>);
@@ -477,6 +603,141 @@ impl Parser {
         unsafe { ffi::ts_parser_print_dot_graphs(self.0.as_ptr(), -1) }
     }
 
+    /// Start recording a compact trace of the parser's actions, retaining the
+    /// most recent `capacity` events. Tracing is much cheaper than logging, so
+    /// it can be left enabled in order to find out what happened during an
+    /// unexpectedly slow parse.
+    #[doc(alias = "ts_parser_set_trace_buffer")]
+    pub fn start_tracing(&mut self, capacity: usize) {
+        self.stop_tracing();
+        let mut buffer = Box::new(TraceBuffer {
+            header: ffi::TSTraceBuffer {
+                events: ptr::null_mut(),
+                capacity: capacity as u32,
+                event_count: 0,
+            },
+            events: vec![unsafe { mem::zeroed() }; capacity],
+        });
+        buffer.header.events = buffer.events.as_mut_ptr();
+        unsafe {
+            ffi::ts_parser_set_trace_buffer(
+                self.0.as_ptr(),
+                Box::into_raw(buffer) as *mut ffi::TSTraceBuffer,
+            )
+        };
+    }
+
+    /// Stop recording a trace of the parser's actions, and discard any events
+    /// that were recorded.
+    #[doc(alias = "ts_parser_set_trace_buffer")]
+    pub fn stop_tracing(&mut self) {
+        let buffer = unsafe { ffi::ts_parser_trace_buffer(self.0.as_ptr()) };
+        if !buffer.is_null() {
+            unsafe { ffi::ts_parser_set_trace_buffer(self.0.as_ptr(), ptr::null_mut()) };
+            drop(unsafe { Box::from_raw(buffer as *mut TraceBuffer) });
+        }
+    }
+
+    /// Get the events that have been recorded since tracing was started, from
+    /// oldest to newest. If more events occurred than the trace's capacity,
+    /// only the most recent ones are returned.
+    #[doc(alias = "ts_parser_trace_buffer")]
+    pub fn trace_events(&self) -> Vec<TraceEvent> {
+        let buffer = match unsafe { ffi::ts_parser_trace_buffer(self.0.as_ptr()).as_ref() } {
+            Some(buffer) if buffer.capacity > 0 => buffer,
+            _ => return Vec::new(),
+        };
+        let capacity = buffer.capacity as u64;
+        let events = unsafe { slice::from_raw_parts(buffer.events, capacity as usize) };
+        let start = buffer.event_count.saturating_sub(capacity);
+        (start..buffer.event_count)
+            .map(|i| events[(i % capacity) as usize].into())
+            .collect()
+    }
+
+    /// Set a callback that receives each top-level node of the document as
+    /// soon as that node is complete, while the rest of the document is still
+    /// being parsed.
+    ///
+    /// A top-level node is a visible child of the tree's root node. Each one
+    /// is passed exactly once, in document order, and it is identical to the
+    /// corresponding child of the root node of the tree that is eventually
+    /// returned. Nodes that can't be passed earlier are passed just before
+    /// parsing finishes. The node can't be used after the callback returns,
+    /// and its parent is not available.
+    #[doc(alias = "ts_parser_set_node_stream")]
+    pub fn set_node_stream(&mut self, stream: Option<NodeStream>) {
+        let prev_stream = unsafe { ffi::ts_parser_node_stream(self.0.as_ptr()) };
+        if !prev_stream.payload.is_null() {
+            drop(unsafe { Box::from_raw(prev_stream.payload as *mut NodeStream) });
+        }
+
+        let c_stream;
+        if let Some(stream) = stream {
+            let container = Box::new(stream);
+
+            unsafe extern "C" fn emit(payload: *mut c_void, c_node: ffi::TSNode) {
+                let callback = (payload as *mut NodeStream).as_mut().unwrap();
+                if let Some(node) = Node::new(c_node) {
+                    callback(node);
+                }
+            }
+
+            let raw_container = Box::into_raw(container);
+
+            c_stream = ffi::TSNodeStream {
+                payload: raw_container as *mut c_void,
+                emit: Some(emit),
+            };
+        } else {
+            c_stream = ffi::TSNodeStream {
+                payload: ptr::null_mut(),
+                emit: None,
+            };
+        }
+
+        unsafe { ffi::ts_parser_set_node_stream(self.0.as_ptr(), c_stream) };
+    }
+
+    /// Get whether the parser frees the top-level nodes that it passes to its
+    /// node stream.
+    ///
+    /// This is set via [set_discard_streamed_nodes](Parser::set_discard_streamed_nodes).
+    #[doc(alias = "ts_parser_discard_streamed_nodes")]
+    pub fn discard_streamed_nodes(&self) -> bool {
+        unsafe { ffi::ts_parser_discard_streamed_nodes(self.0.as_ptr()) }
+    }
+
+    /// Set whether the parser should free the top-level nodes that it passes
+    /// to its [node stream](Parser::set_node_stream) as soon as they have been
+    /// passed.
+    ///
+    /// This bounds the parser's memory usage by the size of the largest
+    /// top-level node, so that arbitrarily long inputs can be parsed. The
+    /// returned tree still spans the whole input, but its root node only
+    /// contains the top-level nodes that were streamed at the end of the
+    /// parse, and it can't be used for incremental parsing.
+    #[doc(alias = "ts_parser_set_discard_streamed_nodes")]
+    pub fn set_discard_streamed_nodes(&mut self, discard: bool) {
+        unsafe { ffi::ts_parser_set_discard_streamed_nodes(self.0.as_ptr(), discard) }
+    }
+
+    /// Get counters describing the work that the parser did during the most
+    /// recent parse, such as the number of tokens that it lexed, the number of
+    /// parse actions that it performed, and the number of subtrees that it
+    /// reused from the old tree.
+    ///
+    /// Unlike logging, these counters don't slow down parsing, so they can be
+    /// used to find out why a particular document is slow to parse.
+    #[doc(alias = "ts_parser_stats")]
+    pub fn stats(&self) -> ParserStats {
+        let mut stats = MaybeUninit::<ffi::TSParserStats>::uninit();
+        unsafe {
+            ffi::ts_parser_stats(self.0.as_ptr(), stats.as_mut_ptr());
+            stats.assume_init().into()
+        }
+    }
+
     /// Parse a slice of UTF8 text.
     ///
     /// # Arguments:
@@ -490,14 +751,68 @@ impl Parser {
     ///  * The parser has not yet had a language assigned with [Parser::set_language]
     ///  * The timeout set with [Parser::set_timeout_micros] expired
     ///  * The cancellation flag set with [Parser::set_cancellation_flag] was flipped
-    #[doc(alias = "ts_parser_parse")]
+    #[doc(alias = "ts_parser_parse_string")]
     pub fn parse(&mut self, text: impl AsRef<[u8]>, old_tree: Option<&Tree>) -> Option<Tree> {
         let bytes = text.as_ref();
-        let len = bytes.len();
-        self.parse_with(
-            &mut |i, _| (i < len).then(|| &bytes[i..]).unwrap_or_default(),
-            old_tree,
-        )
+        let c_old_tree = old_tree.map_or(ptr::null_mut(), |t| t.0.as_ptr());
+        unsafe {
+            let c_new_tree = ffi::ts_parser_parse_string(
+                self.0.as_ptr(),
+                c_old_tree,
+                bytes.as_ptr() as *const c_char,
+                bytes.len() as u32,
+            );
+            NonNull::new(c_new_tree).map(Tree)
+        }
+    }
+
+    /// Parse a slice of UTF8 text, using multiple threads.
+    ///
+    /// The text is split into chunks, which are parsed on up to `thread_count`
+    /// threads, including the current one. Except for the way that syntax errors
+    /// are recovered from, the resulting syntax tree is the same as the one that
+    /// would be returned by [Parser::parse].
+    ///
+    /// This is only worthwhile for very large inputs. Small inputs, and inputs
+    /// for languages that use external scanners, are parsed normally on the
+    /// current thread.
+    #[doc(alias = "ts_parser_parse_parallel")]
+    pub fn parse_parallel(&mut self, text: impl AsRef<[u8]>, thread_count: usize) -> Option<Tree> {
+        let bytes = text.as_ref();
+        unsafe {
+            let c_new_tree = ffi::ts_parser_parse_parallel(
+                self.0.as_ptr(),
+                bytes.as_ptr() as *const c_char,
+                bytes.len() as u32,
+                thread_count as u32,
+            );
+            NonNull::new(c_new_tree).map(Tree)
+        }
+    }
+
+    /// Parse a sequence of independent documents, each stored in a slice of UTF8
+    /// text.
+    ///
+    /// This returns an iterator that yields each document's syntax tree along
+    /// with the time that it took to parse. As the iterator is advanced, it
+    /// parses the documents in small batches, using `ts_parser_parse_batch`. The
+    /// parser keeps its internal buffers between documents, so this is a cheap
+    /// way to parse many small documents.
+    ///
+    /// If parsing a document is halted by the timeout or the cancellation flag,
+    /// then the iterator yields `None` in place of its tree, and moves on to the
+    /// next document.
+    #[doc(alias = "ts_parser_parse_batch")]
+    pub fn parse_many<I>(&mut self, texts: I) -> ParseMany<'_, I::IntoIter>
+    where
+        I: IntoIterator,
+        I::Item: AsRef<[u8]>,
+    {
+        ParseMany {
+            parser: self,
+            texts: texts.into_iter(),
+            results: VecDeque::new(),
+        }
     }
 
     /// Parse a slice of UTF16 text.
@@ -627,6 +942,55 @@ impl Parser {
         }
     }
 
+    /// Parse a slice of UTF8 text, doing at most a limited amount of work.
+    ///
+    /// This lets the parsing of a large document be interleaved with other
+    /// work on the same thread. Call this repeatedly with the same arguments
+    /// until it returns [ParseStep::Complete], or call [Parser::reset] to
+    /// abandon the parse.
+    ///
+    /// # Arguments:
+    /// * `text` The UTF8-encoded text to parse.
+    /// * `old_tree` A previous syntax tree parsed from the same document,
+    ///   as in [Parser::parse].
+    /// * `operation_budget` The number of parse actions that this call may
+    ///   perform. A call can slightly exceed it.
+    ///
+    /// Returns `None` if the parser has not yet had a language assigned with
+    /// [Parser::set_language].
+    #[doc(alias = "ts_parser_parse_string_step")]
+    pub fn parse_step(
+        &mut self,
+        text: impl AsRef<[u8]>,
+        old_tree: Option<&Tree>,
+        operation_budget: u32,
+    ) -> Option<ParseStep> {
+        let text = text.as_ref();
+        let c_old_tree = old_tree.map_or(ptr::null_mut(), |t| t.0.as_ptr());
+        let mut c_new_tree = ptr::null_mut();
+        let mut progress_bytes = 0u32;
+        let status = unsafe {
+            ffi::ts_parser_parse_string_step(
+                self.0.as_ptr(),
+                c_old_tree,
+                text.as_ptr() as *const c_char,
+                text.len() as u32,
+                operation_budget,
+                &mut c_new_tree,
+                &mut progress_bytes,
+            )
+        };
+        match status {
+            ffi::TSParseStatus_TSParseStatusComplete => {
+                NonNull::new(c_new_tree).map(|tree| ParseStep::Complete(Tree(tree)))
+            }
+            ffi::TSParseStatus_TSParseStatusIncomplete => {
+                Some(ParseStep::Incomplete(progress_bytes as usize))
+            }
+            _ => None,
+        }
+    }
+
     /// Instruct the parser to start the next parse from the beginning.
     ///
     /// If the parser previously failed because of a timeout or a cancellation, then
@@ -656,6 +1020,47 @@ impl Parser {
         unsafe { ffi::ts_parser_set_timeout_micros(self.0.as_ptr(), timeout_micros) }
     }
 
+    /// Get the amount of work that the parser may spend recovering from each
+    /// region of invalid input.
+    ///
+    /// This is set via [set_recovery_budget](Parser::set_recovery_budget).
+    #[doc(alias = "ts_parser_recovery_budget")]
+    pub fn recovery_budget(&self) -> u32 {
+        unsafe { ffi::ts_parser_recovery_budget(self.0.as_ptr()) }
+    }
+
+    /// Set the maximum amount of work that the parser should spend exploring
+    /// different ways of recovering from each region of invalid input.
+    ///
+    /// Once the budget for a region is spent, the parser just skips tokens
+    /// until it finds one that is valid in some enclosing construct. Unlike
+    /// a [timeout](Parser::set_timeout_micros), this still produces a tree,
+    /// so it can be used to bound the time spent on garbage or on input in
+    /// the wrong language. A budget of zero, the default, means no limit.
+    #[doc(alias = "ts_parser_set_recovery_budget")]
+    pub fn set_recovery_budget(&mut self, budget: u32) {
+        unsafe { ffi::ts_parser_set_recovery_budget(self.0.as_ptr(), budget) }
+    }
+
+    /// Get whether the parser allocates the nodes of its trees from arenas.
+    ///
+    /// This is set via [set_arena_allocation](Parser::set_arena_allocation).
+    #[doc(alias = "ts_parser_arena_allocation")]
+    pub fn arena_allocation(&self) -> bool {
+        unsafe { ffi::ts_parser_arena_allocation(self.0.as_ptr()) }
+    }
+
+    /// Set whether the parser should allocate the nodes of the trees that it
+    /// produces from arenas.
+    ///
+    /// Arena-allocated trees are much cheaper to drop, because their memory is
+    /// freed in a few large blocks rather than one node at a time. They can
+    /// still be edited and reused for incremental parsing.
+    #[doc(alias = "ts_parser_set_arena_allocation")]
+    pub fn set_arena_allocation(&mut self, enabled: bool) {
+        unsafe { ffi::ts_parser_set_arena_allocation(self.0.as_ptr(), enabled) }
+    }
+
     /// Set the ranges of text that the parser should include when parsing.
     ///
     /// By default, the parser will always include entire documents. This function
@@ -726,10 +1131,66 @@ impl Drop for Parser {
     fn drop(&mut self) {
         self.stop_printing_dot_graphs();
         self.set_logger(None);
+        self.stop_tracing();
+        self.set_node_stream(None);
         unsafe { ffi::ts_parser_delete(self.0.as_ptr()) }
     }
 }
 
+/// The maximum number of documents that [ParseMany] parses at a time.
+const PARSE_MANY_BATCH_SIZE: usize = 32;
+
+impl<I> Iterator for ParseMany<'_, I>
+where
+    I: Iterator,
+    I::Item: AsRef<[u8]>,
+{
+    type Item = (Option<Tree>, Duration);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.results.is_empty() {
+            let texts = self
+                .texts
+                .by_ref()
+                .take(PARSE_MANY_BATCH_SIZE)
+                .collect::<Vec<_>>();
+            let (strings, lengths): (Vec<_>, Vec<_>) = texts
+                .iter()
+                .map(|text| {
+                    let bytes: &[u8] = text.as_ref();
+                    (bytes.as_ptr() as *const c_char, bytes.len() as u32)
+                })
+                .unzip();
+            let mut trees = vec![ptr::null_mut(); texts.len()];
+            let mut parse_times = vec![0; texts.len()];
+            let mut start = 0;
+            while start < texts.len() {
+                start += unsafe {
+                    ffi::ts_parser_parse_batch(
+                        self.parser.0.as_ptr(),
+                        strings[start..].as_ptr(),
+                        lengths[start..].as_ptr(),
+                        (texts.len() - start) as u32,
+                        trees[start..].as_mut_ptr(),
+                        parse_times[start..].as_mut_ptr(),
+                    )
+                } as usize;
+
+                // Don't resume a halted document's parse when parsing the next one.
+                if start < texts.len() {
+                    unsafe { ffi::ts_parser_reset(self.parser.0.as_ptr()) };
+                    start += 1;
+                }
+            }
+            self.results
+                .extend(trees.into_iter().zip(parse_times).map(|(tree, micros)| {
+                    (NonNull::new(tree).map(Tree), Duration::from_micros(micros))
+                }));
+        }
+        self.results.pop_front()
+    }
+}
+
 impl Tree {
     /// Get the root node of the syntax tree.
     #[doc(alias = "ts_tree_root_node")]
@@ -768,6 +1229,18 @@ impl Tree {
         unsafe { ffi::ts_tree_edit(self.0.as_ptr(), &edit) };
     }
 
+    /// Build an index from each of the tree's nodes to its parent, so that
+    /// [Node::parent] and the sibling methods take constant time for the
+    /// tree's nodes, instead of searching down from the root.
+    ///
+    /// Building the index takes time proportional to the size of the tree, so
+    /// it is only worthwhile when many parents or siblings will be requested.
+    /// The index is discarded when the tree is edited.
+    #[doc(alias = "ts_tree_index_parents")]
+    pub fn index_parents(&self) {
+        unsafe { ffi::ts_tree_index_parents(self.0.as_ptr()) }
+    }
+
     /// Create a new [TreeCursor] starting from the root of the tree.
     pub fn walk(&self) -> TreeCursor {
         self.root_node().walk()
@@ -805,6 +1278,55 @@ impl Tree {
         }
     }
 
+    /// Serialize the syntax tree into a compact binary format, so that it can be
+    /// restored later using [Tree::deserialize] instead of parsing the document
+    /// again.
+    #[doc(alias = "ts_tree_serialize")]
+    pub fn serialize(&self) -> Vec<u8> {
+        let mut length = 0u32;
+        unsafe {
+            let ptr = ffi::ts_tree_serialize(self.0.as_ptr(), &mut length as *mut u32);
+            let result = slice::from_raw_parts(ptr as *const u8, length as usize).to_vec();
+            (FREE_FN)(ptr as *mut c_void);
+            result
+        }
+    }
+
+    /// Restore a syntax tree that was serialized using [Tree::serialize].
+    ///
+    /// The language must be the same one that the tree was parsed with. Returns
+    /// `None` if it isn't, or if the data is invalid. The tree's nodes are
+    /// rebuilt from the data, so the data can come directly from a memory-mapped
+    /// file, and doesn't need to outlive the call.
+    #[doc(alias = "ts_tree_deserialize")]
+    pub fn deserialize(language: Language, data: &[u8]) -> Option<Tree> {
+        let length = u32::try_from(data.len()).ok()?;
+        unsafe {
+            let c_tree =
+                ffi::ts_tree_deserialize(language.0, data.as_ptr() as *const c_char, length);
+            NonNull::new(c_tree).map(Tree)
+        }
+    }
+
+    /// Delete the syntax tree without freeing the memory that it used.
+    ///
+    /// The tree's nodes are queued to be freed later by [reclaim_step]. This
+    /// lets you drop very large trees without blocking the current thread.
+    #[doc(alias = "ts_tree_delete_deferred")]
+    pub fn drop_deferred(self) {
+        unsafe { ffi::ts_tree_delete_deferred(self.0.as_ptr()) };
+        mem::forget(self);
+    }
+
+    /// Delete the syntax tree, freeing the memory that it used on a background
+    /// thread.
+    pub fn drop_in_background(self) {
+        self.drop_deferred();
+        if !RECLAIMING_IN_BACKGROUND.swap(true, atomic::Ordering::SeqCst) {
+            thread::spawn(reclaim_in_background);
+        }
+    }
+
     /// Print a graph of the tree to the given file descriptor.
     /// The graph is formatted in the DOT language. You may want to pipe this graph
     /// directly to a `dot(1)` process in order to generate SVG output.
@@ -1161,6 +1683,9 @@ impl<'tree> Node<'tree> {
     }
 
     /// Get this node's immediate parent.
+    ///
+    /// Unless the tree's parents have been indexed using [Tree::index_parents],
+    /// this searches down from the root of the tree.
     #[doc(alias = "ts_node_parent")]
     pub fn parent(&self) -> Option<Self> {
         Self::new(unsafe { ffi::ts_node_parent(self.0) })
@@ -1239,6 +1764,41 @@ impl<'tree> Node<'tree> {
         result
     }
 
+    /// Write an S-expression representing this node to the given output, in
+    /// pieces, without building the whole string in memory.
+    ///
+    /// With the default options, the output is the same as the string
+    /// returned by [to_sexp](Node::to_sexp).
+    #[doc(alias = "ts_node_write_sexp")]
+    pub fn write_sexp(&self, options: SexpOptions, output: &mut impl io::Write) -> io::Result<()> {
+        let options = ffi::TSSexpOptions {
+            include_ranges: options.include_ranges,
+            indent: options.indent,
+            node_types: options.node_types,
+        };
+        write_to_output(output, |writer| unsafe {
+            ffi::ts_node_write_sexp(self.0, options, writer)
+        })
+    }
+
+    /// Write an XML document representing this node to the given output, in
+    /// pieces, without building the whole string in memory.
+    ///
+    /// The `source` must be the UTF-8 text that the tree was parsed from. The
+    /// entire text of each node without any visible descendants is written
+    /// within the element of its nearest named ancestor.
+    #[doc(alias = "ts_node_write_xml")]
+    pub fn write_xml(&self, source: &[u8], output: &mut impl io::Write) -> io::Result<()> {
+        write_to_output(output, |writer| unsafe {
+            ffi::ts_node_write_xml(
+                self.0,
+                source.as_ptr() as *const c_char,
+                source.len().min(u32::MAX as usize) as u32,
+                writer,
+            )
+        })
+    }
+
     pub fn utf8_text<'a>(&self, source: &'a [u8]) -> Result<&'a str, str::Utf8Error> {
         str::from_utf8(&source[self.start_byte()..self.end_byte()])
     }
@@ -1390,6 +1950,42 @@ impl<'cursor> TreeCursor<'cursor> {
         };
     }
 
+    /// Move this cursor to the next node in pre-order, after its current node,
+    /// whose kind is one of the given kind ids. If no kind ids are given, any
+    /// node matches. If `named_only` is true, only named nodes match. If
+    /// `skip_children` is true, the current node's descendants are skipped.
+    ///
+    /// This is much faster than visiting every node with the other cursor
+    /// methods, because subtrees that can't contain any of the kinds are
+    /// skipped.
+    ///
+    /// This returns `true` if a matching node was found. Otherwise, it returns
+    /// `false`, and the cursor is moved back to the node that it was
+    /// constructed with.
+    #[doc(alias = "ts_tree_cursor_next_matching")]
+    pub fn goto_next_matching(
+        &mut self,
+        kind_ids: &[u16],
+        named_only: bool,
+        skip_children: bool,
+    ) -> bool {
+        let mut flags = 0;
+        if named_only {
+            flags |= ffi::TSTreeCursorMatchFlag_TSTreeCursorMatchNamed;
+        }
+        if skip_children {
+            flags |= ffi::TSTreeCursorMatchFlag_TSTreeCursorMatchSkipChildren;
+        }
+        unsafe {
+            ffi::ts_tree_cursor_next_matching(
+                &mut self.0,
+                kind_ids.as_ptr(),
+                kind_ids.len() as u32,
+                flags,
+            )
+        }
+    }
+
     /// Move this cursor to the previous sibling of its current node.
     ///
     /// This returns `true` if the cursor successfully moved, and returns
@@ -2474,6 +3070,66 @@ impl From<ffi::TSRange> for Range {
     }
 }
 
+impl TraceEventType {
+    /// Get the event type with the given numeric value, as stored in a
+    /// `TSTraceEvent`.
+    pub fn from_u16(value: u16) -> Option<Self> {
+        const TYPES: [TraceEventType; 19] = [
+            TraceEventType::NewParse,
+            TraceEventType::ParseAfterEdit,
+            TraceEventType::ResumeParsing,
+            TraceEventType::ProcessVersion,
+            TraceEventType::LexedLookahead,
+            TraceEventType::ReuseNode,
+            TraceEventType::BreakdownTopOfStack,
+            TraceEventType::Shift,
+            TraceEventType::ShiftExtra,
+            TraceEventType::Reduce,
+            TraceEventType::Accept,
+            TraceEventType::DetectError,
+            TraceEventType::RecoverToPrevious,
+            TraceEventType::RecoverWithMissing,
+            TraceEventType::RecoverEof,
+            TraceEventType::SkipToken,
+            TraceEventType::Resume,
+            TraceEventType::Condense,
+            TraceEventType::Done,
+        ];
+        TYPES.get(value as usize).copied()
+    }
+}
+
+impl From<ffi::TSTraceEvent> for TraceEvent {
+    fn from(event: ffi::TSTraceEvent) -> Self {
+        Self {
+            event_type: TraceEventType::from_u16(event.type_).expect("Invalid trace event type"),
+            state: event.state,
+            symbol: event.symbol,
+            version: event.version as usize,
+            byte: event.byte as usize,
+            value: event.value,
+        }
+    }
+}
+
+impl From<ffi::TSParserStats> for ParserStats {
+    fn from(stats: ffi::TSParserStats) -> Self {
+        Self {
+            lex_count: stats.lex_count as usize,
+            lexed_byte_count: stats.lexed_byte_count as usize,
+            shift_count: stats.shift_count as usize,
+            reduce_count: stats.reduce_count as usize,
+            max_version_count: stats.max_version_count as usize,
+            reused_subtree_count: stats.reused_subtree_count as usize,
+            reused_byte_count: stats.reused_byte_count as usize,
+            recover_count: stats.recover_count as usize,
+            subtree_allocation_count: stats.subtree_allocation_count as usize,
+            token_cache_hit_count: stats.token_cache_hit_count as usize,
+            token_cache_miss_count: stats.token_cache_miss_count as usize,
+        }
+    }
+}
+
 impl Into<ffi::TSInputEdit> for &'_ InputEdit {
     fn into(self) -> ffi::TSInputEdit {
         ffi::TSInputEdit {
@@ -2533,6 +3189,42 @@ impl<'a> Iterator for LossyUtf8<'a> {
     }
 }
 
+// Call a library function that produces its output through a `TSWriter`,
+// forwarding the output to `output`. If writing fails, the library function
+// stops, and the error is returned.
+fn write_to_output(
+    output: &mut dyn io::Write,
+    f: impl FnOnce(ffi::TSWriter) -> bool,
+) -> io::Result<()> {
+    struct Payload<'a> {
+        output: &'a mut dyn io::Write,
+        error: Option<io::Error>,
+    }
+
+    unsafe extern "C" fn write(payload: *mut c_void, data: *const c_char, length: u32) -> bool {
+        let payload = (payload as *mut Payload).as_mut().unwrap();
+        let data = slice::from_raw_parts(data as *const u8, length as usize);
+        match payload.output.write_all(data) {
+            Ok(()) => true,
+            Err(error) => {
+                payload.error = Some(error);
+                false
+            }
+        }
+    }
+
+    let mut payload = Payload {
+        output,
+        error: None,
+    };
+    let writer = ffi::TSWriter {
+        payload: &mut payload as *mut Payload as *mut c_void,
+        write: Some(write),
+    };
+    f(writer);
+    payload.error.map_or(Ok(()), Err)
+}
+
 fn predicate_error(row: usize, message: String) -> QueryError {
     QueryError {
         kind: QueryErrorKind::Predicate,
@@ -2585,6 +3277,51 @@ impl fmt::Display for QueryError {
     }
 }
 
+/// The maximum number of nodes that the background thread frees at a time.
+const BACKGROUND_RECLAIM_BUDGET: u32 = 4096;
+
+/// How long the background thread waits when another thread is freeing memory.
+const BACKGROUND_RECLAIM_BACKOFF: Duration = Duration::from_millis(1);
+
+static RECLAIMING_IN_BACKGROUND: AtomicBool = AtomicBool::new(false);
+
+/// Free some of the memory used by syntax trees that were deleted with
+/// [Tree::drop_deferred].
+///
+/// At most `budget` nodes are freed. If the result is
+/// [ReclaimStatus::Pending], this function should be called again. If it is
+/// [ReclaimStatus::Busy], another thread is already freeing memory, and
+/// callers that loop should wait before calling it again.
+#[doc(alias = "ts_reclaim_step")]
+pub fn reclaim_step(budget: u32) -> ReclaimStatus {
+    match unsafe { ffi::ts_reclaim_step(budget) } {
+        ffi::TSReclaimStatus_TSReclaimStatusDone => ReclaimStatus::Done,
+        ffi::TSReclaimStatus_TSReclaimStatusPending => ReclaimStatus::Pending,
+        _ => ReclaimStatus::Busy,
+    }
+}
+
+fn reclaim_in_background() {
+    loop {
+        loop {
+            match reclaim_step(BACKGROUND_RECLAIM_BUDGET) {
+                ReclaimStatus::Done => break,
+                ReclaimStatus::Pending => {}
+                ReclaimStatus::Busy => thread::sleep(BACKGROUND_RECLAIM_BACKOFF),
+            }
+        }
+        RECLAIMING_IN_BACKGROUND.store(false, atomic::Ordering::SeqCst);
+
+        // A tree may have been dropped after the last step, but before the flag
+        // was cleared, in which case no other thread was started to free it.
+        if reclaim_step(0) == ReclaimStatus::Done
+            || RECLAIMING_IN_BACKGROUND.swap(true, atomic::Ordering::SeqCst)
+        {
+            break;
+        }
+    }
+}
+
 extern "C" {
     fn free(ptr: *mut c_void);
 }
@@ -0,0 +1,229 @@
+use super::{Language, Parser, Tree};
+use std::{
+    collections::{hash_map::Entry, HashMap, VecDeque},
+    sync::{
+        atomic::{AtomicU64, AtomicUsize, Ordering},
+        mpsc, Arc, Condvar, Mutex,
+    },
+    thread,
+};
+
+/// A set of threads that parse documents in the background.
+///
+/// Each thread keeps a [Parser] for every [Language] that it has parsed, so
+/// that parsers are reused from one document to the next. Documents are
+/// distributed across the threads' queues as they are submitted. When a thread
+/// runs out of documents to parse, it takes documents from the other threads'
+/// queues, so that all of the threads stay busy until all of the documents
+/// have been parsed.
+pub struct ParserPool {
+    shared: Arc<Shared>,
+    threads: Vec<thread::JoinHandle<()>>,
+    next_queue_index: AtomicUsize,
+}
+
+/// A document that has been submitted to a [ParserPool] for parsing.
+pub struct ParseJob {
+    result: mpsc::Receiver<Option<Tree>>,
+    cancellation_flag: Arc<AtomicUsize>,
+}
+
+struct Job {
+    language: Language,
+    text: Box<dyn AsRef<[u8]> + Send>,
+    old_tree: Option<Tree>,
+    timeout_micros: u64,
+    cancellation_flag: Arc<AtomicUsize>,
+    result: mpsc::SyncSender<Option<Tree>>,
+}
+
+struct Shared {
+    queues: Vec<Mutex<VecDeque<Job>>>,
+    state: Mutex<State>,
+    job_available: Condvar,
+    timeout_micros: AtomicU64,
+}
+
+struct State {
+    // The number of jobs in the queues that have not yet been claimed by a thread.
+    unclaimed_job_count: usize,
+    is_shutting_down: bool,
+}
+
+impl ParserPool {
+    /// Create a new pool that parses documents on the given number of threads.
+    pub fn new(thread_count: usize) -> Self {
+        let thread_count = thread_count.max(1);
+        let shared = Arc::new(Shared {
+            queues: (0..thread_count).map(|_| Default::default()).collect(),
+            state: Mutex::new(State {
+                unclaimed_job_count: 0,
+                is_shutting_down: false,
+            }),
+            job_available: Condvar::new(),
+            timeout_micros: AtomicU64::new(0),
+        });
+        let threads = (0..thread_count)
+            .map(|index| {
+                let shared = shared.clone();
+                thread::spawn(move || shared.run(index))
+            })
+            .collect();
+        ParserPool {
+            shared,
+            threads,
+            next_queue_index: AtomicUsize::new(0),
+        }
+    }
+
+    /// Get the number of threads that this pool uses to parse documents.
+    pub fn thread_count(&self) -> usize {
+        self.threads.len()
+    }
+
+    /// Get the duration in microseconds that parsing each document is allowed
+    /// to take.
+    pub fn timeout_micros(&self) -> u64 {
+        self.shared.timeout_micros.load(Ordering::SeqCst)
+    }
+
+    /// Set the maximum duration in microseconds that parsing each document
+    /// should be allowed to take before halting. This applies to documents that
+    /// are submitted after it is set.
+    ///
+    /// See [Parser::set_timeout_micros] for more information.
+    pub fn set_timeout_micros(&self, timeout_micros: u64) {
+        self.shared
+            .timeout_micros
+            .store(timeout_micros, Ordering::SeqCst);
+    }
+
+    /// Submit a document to be parsed on one of the pool's threads.
+    ///
+    /// # Arguments:
+    /// * `language` The language of the document.
+    /// * `text` The UTF8-encoded text of the document.
+    /// * `old_tree` A previous syntax tree parsed from the same document.
+    ///   If the text of the document has changed since `old_tree` was
+    ///   created, then you must edit `old_tree` to match the new text using
+    ///   [Tree::edit].
+    ///
+    /// Returns a [ParseJob], which can be used to wait for the resulting tree,
+    /// or to cancel the parse.
+    pub fn parse(
+        &self,
+        language: Language,
+        text: impl AsRef<[u8]> + Send + 'static,
+        old_tree: Option<Tree>,
+    ) -> ParseJob {
+        let (sender, receiver) = mpsc::sync_channel(1);
+        let cancellation_flag = Arc::new(AtomicUsize::new(0));
+        let job = Job {
+            language,
+            text: Box::new(text),
+            old_tree,
+            timeout_micros: self.timeout_micros(),
+            cancellation_flag: cancellation_flag.clone(),
+            result: sender,
+        };
+
+        let queue_count = self.shared.queues.len();
+        let index = self.next_queue_index.fetch_add(1, Ordering::Relaxed) % queue_count;
+        self.shared.queues[index].lock().unwrap().push_back(job);
+        self.shared.state.lock().unwrap().unclaimed_job_count += 1;
+        self.shared.job_available.notify_one();
+
+        ParseJob {
+            result: receiver,
+            cancellation_flag,
+        }
+    }
+}
+
+impl Drop for ParserPool {
+    fn drop(&mut self) {
+        self.shared.state.lock().unwrap().is_shutting_down = true;
+        self.shared.job_available.notify_all();
+        for thread in self.threads.drain(..) {
+            thread.join().unwrap();
+        }
+    }
+}
+
+impl ParseJob {
+    /// Stop parsing the document, if it has not already been parsed.
+    pub fn cancel(&self) {
+        self.cancellation_flag.store(1, Ordering::SeqCst);
+    }
+
+    /// Wait for the document to be parsed.
+    ///
+    /// Returns a [Tree] if parsing succeeded, or `None` if:
+    ///  * The parse was cancelled with [ParseJob::cancel]
+    ///  * The timeout set with [ParserPool::set_timeout_micros] expired
+    ///  * The document's language is not compatible with this library
+    ///  * The pool was dropped before the document was parsed
+    pub fn wait(self) -> Option<Tree> {
+        self.result.recv().ok().flatten()
+    }
+}
+
+impl Shared {
+    fn run(&self, index: usize) {
+        let mut parsers = HashMap::new();
+        while let Some(job) = self.claim_job(index) {
+            let parser = match parsers.entry(job.language) {
+                Entry::Occupied(entry) => entry.into_mut(),
+                Entry::Vacant(entry) => {
+                    let mut parser = Parser::new();
+                    if parser.set_language(job.language).is_err() {
+                        job.result.send(None).ok();
+                        continue;
+                    }
+                    entry.insert(parser)
+                }
+            };
+
+            parser.set_timeout_micros(job.timeout_micros);
+            unsafe { parser.set_cancellation_flag(Some(&job.cancellation_flag)) };
+            let tree = parser.parse((*job.text).as_ref(), job.old_tree.as_ref());
+            unsafe { parser.set_cancellation_flag(None) };
+
+            // Don't resume this document's parse when parsing the next one.
+            if tree.is_none() {
+                parser.reset();
+            }
+            job.result.send(tree).ok();
+        }
+    }
+
+    fn claim_job(&self, index: usize) -> Option<Job> {
+        let mut state = self.state.lock().unwrap();
+        while state.unclaimed_job_count == 0 && !state.is_shutting_down {
+            state = self.job_available.wait(state).unwrap();
+        }
+        if state.is_shutting_down {
+            return None;
+        }
+        state.unclaimed_job_count -= 1;
+        drop(state);
+
+        // There is at least one job in the queues for each thread that has
+        // claimed one. Take the oldest job from this thread's own queue, or
+        // otherwise, take the newest job from another thread's queue.
+        let queue_count = self.queues.len();
+        loop {
+            for i in 0..queue_count {
+                let mut queue = self.queues[(index + i) % queue_count].lock().unwrap();
+                let job = if i == 0 {
+                    queue.pop_front()
+                } else {
+                    queue.pop_back()
+                };
+                if job.is_some() {
+                    return job;
+                }
+            }
+        }
+    }
+}
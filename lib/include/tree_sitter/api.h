@@ -20,7 +20,7 @@ extern "C" {
  * The Tree-sitter library is generally backwards-compatible with languages
  * generated using older CLI versions, but is not forwards-compatible.
  */
-#define TREE_SITTER_LANGUAGE_VERSION 14
+#define TREE_SITTER_LANGUAGE_VERSION 15
 
 /**
  * The earliest ABI version that is supported by the current version of the
@@ -71,6 +71,18 @@ typedef struct {
   TSInputEncoding encoding;
 } TSInput;
 
+typedef enum {
+  TSParseStatusComplete,
+  TSParseStatusIncomplete,
+  TSParseStatusFailed,
+} TSParseStatus;
+
+typedef enum {
+  TSReclaimStatusDone,
+  TSReclaimStatusPending,
+  TSReclaimStatusBusy,
+} TSReclaimStatus;
+
 typedef enum {
   TSLogTypeParse,
   TSLogTypeLex,
@@ -81,6 +93,57 @@ typedef struct {
   void (*log)(void *payload, TSLogType, const char *);
 } TSLogger;
 
+typedef enum {
+  TSTraceEventTypeNewParse,
+  TSTraceEventTypeParseAfterEdit,
+  TSTraceEventTypeResumeParsing,
+  TSTraceEventTypeProcessVersion,
+  TSTraceEventTypeLexedLookahead,
+  TSTraceEventTypeReuseNode,
+  TSTraceEventTypeBreakdownTopOfStack,
+  TSTraceEventTypeShift,
+  TSTraceEventTypeShiftExtra,
+  TSTraceEventTypeReduce,
+  TSTraceEventTypeAccept,
+  TSTraceEventTypeDetectError,
+  TSTraceEventTypeRecoverToPrevious,
+  TSTraceEventTypeRecoverWithMissing,
+  TSTraceEventTypeRecoverEof,
+  TSTraceEventTypeSkipToken,
+  TSTraceEventTypeResume,
+  TSTraceEventTypeCondense,
+  TSTraceEventTypeDone,
+} TSTraceEventType;
+
+typedef struct {
+  uint16_t type;
+  TSStateId state;
+  TSSymbol symbol;
+  uint16_t version;
+  uint32_t byte;
+  uint32_t value;
+} TSTraceEvent;
+
+typedef struct {
+  TSTraceEvent *events;
+  uint32_t capacity;
+  uint64_t event_count;
+} TSTraceBuffer;
+
+typedef struct {
+  uint32_t lex_count;
+  uint32_t lexed_byte_count;
+  uint32_t shift_count;
+  uint32_t reduce_count;
+  uint32_t max_version_count;
+  uint32_t reused_subtree_count;
+  uint32_t reused_byte_count;
+  uint32_t recover_count;
+  uint32_t subtree_allocation_count;
+  uint32_t token_cache_hit_count;
+  uint32_t token_cache_miss_count;
+} TSParserStats;
+
 typedef struct {
   uint32_t start_byte;
   uint32_t old_end_byte;
@@ -102,6 +165,54 @@ typedef struct {
   uint32_t context[2];
 } TSTreeCursor;
 
+typedef struct {
+  void *payload;
+  void (*emit)(void *payload, TSNode node);
+} TSNodeStream;
+
+typedef enum {
+  TSTreeCursorMatchNamed = 1 << 0,
+  TSTreeCursorMatchSkipChildren = 1 << 1,
+} TSTreeCursorMatchFlag;
+
+typedef enum {
+  TSFlatNodeFlagNamed = 1 << 0,
+  TSFlatNodeFlagExtra = 1 << 1,
+  TSFlatNodeFlagMissing = 1 << 2,
+  TSFlatNodeFlagHasError = 1 << 3,
+} TSFlatNodeFlag;
+
+typedef struct {
+  bool named_only;
+  uint32_t max_depth;
+} TSTreeExportOptions;
+
+typedef struct {
+  uint32_t capacity;
+  uint32_t node_count;
+  TSSymbol *symbols;
+  uint32_t *start_bytes;
+  uint32_t *end_bytes;
+  TSPoint *start_points;
+  TSPoint *end_points;
+  uint32_t *parents;
+  uint32_t *first_children;
+  uint32_t *next_siblings;
+  TSFieldId *field_ids;
+  uint8_t *flags;
+} TSFlatTree;
+
+typedef struct {
+  void *payload;
+  bool (*write)(void *payload, const char *data, uint32_t length);
+} TSWriter;
+
+typedef struct {
+  bool include_ranges;
+  bool indent;
+  bool node_types;
+} TSSexpOptions;
+
 typedef struct {
   TSNode node;
   uint32_t index;
@@ -284,6 +395,114 @@ TSTree *ts_parser_parse_string_encoding(
   TSInputEncoding encoding
 );
 
+/**
+ * Use the parser to parse some source code, doing at most a limited amount of
+ * work before returning, so that parsing a large document can be interleaved
+ * with other work on the same thread.
+ *
+ * The `old_tree` and `input` parameters work the same as in `ts_parser_parse`.
+ * The `operation_budget` parameter is the number of parse actions that this
+ * call may perform. The budget is only checked after each stack version has
+ * advanced by one token, so a call can slightly exceed it. The final call,
+ * which assembles the syntax tree, takes longer than the others.
+ *
+ * This function returns:
+ * 1. `TSParseStatusComplete` if parsing has finished. The resulting syntax
+ *    tree is written to `tree`.
+ * 2. `TSParseStatusIncomplete` if the budget was used up before parsing
+ *    finished, or if parsing was halted by the parser's timeout or
+ *    cancellation flag. Call this function again with the same arguments to
+ *    continue parsing, or call `ts_parser_reset` to discard the parse.
+ * 3. `TSParseStatusFailed` if the parser does not have a language assigned.
+ *
+ * If `progress_bytes` is not `NULL`, then the number of bytes of the input
+ * that have been parsed so far is written to it. This never decreases from
+ * one call to the next, so it can be used to report progress.
+ */
+TSParseStatus ts_parser_parse_step(
+  TSParser *self,
+  const TSTree *old_tree,
+  TSInput input,
+  uint32_t operation_budget,
+  TSTree **tree,
+  uint32_t *progress_bytes
+);
+
+/**
+ * Use the parser to parse some UTF8 source code stored in one contiguous
+ * buffer, doing at most a limited amount of work before returning. The
+ * `string` and `length` parameters work the same as in
+ * `ts_parser_parse_string`, and the other parameters and the return value
+ * work the same as in `ts_parser_parse_step`.
+ */
+TSParseStatus ts_parser_parse_string_step(
+  TSParser *self,
+  const TSTree *old_tree,
+  const char *string,
+  uint32_t length,
+  uint32_t operation_budget,
+  TSTree **tree,
+  uint32_t *progress_bytes
+);
+
+/**
+ * Use the parser to parse a sequence of independent documents, each stored
+ * as UTF8 text in a contiguous buffer.
+ *
+ * This is equivalent to calling `ts_parser_parse_string` once for each of the
+ * `count` documents, without an old tree. The `strings` and `lengths` arrays
+ * contain each document's text and its length in bytes. Because the text is
+ * contiguous, the lexer reads it directly, without going through a `TSInput`
+ * callback. The parser also keeps its internal buffers between documents, so
+ * parsing many small documents this way avoids most of the cost of setting up
+ * each parse.
+ *
+ * The resulting trees are written to `trees`, which must have room for
+ * `count` trees. If `parse_times_micros` is not `NULL`, then the time spent
+ * parsing each document is written to it, in microseconds.
+ *
+ * Returns the number of documents that were parsed. This is less than `count`
+ * if parsing was halted by the parser's timeout or cancellation flag. In that
+ * case, the next document's tree is `NULL`, and its parse can be resumed by
+ * passing the same text to `ts_parser_parse_string`, or discarded using
+ * `ts_parser_reset`.
+ */
+uint32_t ts_parser_parse_batch(
+  TSParser *self,
+  const char *const *strings,
+  const uint32_t *lengths,
+  uint32_t count,
+  TSTree **trees,
+  uint64_t *parse_times_micros
+);
+
+/**
+ * Use the parser to parse some UTF8 source code stored in one contiguous
+ * buffer, using up to `thread_count` threads, including the current one.
+ *
+ * The input is split into chunks at line boundaries, and each chunk is
+ * parsed on its own thread. The chunks' trees are then combined into a single
+ * syntax tree by reparsing the whole input on the current thread, reusing the
+ * chunks' nodes wherever they are valid in their actual context. Except for
+ * the way that syntax errors are recovered from, the resulting tree is the
+ * same as the one produced by `ts_parser_parse_string`.
+ *
+ * This is only worthwhile for very large inputs. Small inputs, inputs for
+ * languages with external scanners, and parsers with included ranges are
+ * parsed normally on the current thread.
+ *
+ * If parsing is halted by the parser's timeout or cancellation flag, then
+ * this function returns `NULL`. If that happens while the chunks are being
+ * parsed, their progress is discarded. Otherwise, calling this function again
+ * resumes parsing, like `ts_parser_parse`.
+ */
+TSTree *ts_parser_parse_parallel(
+  TSParser *self,
+  const char *string,
+  uint32_t length,
+  uint32_t thread_count
+);
+
 /**
  * Instruct the parser to start the next parse from the beginning.
  *
@@ -309,6 +528,29 @@ void ts_parser_set_timeout_micros(TSParser *self, uint64_t timeout);
  */
 uint64_t ts_parser_timeout_micros(const TSParser *self);
 
+/**
+ * Set the maximum amount of work that the parser should spend exploring
+ * different ways of recovering from each region of invalid input.
+ *
+ * Each token that the parser processes while recovering from an error, and
+ * each alternative interpretation that it tries, costs one unit of this
+ * budget. Once the budget for a region of invalid input is spent, the parser
+ * switches to a cheaper strategy: it skips tokens until it reaches one that
+ * would be valid in some enclosing construct, and resumes parsing there. The
+ * budget is restored once the parser is back to parsing valid input. Unlike
+ * a timeout, this always produces a tree, although the ERROR nodes in it may
+ * be larger than they would be otherwise.
+ *
+ * A budget of zero, which is the default, means that error recovery is not
+ * limited.
+ */
+void ts_parser_set_recovery_budget(TSParser *self, uint32_t budget);
+
+/**
+ * Get the parser's recovery budget.
+ */
+uint32_t ts_parser_recovery_budget(const TSParser *self);
+
 /**
  * Set the parser's current cancellation flag pointer.
  *
@@ -323,6 +565,30 @@ void ts_parser_set_cancellation_flag(TSParser *self, const size_t *flag);
  */
 const size_t *ts_parser_cancellation_flag(const TSParser *self);
 
+/**
+ * Set whether the parser should allocate the nodes of the trees that it
+ * produces from arenas.
+ *
+ * When this is enabled, each parse allocates its nodes from a set of large
+ * slabs, instead of allocating them individually. Deleting the resulting tree
+ * with `ts_tree_delete` frees these slabs all at once, which is much cheaper
+ * than freeing every node. This is most useful when parsing many short-lived
+ * documents.
+ *
+ * Trees produced this way can still be edited and passed as the old tree to
+ * `ts_parser_parse`. Memory that is shared between an old tree and a new tree
+ * is kept alive until both trees have been deleted. This means that a long
+ * sequence of incremental parses can hold onto the memory of many previous
+ * trees, so after a number of consecutive incremental parses, the parser will
+ * occasionally parse the document from scratch to let that memory be freed.
+ */
+void ts_parser_set_arena_allocation(TSParser *self, bool enabled);
+
+/**
+ * Get whether the parser allocates the nodes of its trees from arenas.
+ */
+bool ts_parser_arena_allocation(const TSParser *self);
+
 /**
  * Set the logger that a parser should use during parsing.
  *
@@ -345,6 +611,101 @@ TSLogger ts_parser_logger(const TSParser *self);
  */
 void ts_parser_print_dot_graphs(TSParser *self, int file);
 
+/**
+ * Get counters describing the work that the parser did during the most recent
+ * parse: how many times it ran the lexer and how many bytes the lexer read,
+ * how many shift and reduce actions it performed, the largest number of stack
+ * versions that it tracked at once, how many subtrees (and bytes) it reused
+ * from the old tree, how many times it attempted to recover from an error,
+ * and how many subtrees it allocated. The token cache counters record how
+ * often the parser reused a token that another stack version had already
+ * lexed at the same position, and how often it had to run the lexer instead.
+ *
+ * These counters are always maintained, so unlike the logger, they can be
+ * used to diagnose slow parses without affecting performance. If a parse is
+ * resumed after a timeout or cancellation, the counters include the work
+ * done before the parse was halted.
+ */
+void ts_parser_stats(const TSParser *self, TSParserStats *stats);
+
+/**
+ * Set a buffer into which the parser should write a fixed-size record of each
+ * significant event during parsing, such as lexing a token, or performing a
+ * shift or a reduction. This is much cheaper than logging, because nothing is
+ * formatted, so it can be left enabled in order to capture the events that
+ * led up to an unusually slow parse.
+ *
+ * The buffer is used as a ring: event number `n` is written to the index
+ * `n % capacity`, and the buffer's `event_count` is incremented. Once the
+ * buffer is full, the oldest events are overwritten. The caller retains
+ * ownership of the buffer, which must stay valid until it is replaced. Pass
+ * `NULL` to stop tracing.
+ *
+ * Each event's `value` depends on its type: the size of a lexed, reused or
+ * shifted node, the child count of a reduction, the stack depth of an error recovery,
+ * or the number of stack versions that were being processed.
+ */
+void ts_parser_set_trace_buffer(TSParser *self, TSTraceBuffer *buffer);
+
+/**
+ * Get the parser's current trace buffer.
+ */
+TSTraceBuffer *ts_parser_trace_buffer(const TSParser *self);
+
+/**
+ * Set a callback that the parser should call with each top-level node of the
+ * document as soon as that node is complete, while the rest of the document
+ * is still being parsed. This allows other work, like highlighting, to begin
+ * before parsing has finished.
+ *
+ * A top-level node is a visible child of the syntax tree's root node. It is
+ * considered complete once the parser has only one interpretation of the
+ * text up to the end of the node, and the node has been reduced into a
+ * repetition in the grammar's start rule. Any remaining top-level nodes are
+ * passed after the document has been fully parsed, just before
+ * `ts_parser_parse` returns. Each top-level node is passed exactly once, in
+ * document order, and it is identical to the corresponding child of the
+ * returned tree's root node. To guarantee this, error recovery never
+ * re-parses a node that has already been passed.
+ *
+ * The node is only valid for the duration of the call. Its descendants can be
+ * inspected, but its parent cannot. Pass a stream whose `emit` function is
+ * `NULL` to stop streaming.
+ */
+void ts_parser_set_node_stream(TSParser *self, TSNodeStream stream);
+
+/**
+ * Get the parser's current node stream.
+ */
+TSNodeStream ts_parser_node_stream(const TSParser *self);
+
+/**
+ * Set whether the parser should free the top-level nodes that it passes to
+ * its node stream (see `ts_parser_set_node_stream`) as soon as they have been
+ * passed, instead of keeping them in the tree that is being built.
+ *
+ * This bounds the parser's memory usage by the size of the largest top-level
+ * node, rather than the size of the whole document, so it can be used to
+ * parse very long inputs, like logs or sequences of JSON records. The tree
+ * that is returned still spans the entire document, but its root node only
+ * contains the top-level nodes that could not be streamed until the end of
+ * the parse. The tree can't be used for incremental parsing. While this is
+ * enabled, arena allocation is not used, because arenas are only freed when
+ * the entire tree is deleted.
+ *
+ * Error recovery takes into account how many nodes have been built since an
+ * error, and the freed nodes are no longer counted, so on invalid input the
+ * parser may occasionally recover from an error differently than it would
+ * otherwise.
+ */
+void ts_parser_set_discard_streamed_nodes(TSParser *self, bool discard);
+
+/**
+ * Get whether the parser frees the top-level nodes that it passes to its node
+ * stream.
+ */
+bool ts_parser_discard_streamed_nodes(const TSParser *self);
+
 /******************/
 /* Section - Tree */
 /******************/
@@ -362,6 +723,33 @@ TSTree *ts_tree_copy(const TSTree *self);
  */
 void ts_tree_delete(TSTree *self);
 
+/**
+ * Delete the syntax tree without freeing the memory that it used.
+ *
+ * Freeing a very large syntax tree means visiting every one of its nodes,
+ * which can take a noticeable amount of time. This function returns right
+ * away, and queues the tree's nodes to be freed later by `ts_reclaim_step`.
+ * This lets you delete trees on a latency-sensitive thread, and do the work
+ * of freeing them on another thread, or when the application is idle.
+ */
+void ts_tree_delete_deferred(TSTree *self);
+
+/**
+ * Free some of the memory used by syntax trees that were deleted with
+ * `ts_tree_delete_deferred`.
+ *
+ * At most `budget` nodes are freed. This function returns:
+ * 1. `TSReclaimStatusDone` if there is no more memory waiting to be freed.
+ * 2. `TSReclaimStatusPending` if there is more memory waiting to be freed, in
+ *    which case this function should be called again.
+ * 3. `TSReclaimStatusBusy` if this function is already running on another
+ *    thread. In that case, nothing was freed, and callers that loop should
+ *    wait before calling it again.
+ *
+ * This function can be called from any thread.
+ */
+TSReclaimStatus ts_reclaim_step(uint32_t budget);
+
 /**
  * Get the root node of the syntax tree.
  */
@@ -398,6 +786,18 @@ TSRange *ts_tree_included_ranges(const TSTree *, uint32_t *length);
  */
 void ts_tree_edit(TSTree *self, const TSInputEdit *edit);
 
+/**
+ * Build an index from each of the syntax tree's nodes to its parent, so that
+ * `ts_node_parent` and the sibling functions take constant time for the
+ * tree's nodes, instead of searching down from the root.
+ *
+ * Building the index takes time proportional to the size of the tree, and
+ * uses about 40 bytes per node, so it is only worthwhile when many parents
+ * or siblings will be requested. The index is discarded when the tree is
+ * edited. This function can be called while other threads are using the tree.
+ */
+void ts_tree_index_parents(const TSTree *self);
+
 /**
  * Compare an old edited syntax tree to a new syntax tree representing the same
  * document, returning an array of ranges whose syntactic structure has changed.
@@ -418,6 +818,66 @@ TSRange *ts_tree_get_changed_ranges(
   uint32_t *length
 );
 
+/**
+ * Serialize the syntax tree into a compact binary format, so that it can be
+ * stored and restored later using `ts_tree_deserialize` instead of parsing
+ * the document again.
+ *
+ * The format is versioned and doesn't depend on the host's byte order. It
+ * includes everything that the tree's nodes store, including the states of
+ * any external scanners, as well as the tree's included ranges.
+ *
+ * The returned buffer is allocated using `malloc` and the caller is
+ * responsible for freeing it using `free`. The length of the buffer will be
+ * written to the given `length` pointer.
+ */
+char *ts_tree_serialize(const TSTree *self, uint32_t *length);
+
+/**
+ * Restore a syntax tree that was serialized using `ts_tree_serialize`.
+ *
+ * The language must be the same one that the tree was parsed with. Returns
+ * `NULL` if it isn't, or if the data is truncated or was written using a
+ * different version of the format.
+ *
+ * The tree's nodes are rebuilt from the data, so the data doesn't need to
+ * outlive the call, and it can point directly into a memory-mapped file. All
+ * of the nodes are allocated together, so the tree is cheap to delete. It can
+ * be queried, and edited and passed as the `old_tree` for an incremental
+ * parse, just like the tree that was serialized.
+ */
+TSTree *ts_tree_deserialize(const TSLanguage *language, const char *data, uint32_t length);
+
+/**
+ * Export the syntax tree's nodes into flat arrays, so that they can be
+ * processed without calling a function for each node.
+ *
+ * The caller provides the arrays in the given `TSFlatTree`, each of which
+ * must have room for `capacity` elements. Any array can be `NULL`, in which
+ * case that property isn't exported. The nodes are written in document order,
+ * starting with the root node, and the entry at each index in the arrays
+ * describes the same node:
+ * - `symbols`: The node's symbol, as returned by `ts_node_symbol`.
+ * - `start_bytes`, `end_bytes`, `start_points` and `end_points`: The node's
+ *   range.
+ * - `parents`, `first_children` and `next_siblings`: The indices of other
+ *   exported nodes, or `UINT32_MAX` if there are none.
+ * - `field_ids`: The id of the field that the node is assigned within its
+ *   parent, or zero.
+ * - `flags`: A combination of `TSFlatNodeFlag` values.
+ *
+ * If the options' `named_only` flag is set, anonymous nodes are omitted, and
+ * their named descendants are exported as children of their nearest exported
+ * ancestor. If the options' `max_depth` is non-zero, nodes that are more than
+ * that many levels below the root are omitted.
+ *
+ * The output's `node_count` is set to the number of nodes that were exported.
+ * Returns `false` if that exceeds the capacity, in which case only the first
+ * `capacity` nodes are written, and the export can be retried with larger
+ * arrays.
+ */
+bool ts_tree_export(const TSTree *self, TSTreeExportOptions options, TSFlatTree *output);
+
 /**
  * Write a DOT graph describing the syntax tree to the given file.
  */
@@ -483,6 +943,51 @@ TSPoint ts_node_end_point(TSNode);
  */
 char *ts_node_string(TSNode);
 
+/**
+ * Write an S-expression representing the node, in pieces, using the given
+ * writer.
+ *
+ * Unlike `ts_node_string`, this does not build the whole string in memory, so
+ * it can be used to print very large trees. The `TSWriter`'s `write` function
+ * is called with successive chunks of the output, which are not
+ * null-terminated. It should return `false` if the chunk could not be written,
+ * in which case writing stops and this function returns `false`.
+ *
+ * With the default options, the output is identical to that of
+ * `ts_node_string`. The `TSSexpOptions` parameter has the following fields:
+ * 1. `include_ranges`: Write each node's start and end position after its
+ *    type, in the form `[row, column] - [row, column]`.
+ * 2. `indent`: Write each node on its own line, indented by two spaces per
+ *    level of nesting, instead of separating nodes with single spaces.
+ * 3. `node_types`: Write each node's type as returned by `ts_node_type`,
+ *    instead of writing error tokens as `UNEXPECTED` with the unexpected
+ *    character and missing tokens as `MISSING` with their type. Missing
+ *    anonymous tokens are omitted, like any other anonymous node. The
+ *    nesting and the field names are the same as those seen by a
+ *    `TSTreeCursor`.
+ */
+bool ts_node_write_sexp(TSNode self, TSSexpOptions options, TSWriter writer);
+
+/**
+ * Write an XML document representing the node, in pieces, using the given
+ * writer. The writer is used in the same way as in `ts_node_write_sexp`.
+ *
+ * Each named node is written as an element whose tag is the node's type,
+ * on its own line and indented by its depth. Each closing tag is followed by
+ * a newline. If the node is assigned a field within its parent, the field
+ * name is written as a `type` attribute. The entire text of each node without
+ * any visible descendants is written, with XML special characters escaped,
+ * within its nearest enclosing element. The text is taken from the `source`
+ * buffer, which must contain the UTF-8 source code that the tree was parsed
+ * from. Pass `NULL` to omit the text.
+ */
+bool ts_node_write_xml(
+  TSNode self,
+  const char *source,
+  uint32_t source_length,
+  TSWriter writer
+);
+
 /**
  * Check if the node is null. Functions like `ts_node_child` and
  * `ts_node_next_sibling` will return a null node to indicate that no such node
@@ -536,6 +1041,10 @@ TSStateId ts_node_next_parse_state(TSNode);
 
 /**
  * Get the node's immediate parent.
+ *
+ * Unless the tree's parents have been indexed using `ts_tree_index_parents`,
+ * this searches down from the root of the tree, so it takes time proportional
+ * to the node's depth. The same applies to the sibling functions below.
  */
 TSNode ts_node_parent(TSNode);
 
@@ -774,6 +1283,31 @@ uint32_t ts_tree_cursor_current_depth(const TSTreeCursor *);
 int64_t ts_tree_cursor_goto_first_child_for_byte(TSTreeCursor *, uint32_t);
 int64_t ts_tree_cursor_goto_first_child_for_point(TSTreeCursor *, TSPoint);
 
+/**
+ * Move the cursor to the next node in pre-order, after its current node,
+ * whose symbol is one of the given symbols. If no symbols are given, any
+ * node matches.
+ *
+ * The flags are a combination of `TSTreeCursorMatchFlag` values. With
+ * `TSTreeCursorMatchNamed`, only named nodes match. With
+ * `TSTreeCursorMatchSkipChildren`, the current node's descendants are
+ * skipped, so that matches nested within other matches can be skipped.
+ *
+ * The search is done without returning to the caller for each node, and
+ * skips any subtrees that can't contain one of the symbols, so it's much
+ * faster than visiting every node with the other cursor functions.
+ *
+ * This returns `true` if a matching node was found. Otherwise, it returns
+ * `false`, and the cursor is moved back to the original node that it was
+ * constructed with.
+ */
+bool ts_tree_cursor_next_matching(
+  TSTreeCursor *self,
+  const TSSymbol *symbols,
+  uint32_t symbol_count,
+  uint32_t flags
+);
+
 TSTreeCursor ts_tree_cursor_copy(const TSTreeCursor *);
 
 /*******************/
@@ -47,6 +47,7 @@ struct TSLexer {
   uint32_t (*get_column)(TSLexer *);
   bool (*is_at_included_range_start)(const TSLexer *);
   bool (*eof)(const TSLexer *);
+  void (*advance_while_in_set)(TSLexer *, const uint8_t *, bool);
 };
 
 typedef enum {
@@ -78,6 +79,42 @@ typedef struct {
   uint16_t external_lex_state;
 } TSLexMode;
 
+// A table-driven alternative to a generated lexing function. Characters are
+// grouped into classes that behave identically in every lex state. ASCII
+// characters are classified by a lookup table, and all other characters by a
+// list of ranges, sorted by their first character. Each state refers to a row
+// of `transitions`, which has one entry per character class. An entry of zero
+// means that there is no transition. Otherwise, it is the next state plus one,
+// with the `TS_LEX_TABLE_SKIP` bit set if the character is skipped rather than
+// consumed. A state that loops back to itself may also refer to a set of ASCII
+// characters that can be advanced over in bulk.
+#define TS_LEX_TABLE_SKIP 0x8000
+
+typedef struct {
+  uint16_t transition_row;
+  TSSymbol accept_symbol;
+  TSStateId eof_state;
+  uint16_t loop_set;
+  bool accepts;
+  bool has_eof_state;
+  bool has_loop_set;
+} TSLexTableState;
+
+typedef struct {
+  int32_t start;
+  uint16_t character_class;
+} TSCharacterClassRange;
+
+typedef struct {
+  const TSLexTableState *states;
+  const uint16_t *transitions;
+  const uint16_t *ascii_character_classes;
+  const TSCharacterClassRange *character_class_ranges;
+  const uint8_t (*ascii_sets)[16];
+  uint32_t character_class_range_count;
+  uint16_t character_class_count;
+} TSLexTable;
+
 typedef union {
   TSParseAction action;
   struct {
@@ -123,6 +160,9 @@ struct TSLanguage {
     void (*deserialize)(void *, const char *, unsigned);
   } external_scanner;
   const TSStateId *primary_state_ids;
+  const TSLexTable *lex_table;
+  const TSLexTable *keyword_lex_table;
+  const uint16_t *small_parse_table_masks;
 };
 
 /*
@@ -161,6 +201,23 @@ struct TSLanguage {
     goto next_state;      \
   }
 
+// A set of ASCII characters is represented as 16 bytes, indexed by the low
+// four bits of each character. Each byte's bits are indexed by the character's
+// high three bits.
+#define ADVANCE_WHILE_IN_SET(state_value, set)      \
+  {                                                 \
+    lexer->advance_while_in_set(lexer, set, false); \
+    state = state_value;                            \
+    goto start;                                     \
+  }
+
+#define SKIP_WHILE_IN_SET(state_value, set)        \
+  {                                                \
+    lexer->advance_while_in_set(lexer, set, true); \
+    state = state_value;                           \
+    goto start;                                    \
+  }
+
 #define ACCEPT_TOKEN(symbol_value)     \
   result = true;                       \
   lexer->result_symbol = symbol_value; \
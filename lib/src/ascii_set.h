@@ -0,0 +1,181 @@
+#ifndef TREE_SITTER_ASCII_SET_H_
+#define TREE_SITTER_ASCII_SET_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A set of ASCII characters, represented as 16 bytes that are indexed by the
+// low four bits of a character. The bits of each byte are indexed by the high
+// three bits of the character. This representation allows a block of bytes to
+// be classified at once using a pair of byte shuffles.
+
+#if defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#define TS_ASCII_SET_AVX2
+#elif defined(__GNUC__) && defined(__SSSE3__)
+#include <tmmintrin.h>
+#define TS_ASCII_SET_SSSE3
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <tmmintrin.h>
+#define TS_ASCII_SET_SSSE3
+#define TS_ASCII_SET_DETECT_SSSE3
+#elif defined(__GNUC__) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TS_ASCII_SET_NEON
+#endif
+
+static inline bool ts_ascii_set_contains(const uint8_t *self, int32_t c) {
+  return (uint32_t)c < 128 && (self[c & 15] >> (c >> 4)) & 1;
+}
+
+static inline uint32_t ts_ascii_set__scalar_prefix_length(
+  const uint8_t *self,
+  const uint8_t *string,
+  uint32_t length,
+  uint32_t i
+) {
+  while (i < length && ts_ascii_set_contains(self, string[i])) i++;
+  return i;
+}
+
+#if defined(TS_ASCII_SET_AVX2)
+
+static inline uint32_t ts_ascii_set_prefix_length(
+  const uint8_t *self,
+  const uint8_t *string,
+  uint32_t length
+) {
+  const __m256i low_bits = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)self));
+  const __m256i high_bits = _mm256_setr_epi8(
+    1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0
+  );
+  const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+  uint32_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    __m256i bytes = _mm256_loadu_si256((const __m256i *)(string + i));
+    __m256i low = _mm256_shuffle_epi8(low_bits, _mm256_and_si256(bytes, nibble_mask));
+    __m256i high = _mm256_shuffle_epi8(
+      high_bits,
+      _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble_mask)
+    );
+    __m256i excluded = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8(excluded);
+    if (mask) return i + (uint32_t)__builtin_ctz(mask);
+  }
+  return ts_ascii_set__scalar_prefix_length(self, string, length, i);
+}
+
+#elif defined(TS_ASCII_SET_SSSE3)
+
+#ifdef TS_ASCII_SET_DETECT_SSSE3
+__attribute__((target("ssse3")))
+#endif
+static inline uint32_t ts_ascii_set__ssse3_prefix_length(
+  const uint8_t *self,
+  const uint8_t *string,
+  uint32_t length
+) {
+  const __m128i low_bits = _mm_loadu_si128((const __m128i *)self);
+  const __m128i high_bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i nibble_mask = _mm_set1_epi8(0x0f);
+  uint32_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m128i bytes = _mm_loadu_si128((const __m128i *)(string + i));
+    __m128i low = _mm_shuffle_epi8(low_bits, _mm_and_si128(bytes, nibble_mask));
+    __m128i high = _mm_shuffle_epi8(high_bits, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble_mask));
+    __m128i excluded = _mm_cmpeq_epi8(_mm_and_si128(low, high), _mm_setzero_si128());
+    uint32_t mask = (uint32_t)_mm_movemask_epi8(excluded);
+    if (mask) return i + (uint32_t)__builtin_ctz(mask);
+  }
+  return ts_ascii_set__scalar_prefix_length(self, string, length, i);
+}
+
+#ifdef TS_ASCII_SET_DETECT_SSSE3
+
+// SSE2, which is all that is guaranteed on x86, has no byte shuffle. Check
+// whether SSSE3 is available the first time that it's needed.
+static inline bool ts_ascii_set__has_ssse3(void) {
+  static int8_t has_ssse3 = -1;
+  int8_t result = __atomic_load_n(&has_ssse3, __ATOMIC_RELAXED);
+  if (result < 0) {
+    unsigned a, b, c, d;
+    result = __get_cpuid(1, &a, &b, &c, &d) && (c & bit_SSSE3);
+    __atomic_store_n(&has_ssse3, result, __ATOMIC_RELAXED);
+  }
+  return result;
+}
+
+static inline uint32_t ts_ascii_set_prefix_length(
+  const uint8_t *self,
+  const uint8_t *string,
+  uint32_t length
+) {
+  if (ts_ascii_set__has_ssse3()) {
+    return ts_ascii_set__ssse3_prefix_length(self, string, length);
+  }
+  return ts_ascii_set__scalar_prefix_length(self, string, length, 0);
+}
+
+#else
+
+static inline uint32_t ts_ascii_set_prefix_length(
+  const uint8_t *self,
+  const uint8_t *string,
+  uint32_t length
+) {
+  return ts_ascii_set__ssse3_prefix_length(self, string, length);
+}
+
+#endif
+
+#elif defined(TS_ASCII_SET_NEON)
+
+static inline uint32_t ts_ascii_set_prefix_length(
+  const uint8_t *self,
+  const uint8_t *string,
+  uint32_t length
+) {
+  static const uint8_t HIGH_BITS[16] = {1, 2, 4, 8, 16, 32, 64, 128};
+  const uint8x16_t low_bits = vld1q_u8(self);
+  const uint8x16_t high_bits = vld1q_u8(HIGH_BITS);
+  const uint8x16_t nibble_mask = vdupq_n_u8(0x0f);
+  uint32_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    uint8x16_t bytes = vld1q_u8(string + i);
+    uint8x16_t low = vqtbl1q_u8(low_bits, vandq_u8(bytes, nibble_mask));
+    uint8x16_t high = vqtbl1q_u8(high_bits, vshrq_n_u8(bytes, 4));
+    uint8x16_t excluded = vceqq_u8(vandq_u8(low, high), vdupq_n_u8(0));
+
+    // Narrow the comparison result to four bits per byte.
+    uint64_t mask = vget_lane_u64(
+      vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(excluded), 4)),
+      0
+    );
+    if (mask) return i + ((uint32_t)__builtin_ctzll(mask) >> 2);
+  }
+  return ts_ascii_set__scalar_prefix_length(self, string, length, i);
+}
+
+#else
+
+static inline uint32_t ts_ascii_set_prefix_length(
+  const uint8_t *self,
+  const uint8_t *string,
+  uint32_t length
+) {
+  return ts_ascii_set__scalar_prefix_length(self, string, length, 0);
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_ASCII_SET_H_
@@ -1,6 +1,7 @@
 #ifndef TREE_SITTER_ATOMIC_H_
 #define TREE_SITTER_ATOMIC_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __TINYC__
@@ -9,6 +10,10 @@ static inline size_t atomic_load(const volatile size_t *p) {
   return *p;
 }
 
+static inline void *atomic_load_ptr(void *const volatile *p) {
+  return *p;
+}
+
 static inline uint32_t atomic_inc(volatile uint32_t *p) {
   *p += 1;
   return *p;
@@ -19,6 +24,18 @@ static inline uint32_t atomic_dec(volatile uint32_t *p) {
   return *p;
 }
 
+static inline bool atomic_compare_exchange(volatile uint32_t *p, uint32_t expected, uint32_t desired) {
+  if (*p != expected) return false;
+  *p = desired;
+  return true;
+}
+
+static inline bool atomic_compare_exchange_ptr(void *volatile *p, void *expected, void *desired) {
+  if (*p != expected) return false;
+  *p = desired;
+  return true;
+}
+
 #elif defined(_WIN32)
 
 #include <windows.h>
@@ -27,6 +44,10 @@ static inline size_t atomic_load(const volatile size_t *p) {
   return *p;
 }
 
+static inline void *atomic_load_ptr(void *const volatile *p) {
+  return *p;
+}
+
 static inline uint32_t atomic_inc(volatile uint32_t *p) {
   return InterlockedIncrement((long volatile *)p);
 }
@@ -35,6 +56,14 @@ static inline uint32_t atomic_dec(volatile uint32_t *p) {
   return InterlockedDecrement((long volatile *)p);
 }
 
+static inline bool atomic_compare_exchange(volatile uint32_t *p, uint32_t expected, uint32_t desired) {
+  return InterlockedCompareExchange((long volatile *)p, desired, expected) == (long)expected;
+}
+
+static inline bool atomic_compare_exchange_ptr(void *volatile *p, void *expected, void *desired) {
+  return InterlockedCompareExchangePointer(p, desired, expected) == expected;
+}
+
 #else
 
 static inline size_t atomic_load(const volatile size_t *p) {
@@ -45,6 +74,14 @@ static inline size_t atomic_load(const volatile size_t *p) {
 #endif
 }
 
+static inline void *atomic_load_ptr(void *const volatile *p) {
+#ifdef __ATOMIC_ACQUIRE
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+  return __sync_val_compare_and_swap((void *volatile *)p, NULL, NULL);
+#endif
+}
+
 static inline uint32_t atomic_inc(volatile uint32_t *p) {
   return __sync_add_and_fetch(p, 1U);
 }
@@ -53,6 +90,14 @@ static inline uint32_t atomic_dec(volatile uint32_t *p) {
   return __sync_sub_and_fetch(p, 1U);
 }
 
+static inline bool atomic_compare_exchange(volatile uint32_t *p, uint32_t expected, uint32_t desired) {
+  return __sync_bool_compare_and_swap(p, expected, desired);
+}
+
+static inline bool atomic_compare_exchange_ptr(void *volatile *p, void *expected, void *desired) {
+  return __sync_bool_compare_and_swap(p, expected, desired);
+}
+
 #endif
 
 #endif  // TREE_SITTER_ATOMIC_H_
@@ -49,6 +49,10 @@ static inline bool clock_is_gt(TSClock self, TSClock other) {
   return self > other;
 }
 
+static inline TSDuration clock_duration(TSClock start, TSClock end) {
+  return end > start ? end - start : 0;
+}
+
 #elif defined(CLOCK_MONOTONIC) && !defined(__APPLE__)
 
 // POSIX with monotonic clock support (Linux)
@@ -100,6 +104,13 @@ static inline bool clock_is_gt(TSClock self, TSClock other) {
   return self.tv_nsec > other.tv_nsec;
 }
 
+static inline TSDuration clock_duration(TSClock start, TSClock end) {
+  if (!clock_is_gt(end, start)) return 0;
+  return
+    (uint64_t)(end.tv_sec - start.tv_sec) * 1000000 +
+    (end.tv_nsec - start.tv_nsec) / 1000;
+}
+
 #else
 
 // macOS or POSIX without monotonic clock support
@@ -141,6 +152,10 @@ static inline bool clock_is_gt(TSClock self, TSClock other) {
   return self > other;
 }
 
+static inline TSDuration clock_duration(TSClock start, TSClock end) {
+  return end > start ? end - start : 0;
+}
+
 #endif
 
 #endif  // TREE_SITTER_CLOCK_H_
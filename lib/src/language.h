@@ -20,6 +20,7 @@ typedef struct {
   const TSLanguage *language;
   const uint16_t *data;
   const uint16_t *group_end;
+  const uint16_t *symbol_mask;
   TSStateId state;
   uint16_t table_value;
   uint16_t section_index;
@@ -66,13 +67,32 @@ static inline bool ts_language_has_reduce_action(
   return entry.action_count > 0 && entry.actions[0].type == TSParseActionTypeReduce;
 }
 
+static inline unsigned ts_language__popcount(uint16_t value) {
+#if defined(__POPCNT__)
+  return __builtin_popcount(value);
+#else
+  value = value - ((value >> 1) & 0x5555);
+  value = (value & 0x3333) + ((value >> 2) & 0x3333);
+  value = (value + (value >> 4)) & 0x0f0f;
+  return (value + (value >> 8)) & 0x1f;
+#endif
+}
+
+// The bitmasks of valid symbols for 'small' parse states, if the language
+// represents its small parse states that way.
+static inline const uint16_t *ts_language_small_parse_table_masks(const TSLanguage *self) {
+  return self->version >= 15 ? self->small_parse_table_masks : NULL;
+}
+
 // Lookup the table value for a given symbol and state.
 //
 // For non-terminal symbols, the table value represents a successor state.
 // For terminal symbols, it represents an index in the actions table.
 // For 'large' parse states, this is a direct lookup. For 'small' parse
-// states, this requires searching through the symbol groups to find
-// the given symbol.
+// states, the symbol's bit in the state's bitmask determines whether it
+// has a value, and the number of preceding bits determines where that
+// value is stored. Older languages instead list the symbols in groups,
+// which need to be searched for the given symbol.
 static inline uint16_t ts_language_lookup(
   const TSLanguage *self,
   TSStateId state,
@@ -81,6 +101,15 @@ static inline uint16_t ts_language_lookup(
   if (state >= self->large_state_count) {
     uint32_t index = self->small_parse_table_map[state - self->large_state_count];
     const uint16_t *data = &self->small_parse_table[index];
+    const uint16_t *masks = ts_language_small_parse_table_masks(self);
+    if (masks) {
+      if (symbol >= self->symbol_count) return 0;
+      uint32_t word_count = (self->symbol_count + 15) / 16;
+      const uint16_t *word = &masks[(data[0] * word_count + symbol / 16) * 2];
+      uint16_t bit = 1 << (symbol % 16);
+      if (!(word[0] & bit)) return 0;
+      return data[1 + word[1] + ts_language__popcount(word[0] & (bit - 1))];
+    }
     uint16_t group_count = *(data++);
     for (unsigned i = 0; i < group_count; i++) {
       uint16_t section_value = *(data++);
@@ -116,12 +145,18 @@ static inline LookaheadIterator ts_language_lookaheads(
   bool is_small_state = state >= self->large_state_count;
   const uint16_t *data;
   const uint16_t *group_end = NULL;
+  const uint16_t *symbol_mask = NULL;
   uint16_t group_count = 0;
   if (is_small_state) {
     uint32_t index = self->small_parse_table_map[state - self->large_state_count];
+    const uint16_t *masks = ts_language_small_parse_table_masks(self);
     data = &self->small_parse_table[index];
-    group_end = data + 1;
-    group_count = *data;
+    if (masks) {
+      symbol_mask = &masks[*data * ((self->symbol_count + 15) / 16) * 2];
+    } else {
+      group_end = data + 1;
+      group_count = *data;
+    }
   } else {
     data = &self->parse_table[state * self->symbol_count] - 1;
   }
@@ -129,6 +164,7 @@ static inline LookaheadIterator ts_language_lookaheads(
     .language = self,
     .data = data,
     .group_end = group_end,
+    .symbol_mask = symbol_mask,
     .group_count = group_count,
     .is_small_state = is_small_state,
     .symbol = UINT16_MAX,
@@ -137,10 +173,20 @@ static inline LookaheadIterator ts_language_lookaheads(
 }
 
 static inline bool ts_lookahead_iterator_next(LookaheadIterator *self) {
+  // For small parse states that are represented as bitmasks, visit
+  // each symbol whose bit is set. The values are stored in symbol order.
+  if (self->symbol_mask) {
+    do {
+      self->symbol++;
+      if (self->symbol >= self->language->symbol_count) return false;
+    } while (!(self->symbol_mask[self->symbol / 16 * 2] & (1 << (self->symbol % 16))));
+    self->table_value = *(++self->data);
+  }
+
   // For small parse states, valid symbols are listed explicitly,
   // grouped by their value. There's no need to look up the actions
   // again until moving to the next group.
-  if (self->is_small_state) {
+  else if (self->is_small_state) {
     self->data++;
     if (self->data == self->group_end) {
       if (self->group_count == 0) return false;
@@ -193,6 +239,16 @@ static inline bool ts_language_state_is_primary(
   }
 }
 
+// The table-driven forms of the language's lexers, if it uses them instead
+// of lexing functions.
+static inline const TSLexTable *ts_language_lex_table(const TSLanguage *self) {
+  return self->version >= 15 ? self->lex_table : NULL;
+}
+
+static inline const TSLexTable *ts_language_keyword_lex_table(const TSLanguage *self) {
+  return self->version >= 15 ? self->keyword_lex_table : NULL;
+}
+
 static inline const bool *ts_language_enabled_external_tokens(
   const TSLanguage *self,
   unsigned external_scanner_state
@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <string.h>
+#include "./ascii_set.h"
 #include "./lexer.h"
 #include "./subtree.h"
 #include "./length.h"
@@ -52,9 +54,24 @@ static void ts_lexer__clear_chunk(Lexer *self) {
   self->chunk_start = 0;
 }
 
-// Call the lexer's input callback to obtain a new chunk of source code
-// for the current position.
+// Obtain a new chunk of source code for the current position. If the
+// source code is stored in one contiguous buffer, then the chunk is the
+// entire buffer. Otherwise, call the lexer's input callback.
 static void ts_lexer__get_chunk(Lexer *self) {
+  if (self->input_string) {
+    if (self->current_position.bytes < self->input_string_length) {
+      self->chunk_start = 0;
+      self->chunk = self->input_string;
+      self->chunk_size = self->input_string_length;
+    } else {
+      self->chunk_start = self->current_position.bytes;
+      self->chunk = NULL;
+      self->chunk_size = 0;
+      self->current_included_range_index = self->included_range_count;
+    }
+    return;
+  }
+
   self->chunk_start = self->current_position.bytes;
   self->chunk = self->input.read(
     self->input.payload,
@@ -82,6 +99,12 @@ static void ts_lexer__get_lookahead(Lexer *self) {
   }
 
   const uint8_t *chunk = (const uint8_t *)self->chunk + position_in_chunk;
+  if (*chunk < 0x80 && self->input.encoding == TSInputEncodingUTF8) {
+    self->lookahead_size = 1;
+    self->data.lookahead = *chunk;
+    return;
+  }
+
   UnicodeDecodeFunction decode = self->input.encoding == TSInputEncodingUTF8
     ? ts_decode_utf8
     : ts_decode_utf16;
@@ -89,8 +112,9 @@ static void ts_lexer__get_lookahead(Lexer *self) {
   self->lookahead_size = decode(chunk, size, &self->data.lookahead);
 
   // If this chunk ended in the middle of a multi-byte character,
-  // try again with a fresh chunk.
-  if (self->data.lookahead == TS_DECODE_ERROR && size < 4) {
+  // try again with a fresh chunk. A contiguous buffer has no more
+  // text to offer.
+  if (self->data.lookahead == TS_DECODE_ERROR && size < 4 && !self->input_string) {
     ts_lexer__get_chunk(self);
     chunk = (const uint8_t *)self->chunk;
     size = self->chunk_size;
@@ -157,6 +181,33 @@ static void ts_lexer_goto(Lexer *self, Length position) {
 
 // Intended to be called only from functions that control logging.
 static void ts_lexer__do_advance(Lexer *self, bool skip) {
+  // When the source code is stored in one contiguous buffer, and the next
+  // character is within the current included range, there is no need to
+  // check for range boundaries or to retrieve a new chunk.
+  if (self->input_string && self->lookahead_size) {
+    uint32_t next_byte = self->current_position.bytes + self->lookahead_size;
+    const TSRange *current_range = &self->included_ranges[self->current_included_range_index];
+    if (next_byte < current_range->end_byte && next_byte < self->input_string_length) {
+      if (self->data.lookahead == '\n') {
+        self->current_position.extent.row++;
+        self->current_position.extent.column = 0;
+      } else {
+        self->current_position.extent.column += self->lookahead_size;
+      }
+      self->current_position.bytes = next_byte;
+      if (skip) self->token_start_position = self->current_position;
+
+      uint8_t byte = (uint8_t)self->input_string[next_byte];
+      if (byte < 0x80 && self->input.encoding == TSInputEncodingUTF8) {
+        self->lookahead_size = 1;
+        self->data.lookahead = byte;
+      } else {
+        ts_lexer__get_lookahead(self);
+      }
+      return;
+    }
+  }
+
   if (self->lookahead_size) {
     self->current_position.bytes += self->lookahead_size;
     if (self->data.lookahead == '\n') {
@@ -217,6 +268,59 @@ static void ts_lexer__advance(TSLexer *_self, bool skip) {
   ts_lexer__do_advance(self, skip);
 }
 
+// Advance past the current character, and then past all of the following
+// characters that are in the given set of ASCII characters. This is used by
+// the generated lexing functions for states that loop back to themselves.
+static void ts_lexer__advance_while_in_set(TSLexer *_self, const uint8_t *set, bool skip) {
+  Lexer *self = (Lexer *)_self;
+  ts_lexer__advance(_self, skip);
+
+  // Characters that need to be logged or decoded one at a time cannot be
+  // skipped over in bulk.
+  if (self->logger.log || self->input.encoding != TSInputEncodingUTF8) {
+    while (self->chunk && ts_ascii_set_contains(set, self->data.lookahead)) {
+      ts_lexer__advance(_self, skip);
+    }
+    return;
+  }
+
+  bool set_contains_newline = ts_ascii_set_contains(set, '\n');
+  while (self->chunk && ts_ascii_set_contains(set, self->data.lookahead)) {
+    // Find the run of characters in the set, stopping at the end of the
+    // current chunk or the current included range.
+    uint32_t position_in_chunk = self->current_position.bytes - self->chunk_start;
+    uint32_t size = self->chunk_size - position_in_chunk;
+    const TSRange *current_range = &self->included_ranges[self->current_included_range_index];
+    if (current_range->end_byte - self->current_position.bytes < size) {
+      size = current_range->end_byte - self->current_position.bytes;
+    }
+    const uint8_t *run = (const uint8_t *)self->chunk + position_in_chunk;
+    uint32_t run_length = ts_ascii_set_prefix_length(set, run, size);
+
+    // Move directly to the last character in the run, and then advance past it
+    // normally, so that the next lookahead character is decoded and any chunk
+    // or range boundaries are handled.
+    uint32_t skipped_length = run_length - 1;
+    const uint8_t *last_newline = NULL;
+    if (set_contains_newline) {
+      const uint8_t *newline = run;
+      while ((newline = memchr(newline, '\n', skipped_length - (newline - run)))) {
+        self->current_position.extent.row++;
+        last_newline = newline++;
+      }
+    }
+    if (last_newline) {
+      self->current_position.extent.column = skipped_length - (last_newline + 1 - run);
+    } else {
+      self->current_position.extent.column += skipped_length;
+    }
+    self->current_position.bytes += skipped_length;
+    self->data.lookahead = run[skipped_length];
+    self->lookahead_size = 1;
+    ts_lexer__do_advance(self, skip);
+  }
+}
+
 // Mark that a token match has completed. This can be called multiple
 // times if a longer match is found later.
 static void ts_lexer__mark_end(TSLexer *_self) {
@@ -293,12 +397,15 @@ void ts_lexer_init(Lexer *self) {
       .get_column = ts_lexer__get_column,
       .is_at_included_range_start = ts_lexer__is_at_included_range_start,
       .eof = ts_lexer__eof,
+      .advance_while_in_set = ts_lexer__advance_while_in_set,
       .lookahead = 0,
       .result_symbol = 0,
     },
     .chunk = NULL,
     .chunk_size = 0,
     .chunk_start = 0,
+    .input_string = NULL,
+    .input_string_length = 0,
     .current_position = {0, {0, 0}},
     .logger = {
       .payload = NULL,
@@ -317,6 +424,27 @@ void ts_lexer_delete(Lexer *self) {
 
 void ts_lexer_set_input(Lexer *self, TSInput input) {
   self->input = input;
+  self->input_string = NULL;
+  self->input_string_length = 0;
+  ts_lexer__clear_chunk(self);
+  ts_lexer_goto(self, self->current_position);
+}
+
+// Use source code that is stored in one contiguous buffer. The buffer must
+// remain valid until the lexer is given a different input.
+void ts_lexer_set_input_string(
+  Lexer *self,
+  const char *string,
+  uint32_t length,
+  TSInputEncoding encoding
+) {
+  self->input = (TSInput) {
+    .payload = NULL,
+    .read = NULL,
+    .encoding = encoding,
+  };
+  self->input_string = string ? string : "";
+  self->input_string_length = string ? length : 0;
   ts_lexer__clear_chunk(self);
   ts_lexer_goto(self, self->current_position);
 }
@@ -381,6 +509,61 @@ void ts_lexer_mark_end(Lexer *self) {
   ts_lexer__mark_end(&self->data);
 }
 
+// Find the class of the given character in a table-driven lexer. Invalid
+// characters are classified along with the last valid character, because
+// both are only matched by negated character sets.
+static inline uint16_t ts_lexer__character_class(const TSLexTable *table, int32_t c) {
+  if (c >= 0 && c < 128) return table->ascii_character_classes[c];
+  if (c < 0) c = 0x10FFFF;
+
+  const TSCharacterClassRange *ranges = table->character_class_ranges;
+  uint32_t index = 0;
+  uint32_t size = table->character_class_range_count;
+  while (size > 1) {
+    uint32_t half_size = size / 2;
+    uint32_t mid_index = index + half_size;
+    if (ranges[mid_index].start <= c) index = mid_index;
+    size -= half_size;
+  }
+  return ranges[index].character_class;
+}
+
+// Run a table-driven lexer, starting in the given state. This behaves
+// the same as the equivalent generated lexing function.
+bool ts_lexer_run_table(Lexer *self, const TSLexTable *table, TSStateId state) {
+  bool result = false;
+  for (;;) {
+    const TSLexTableState *lex_state = &table->states[state];
+    if (lex_state->accepts) {
+      result = true;
+      self->data.result_symbol = lex_state->accept_symbol;
+      ts_lexer__mark_end(&self->data);
+    }
+
+    if (ts_lexer__eof(&self->data)) {
+      if (!lex_state->has_eof_state) return result;
+      state = lex_state->eof_state;
+      ts_lexer__advance(&self->data, false);
+      continue;
+    }
+
+    uint16_t character_class = ts_lexer__character_class(table, self->data.lookahead);
+    uint16_t entry = table->transitions[
+      lex_state->transition_row * table->character_class_count + character_class
+    ];
+    if (!entry) return result;
+
+    bool skip = entry & TS_LEX_TABLE_SKIP;
+    TSStateId next_state = (entry & ~TS_LEX_TABLE_SKIP) - 1;
+    if (next_state == state && lex_state->has_loop_set) {
+      ts_lexer__advance_while_in_set(&self->data, table->ascii_sets[lex_state->loop_set], skip);
+    } else {
+      ts_lexer__advance(&self->data, skip);
+    }
+    state = next_state;
+  }
+}
+
 bool ts_lexer_set_included_ranges(
   Lexer *self,
   const TSRange *ranges,
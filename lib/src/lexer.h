@@ -19,6 +19,11 @@ typedef struct {
   TSRange *included_ranges;
   const char *chunk;
   TSInput input;
+
+  // When the source code is stored in one contiguous buffer, the lexer reads
+  // it directly instead of calling the input's `read` callback.
+  const char *input_string;
+  uint32_t input_string_length;
   TSLogger logger;
 
   uint32_t included_range_count;
@@ -34,11 +39,13 @@ typedef struct {
 void ts_lexer_init(Lexer *);
 void ts_lexer_delete(Lexer *);
 void ts_lexer_set_input(Lexer *, TSInput);
+void ts_lexer_set_input_string(Lexer *, const char *, uint32_t, TSInputEncoding);
 void ts_lexer_reset(Lexer *, Length);
 void ts_lexer_start(Lexer *);
 void ts_lexer_finish(Lexer *, uint32_t *);
 void ts_lexer_advance_to_end(Lexer *);
 void ts_lexer_mark_end(Lexer *);
+bool ts_lexer_run_table(Lexer *, const TSLexTable *, TSStateId);
 bool ts_lexer_set_included_ranges(Lexer *self, const TSRange *ranges, uint32_t count);
 TSRange *ts_lexer_included_ranges(const Lexer *self, uint32_t *count);
 
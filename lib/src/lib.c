@@ -12,6 +12,7 @@
 #include "./node.c"
 #include "./parser.c"
 #include "./query.c"
+#include "./reclaim.c"
 #include "./stack.c"
 #include "./subtree.c"
 #include "./tree_cursor.c"
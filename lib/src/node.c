@@ -133,6 +133,128 @@ static inline uint32_t ts_node__relevant_child_count(
   }
 }
 
+// Child indices
+
+// Nodes with at least this many children are indexed when their children
+// are looked up by index or by position.
+#define CHILD_INDEX_MIN_CHILD_COUNT 64
+
+static ChildIndex *ts_node__child_index_new(TSNode self) {
+  Subtree subtree = ts_node__subtree(self);
+  uint32_t child_count = ts_subtree_child_count(subtree);
+  ChildIndex *result = ts_malloc(
+    sizeof(ChildIndex) + (child_count + 1) * sizeof(ChildIndexEntry)
+  );
+  result->subtree = subtree.ptr;
+  result->next = NULL;
+  result->entries = (ChildIndexEntry *)(result + 1);
+
+  // Iterate over the children as if the node started at the beginning of
+  // the document, so that their positions are relative to the node.
+  TSNode origin = ts_node_new(self.tree, self.id, length_zero(), ts_node__alias(&self));
+  NodeChildIterator iterator = ts_node_iterate_children(&origin);
+  uint32_t visible_count = 0;
+  uint32_t named_count = 0;
+  for (;;) {
+    result->entries[iterator.child_index] = (ChildIndexEntry) {
+      .offset = iterator.position,
+      .visible_count = visible_count,
+      .named_count = named_count,
+      .structural_child_index = iterator.structural_child_index,
+    };
+
+    TSNode child;
+    if (!ts_node_child_iterator_next(&iterator, &child)) break;
+    visible_count += ts_node__is_relevant(child, true)
+      ? 1
+      : ts_node__relevant_child_count(child, true);
+    named_count += ts_node__is_relevant(child, false)
+      ? 1
+      : ts_node__relevant_child_count(child, false);
+  }
+  return result;
+}
+
+static inline const ChildIndex *ts_node__child_index(TSNode self) {
+  Subtree subtree = ts_node__subtree(self);
+  if (ts_subtree_child_count(subtree) < CHILD_INDEX_MIN_CHILD_COUNT) return NULL;
+  const ChildIndex *result = ts_tree_child_index(self.tree, subtree);
+  if (!result) {
+    result = ts_tree_add_child_index(self.tree, ts_node__child_index_new(self));
+  }
+  return result;
+}
+
+static inline uint32_t ts_node__child_index_count(
+  const ChildIndex *index,
+  uint32_t child_index,
+  bool include_anonymous
+) {
+  const ChildIndexEntry *entry = &index->entries[child_index];
+  return include_anonymous ? entry->visible_count : entry->named_count;
+}
+
+// Start iterating over a node's children at the given child.
+static inline NodeChildIterator ts_node__iterate_children_from(
+  const TSNode *node,
+  const ChildIndex *index,
+  uint32_t child_index
+) {
+  NodeChildIterator result = ts_node_iterate_children(node);
+  const ChildIndexEntry *entry = &index->entries[child_index];
+  result.child_index = child_index;
+  result.structural_child_index = entry->structural_child_index;
+  result.position = length_add(
+    (Length) {ts_node_start_byte(*node), ts_node_start_point(*node)},
+    entry->offset
+  );
+  return result;
+}
+
+// Find the first child that ends at or after `min_end`, and after `start`.
+static inline uint32_t ts_node__child_index_search_byte(
+  TSNode self,
+  const ChildIndex *index,
+  uint32_t start,
+  uint32_t min_end
+) {
+  uint32_t node_start = ts_node_start_byte(self);
+  uint32_t low = 0;
+  uint32_t high = ts_subtree_child_count(ts_node__subtree(self));
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    uint32_t end = node_start + index->entries[mid + 1].offset.bytes;
+    if (end >= min_end && end > start) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return low;
+}
+
+// Like `ts_node__child_index_search_byte`, but using points.
+static inline uint32_t ts_node__child_index_search_point(
+  TSNode self,
+  const ChildIndex *index,
+  TSPoint start,
+  TSPoint min_end
+) {
+  TSPoint node_start = ts_node_start_point(self);
+  uint32_t low = 0;
+  uint32_t high = ts_subtree_child_count(ts_node__subtree(self));
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    TSPoint end = point_add(node_start, index->entries[mid + 1].offset.extent);
+    if (point_lte(min_end, end) && point_lt(start, end)) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return low;
+}
+
 static inline TSNode ts_node__child(
   TSNode self,
   uint32_t child_index,
@@ -145,6 +267,32 @@ static inline TSNode ts_node__child(
     did_descend = false;
 
     TSNode child;
+    const ChildIndex *children_index = ts_node__child_index(result);
+    if (children_index) {
+      // Find the child whose relevant nodes include the one at the given
+      // index, by searching the index's cumulative counts.
+      uint32_t low = 0;
+      uint32_t high = ts_subtree_child_count(ts_node__subtree(result));
+      uint32_t total = ts_node__child_index_count(children_index, high, include_anonymous);
+      if (child_index >= total) break;
+      while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (ts_node__child_index_count(children_index, mid + 1, include_anonymous) > child_index) {
+          high = mid;
+        } else {
+          low = mid + 1;
+        }
+      }
+
+      NodeChildIterator iterator = ts_node__iterate_children_from(&result, children_index, low);
+      ts_node_child_iterator_next(&iterator, &child);
+      if (ts_node__is_relevant(child, include_anonymous)) return child;
+      child_index -= ts_node__child_index_count(children_index, low, include_anonymous);
+      result = child;
+      did_descend = true;
+      continue;
+    }
+
     uint32_t index = 0;
     NodeChildIterator iterator = ts_node_iterate_children(&result);
     while (ts_node_child_iterator_next(&iterator, &child)) {
@@ -170,130 +318,243 @@ static inline TSNode ts_node__child(
   return ts_node__null();
 }
 
-static bool ts_subtree_has_trailing_empty_descendant(
-  Subtree self,
-  Subtree other
-) {
-  for (unsigned i = ts_subtree_child_count(self) - 1; i + 1 > 0; i--) {
-    Subtree child = ts_subtree_children(self)[i];
-    if (ts_subtree_total_bytes(child) > 0) break;
-    if (child.ptr == other.ptr || ts_subtree_has_trailing_empty_descendant(child, other)) {
-      return true;
-    }
-  }
-  return false;
+static inline bool ts_node__is_root(TSNode self) {
+  return self.id == &self.tree->root;
 }
 
-static inline TSNode ts_node__prev_sibling(TSNode self, bool include_anonymous) {
-  Subtree self_subtree = ts_node__subtree(self);
-  bool self_is_empty = ts_subtree_total_bytes(self_subtree) == 0;
-  uint32_t target_end_byte = ts_node_end_byte(self);
+// Look up the given node in its tree's parent cache. The cached positions
+// don't apply to nodes obtained via `ts_tree_root_node_with_offset`.
+static inline const ParentCacheEntry *ts_node__cached_entry(TSNode self) {
+  const ParentCacheEntry *entry = ts_tree_parent_cache_entry(self.tree, self.id);
+  if (
+    entry &&
+    entry->position.bytes == ts_node_start_byte(self) &&
+    point_eq(entry->position.extent, ts_node_start_point(self))
+  ) return entry;
+  return NULL;
+}
 
-  TSNode node = ts_node_parent(self);
-  TSNode earlier_node = ts_node__null();
-  bool earlier_node_is_relevant = false;
+static inline TSNode ts_node__from_cache_entry(
+  const TSTree *tree,
+  const ParentCacheEntry *entry
+) {
+  return ts_node_new(tree, entry->child, entry->position, entry->alias_symbol);
+}
 
-  while (!ts_node_is_null(node)) {
-    TSNode earlier_child = ts_node__null();
-    bool earlier_child_is_relevant = false;
-    bool found_child_containing_target = false;
+typedef struct {
+  TSNode node;
+  uint32_t structural_child_index;
+} NodeAncestor;
+
+typedef Array(NodeAncestor) NodeAncestorArray;
 
+typedef struct {
+  NodeAncestor entry;
+  uint32_t depth;
+} NodeAncestorCandidate;
+
+// Find the path from the root to the given node by searching down from the
+// root, through the children whose ranges include the node. Each entry of the
+// path records its node's index among its parent's non-extra children. Only
+// one child of each node can contain a non-empty node, but an empty node may
+// be contained in any of several adjacent siblings, so the search may need
+// to backtrack to a shallower depth.
+static bool ts_node__search_ancestors(TSNode self, NodeAncestorArray *path) {
+  uint32_t start_byte = ts_node_start_byte(self);
+  uint32_t end_byte = ts_node_end_byte(self);
+  Array(NodeAncestorCandidate) candidates = array_new();
+  bool result = false;
+  array_clear(path);
+  array_push(path, ((NodeAncestor) {ts_tree_root_node(self.tree), 0}));
+  for (;;) {
+    NodeAncestor next = {ts_node__null(), 0};
     TSNode child;
-    NodeChildIterator iterator = ts_node_iterate_children(&node);
+    NodeChildIterator iterator = ts_node_iterate_children(&array_back(path)->node);
     while (ts_node_child_iterator_next(&iterator, &child)) {
-      if (child.id == self.id) break;
-      if (iterator.position.bytes > target_end_byte) {
-        found_child_containing_target = true;
-        break;
+      uint32_t structural_child_index = iterator.structural_child_index;
+      if (!ts_subtree_extra(ts_node__subtree(child))) structural_child_index--;
+      if (child.id == self.id) {
+        array_push(path, ((NodeAncestor) {child, structural_child_index}));
+        result = true;
+        goto done;
       }
-
-      if (iterator.position.bytes == target_end_byte &&
-          (!self_is_empty ||
-           ts_subtree_has_trailing_empty_descendant(ts_node__subtree(child), self_subtree))) {
-        found_child_containing_target = true;
-        break;
+      if (ts_node_start_byte(child) > start_byte) break;
+      if (
+        iterator.position.bytes >= end_byte &&
+        ts_subtree_child_count(ts_node__subtree(child)) > 0
+      ) {
+        if (next.node.id) {
+          array_push(&candidates, ((NodeAncestorCandidate) {next, path->size}));
+        }
+        next = (NodeAncestor) {child, structural_child_index};
       }
+    }
 
-      if (ts_node__is_relevant(child, include_anonymous)) {
-        earlier_child = child;
-        earlier_child_is_relevant = true;
-      } else if (ts_node__relevant_child_count(child, include_anonymous) > 0) {
-        earlier_child = child;
-        earlier_child_is_relevant = false;
-      }
+    if (!next.node.id) {
+      if (candidates.size == 0) break;
+      NodeAncestorCandidate candidate = array_pop(&candidates);
+      path->size = candidate.depth;
+      next = candidate.entry;
+    }
+    array_push(path, next);
+  }
+
+done:
+  array_delete(&candidates);
+  return result;
+}
+
+// Visits the subtrees that contain a given node, which may be hidden, from
+// its parent up to the root, along with each previous node's index among the
+// subtree's non-extra children. If the tree's parents have been indexed, each
+// step is a lookup in the index. Otherwise, the first step searches down from
+// the root, recording the whole path, and the later steps follow that path
+// back up.
+typedef struct {
+  TSNode node;
+  NodeAncestorArray path;
+} AncestorIterator;
+
+static inline AncestorIterator ts_node__iterate_ancestors(TSNode self) {
+  return (AncestorIterator) {self, array_new()};
+}
+
+static bool ts_node__ancestor_iterator_next(
+  AncestorIterator *self,
+  TSNode *parent,
+  uint32_t *structural_child_index
+) {
+  if (ts_node__is_root(self->node)) return false;
+  if (self->path.size == 0) {
+    const ParentCacheEntry *entry = ts_node__cached_entry(self->node);
+    if (entry) {
+      *parent = ts_node__from_cache_entry(
+        self->node.tree,
+        &self->node.tree->parent_cache->entries[entry->parent_index]
+      );
+      *structural_child_index = entry->structural_child_index;
+      self->node = *parent;
+      return true;
     }
+    if (!ts_node__search_ancestors(self->node, &self->path)) return false;
+  }
+
+  // The last entry of the path is the current node.
+  *structural_child_index = array_pop(&self->path).structural_child_index;
+  *parent = array_back(&self->path)->node;
+  self->node = *parent;
+  return true;
+}
+
+static inline void ts_node__ancestor_iterator_delete(AncestorIterator *self) {
+  array_delete(&self->path);
+}
 
-    if (found_child_containing_target) {
-      if (!ts_node_is_null(earlier_child)) {
-        earlier_node = earlier_child;
-        earlier_node_is_relevant = earlier_child_is_relevant;
+// Find the nearest relevant node before the given node within its parent,
+// descending into hidden nodes and ascending out of them as necessary.
+static inline TSNode ts_node__prev_sibling(TSNode self, bool include_anonymous) {
+  TSNode result = ts_node__null();
+  TSNode node = self;
+  TSNode parent;
+  uint32_t structural_child_index;
+  AncestorIterator ancestors = ts_node__iterate_ancestors(self);
+  while (ts_node__ancestor_iterator_next(&ancestors, &parent, &structural_child_index)) {
+    const Subtree *children = ts_subtree_children(ts_node__subtree(parent));
+    uint32_t child_index = (uint32_t)((const Subtree *)node.id - children);
+    TSNode earlier_child = ts_node__null();
+
+    // The siblings' positions can only be computed by iterating forward from
+    // the start of the parent, unless they are available in the cache, where
+    // siblings' entries are adjacent.
+    const ParentCacheEntry *entry = ts_node__cached_entry(node);
+    if (entry) {
+      for (uint32_t i = 1; i <= child_index; i++) {
+        TSNode child = ts_node__from_cache_entry(self.tree, entry - i);
+        if (
+          ts_node__is_relevant(child, include_anonymous) ||
+          ts_node__relevant_child_count(child, include_anonymous) > 0
+        ) {
+          earlier_child = child;
+          break;
+        }
       }
-      node = child;
-    } else if (earlier_child_is_relevant) {
-      return earlier_child;
-    } else if (!ts_node_is_null(earlier_child)) {
-      node = earlier_child;
-    } else if (earlier_node_is_relevant) {
-      return earlier_node;
     } else {
-      node = earlier_node;
-      earlier_node = ts_node__null();
-      earlier_node_is_relevant = false;
+      TSNode child;
+      NodeChildIterator iterator = ts_node_iterate_children(&parent);
+      while (
+        iterator.child_index < child_index &&
+        ts_node_child_iterator_next(&iterator, &child)
+      ) {
+        if (
+          ts_node__is_relevant(child, include_anonymous) ||
+          ts_node__relevant_child_count(child, include_anonymous) > 0
+        ) {
+          earlier_child = child;
+        }
+      }
     }
+
+    if (earlier_child.id) {
+      if (ts_node__is_relevant(earlier_child, include_anonymous)) {
+        result = earlier_child;
+      } else {
+        result = ts_node__child(
+          earlier_child,
+          ts_node__relevant_child_count(earlier_child, include_anonymous) - 1,
+          include_anonymous
+        );
+      }
+      break;
+    }
+
+    if (ts_node__is_relevant(parent, true)) break;
+    node = parent;
   }
 
-  return ts_node__null();
+  ts_node__ancestor_iterator_delete(&ancestors);
+  return result;
 }
 
+// Find the nearest relevant node after the given node within its parent,
+// descending into hidden nodes and ascending out of them as necessary.
 static inline TSNode ts_node__next_sibling(TSNode self, bool include_anonymous) {
-  uint32_t target_end_byte = ts_node_end_byte(self);
-
-  TSNode node = ts_node_parent(self);
-  TSNode later_node = ts_node__null();
-  bool later_node_is_relevant = false;
-
-  while (!ts_node_is_null(node)) {
-    TSNode later_child = ts_node__null();
-    bool later_child_is_relevant = false;
-    TSNode child_containing_target = ts_node__null();
+  TSNode result = ts_node__null();
+  TSNode node = self;
+  TSNode parent;
+  uint32_t structural_child_index;
+  AncestorIterator ancestors = ts_node__iterate_ancestors(self);
+  while (ts_node__ancestor_iterator_next(&ancestors, &parent, &structural_child_index)) {
+    // Resume iterating over the parent's children just after this node.
+    Subtree subtree = ts_node__subtree(node);
+    NodeChildIterator iterator = ts_node_iterate_children(&parent);
+    iterator.child_index = (uint32_t)(
+      (const Subtree *)node.id - ts_subtree_children(iterator.parent)
+    ) + 1;
+    iterator.structural_child_index = structural_child_index;
+    if (!ts_subtree_extra(subtree)) iterator.structural_child_index++;
+    iterator.position = length_add(
+      (Length) {ts_node_start_byte(node), ts_node_start_point(node)},
+      ts_subtree_size(subtree)
+    );
 
     TSNode child;
-    NodeChildIterator iterator = ts_node_iterate_children(&node);
     while (ts_node_child_iterator_next(&iterator, &child)) {
-      if (iterator.position.bytes < target_end_byte) continue;
-      if (ts_node_start_byte(child) <= ts_node_start_byte(self)) {
-        if (ts_node__subtree(child).ptr != ts_node__subtree(self).ptr) {
-          child_containing_target = child;
-        }
-      } else if (ts_node__is_relevant(child, include_anonymous)) {
-        later_child = child;
-        later_child_is_relevant = true;
+      if (ts_node__is_relevant(child, include_anonymous)) {
+        result = child;
         break;
-      } else if (ts_node__relevant_child_count(child, include_anonymous) > 0) {
-        later_child = child;
-        later_child_is_relevant = false;
+      }
+      if (ts_node__relevant_child_count(child, include_anonymous) > 0) {
+        result = ts_node__child(child, 0, include_anonymous);
         break;
       }
     }
 
-    if (!ts_node_is_null(child_containing_target)) {
-      if (!ts_node_is_null(later_child)) {
-        later_node = later_child;
-        later_node_is_relevant = later_child_is_relevant;
-      }
-      node = child_containing_target;
-    } else if (later_child_is_relevant) {
-      return later_child;
-    } else if (!ts_node_is_null(later_child)) {
-      node = later_child;
-    } else if (later_node_is_relevant) {
-      return later_node;
-    } else {
-      node = later_node;
-    }
+    if (result.id || ts_node__is_relevant(parent, true)) break;
+    node = parent;
   }
 
-  return ts_node__null();
+  ts_node__ancestor_iterator_delete(&ancestors);
+  return result;
 }
 
 static inline TSNode ts_node__first_child_for_byte(
@@ -309,6 +570,11 @@ static inline TSNode ts_node__first_child_for_byte(
 
     TSNode child;
     NodeChildIterator iterator = ts_node_iterate_children(&node);
+    const ChildIndex *children_index = ts_node__child_index(node);
+    if (children_index) {
+      uint32_t first = ts_node__child_index_search_byte(node, children_index, goal, goal);
+      iterator = ts_node__iterate_children_from(&node, children_index, first);
+    }
     while (ts_node_child_iterator_next(&iterator, &child)) {
       if (ts_node_end_byte(child) > goal) {
         if (ts_node__is_relevant(child, include_anonymous)) {
@@ -340,6 +606,11 @@ static inline TSNode ts_node__descendant_for_byte_range(
 
     TSNode child;
     NodeChildIterator iterator = ts_node_iterate_children(&node);
+    const ChildIndex *children_index = ts_node__child_index(node);
+    if (children_index) {
+      uint32_t first = ts_node__child_index_search_byte(node, children_index, range_start, range_end);
+      iterator = ts_node__iterate_children_from(&node, children_index, first);
+    }
     while (ts_node_child_iterator_next(&iterator, &child)) {
       uint32_t node_end = iterator.position.bytes;
 
@@ -379,6 +650,11 @@ static inline TSNode ts_node__descendant_for_point_range(
 
     TSNode child;
     NodeChildIterator iterator = ts_node_iterate_children(&node);
+    const ChildIndex *children_index = ts_node__child_index(node);
+    if (children_index) {
+      uint32_t first = ts_node__child_index_search_point(node, children_index, range_start, range_end);
+      iterator = ts_node__iterate_children_from(&node, children_index, first);
+    }
     while (ts_node_child_iterator_next(&iterator, &child)) {
       TSPoint node_end = iterator.position.extent;
 
@@ -442,6 +718,49 @@ char *ts_node_string(TSNode self) {
   return ts_subtree_string(ts_node__subtree(self), self.tree->language, false);
 }
 
+// The subtree writers track positions from the start of each subtree's
+// padding, so they need the position that precedes the node's padding. If the
+// padding spans multiple rows, that position's column is unknown, but it
+// doesn't matter, because adding the padding back replaces the column.
+static inline Length ts_node__padded_start(TSNode self) {
+  Length padding = ts_subtree_padding(ts_node__subtree(self));
+  Length result = {ts_node_start_byte(self) - padding.bytes, ts_node_start_point(self)};
+  if (padding.extent.row > 0) {
+    result.extent.row -= padding.extent.row;
+    result.extent.column = 0;
+  } else {
+    result.extent.column -= padding.extent.column;
+  }
+  return result;
+}
+
+bool ts_node_write_sexp(TSNode self, TSSexpOptions options, TSWriter writer) {
+  return ts_subtree_write_sexp(
+    ts_node__subtree(self),
+    ts_node__padded_start(self),
+    self.tree->language,
+    false,
+    options,
+    writer
+  );
+}
+
+bool ts_node_write_xml(
+  TSNode self,
+  const char *source,
+  uint32_t source_length,
+  TSWriter writer
+) {
+  return ts_subtree_write_xml(
+    ts_node__subtree(self),
+    ts_node__padded_start(self),
+    self.tree->language,
+    source,
+    source_length,
+    writer
+  );
+}
+
 bool ts_node_eq(TSNode self, TSNode other) {
   return self.tree == other.tree && self.id == other.id;
 }
@@ -495,34 +814,18 @@ TSStateId ts_node_next_parse_state(TSNode self) {
 }
 
 TSNode ts_node_parent(TSNode self) {
-  TSNode node = ts_tree_root_node(self.tree);
-  uint32_t end_byte = ts_node_end_byte(self);
-  if (node.id == self.id) return ts_node__null();
-
-  TSNode last_visible_node = node;
-  bool did_descend = true;
-  while (did_descend) {
-    did_descend = false;
-
-    TSNode child;
-    NodeChildIterator iterator = ts_node_iterate_children(&node);
-    while (ts_node_child_iterator_next(&iterator, &child)) {
-      if (
-        ts_node_start_byte(child) > ts_node_start_byte(self) ||
-        child.id == self.id
-      ) break;
-      if (iterator.position.bytes >= end_byte) {
-        node = child;
-        if (ts_node__is_relevant(child, true)) {
-          last_visible_node = node;
-        }
-        did_descend = true;
-        break;
-      }
+  TSNode result = ts_node__null();
+  TSNode node;
+  uint32_t structural_child_index;
+  AncestorIterator ancestors = ts_node__iterate_ancestors(self);
+  while (ts_node__ancestor_iterator_next(&ancestors, &node, &structural_child_index)) {
+    if (ts_node__is_relevant(node, true) || ts_node__is_root(node)) {
+      result = node;
+      break;
     }
   }
-
-  return last_visible_node;
+  ts_node__ancestor_iterator_delete(&ancestors);
+  return result;
 }
 
 TSNode ts_node_child(TSNode self, uint32_t child_index) {
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <string.h>
 #include "tree_sitter/api.h"
 #include "./alloc.h"
 #include "./array.h"
@@ -17,6 +18,7 @@
 #include "./reusable_node.h"
 #include "./stack.h"
 #include "./subtree.h"
+#include "./thread.h"
 #include "./tree.h"
 
 #define LOG(...)                                                                            \
@@ -67,6 +69,11 @@
     fputs("\n", self->dot_graph_file);                                      \
   }
 
+#define TRACE(event_type, ...)                                                \
+  if (self->trace_buffer) {                                                   \
+    ts_parser__trace(self, (TSTraceEvent) {.type = event_type, __VA_ARGS__}); \
+  }
+
 #define SYM_NAME(symbol) ts_language_symbol_name(self->language, symbol)
 
 #define TREE_NAME(tree) SYM_NAME(ts_subtree_symbol(tree))
@@ -76,13 +83,40 @@ static const unsigned MAX_VERSION_COUNT_OVERFLOW = 4;
 static const unsigned MAX_SUMMARY_DEPTH = 16;
 static const unsigned MAX_COST_DIFFERENCE = 16 * ERROR_COST_PER_SKIPPED_TREE;
 static const unsigned OP_COUNT_PER_TIMEOUT_CHECK = 100;
+static const unsigned MAX_ARENA_GENERATIONS = 16;
+static const unsigned MIN_NODE_COUNT_AFTER_ERROR_REGION = 16;
+static const uint32_t MIN_PARALLEL_CHUNK_SIZE = 64 * 1024;
+
+#define TOKEN_CACHE_SIZE 8
 
 typedef struct {
   Subtree token;
   Subtree last_external_token;
   uint32_t byte_index;
+  TSLexMode lex_mode;
+} TokenCacheEntry;
+
+// Recently lexed tokens, keyed by their position, the lex mode in which they
+// were lexed, and the external scanner state that preceded them. When there
+// are multiple stack versions, they often need to lex at the same positions
+// in different states.
+typedef struct {
+  TokenCacheEntry entries[TOKEN_CACHE_SIZE];
+  unsigned next_index;
 } TokenCache;
 
+typedef struct {
+  const TSLanguage *language;
+  const char *string;
+  uint32_t length;
+  TSDuration timeout_duration;
+  uint32_t recovery_budget;
+  const volatile size_t *cancellation_flag;
+  TSThread thread;
+  bool is_running;
+  TSTree *tree;
+} ParseChunk;
+
 struct TSParser {
   Lexer lexer;
   Stack *stack;
@@ -94,17 +128,33 @@ struct TSParser {
   SubtreeArray trailing_extras2;
   SubtreeArray scratch_trees;
   TokenCache token_cache;
+  TSParserStats stats;
   ReusableNode reusable_node;
   void *external_scanner_payload;
   FILE *dot_graph_file;
+  TSTraceBuffer *trace_buffer;
+  TSNodeStream node_stream;
+  SubtreeArray stack_subtrees;
+  uint32_t stream_goal_byte;
+  bool has_streamable_nodes;
+  bool discard_streamed_nodes;
   TSClock end_clock;
   TSDuration timeout_duration;
+  uint32_t recovery_budget;
+  uint32_t recovery_count;
   unsigned accept_count;
   unsigned operation_count;
+  uint32_t step_operation_count;
+  uint32_t step_operation_budget;
+  uint32_t step_progress_bytes;
+  uint32_t paused_position;
+  bool has_paused_parse;
   const volatile size_t *cancellation_flag;
   Subtree old_tree;
+  SubtreeArena *old_tree_arena;
   TSRangeArray included_range_differences;
   unsigned included_range_difference_index;
+  bool arena_allocation;
 };
 
 typedef struct {
@@ -122,30 +172,6 @@ typedef enum {
   ErrorComparisonTakeRight,
 } ErrorComparison;
 
-typedef struct {
-  const char *string;
-  uint32_t length;
-} TSStringInput;
-
-// StringInput
-
-static const char *ts_string_input_read(
-  void *_self,
-  uint32_t byte,
-  TSPoint point,
-  uint32_t *length
-) {
-  (void)point;
-  TSStringInput *self = (TSStringInput *)_self;
-  if (byte >= self->length) {
-    *length = 0;
-    return "";
-  } else {
-    *length = self->length - byte;
-    return self->string + byte;
-  }
-}
-
 // Parser - Private
 
 static void ts_parser__log(TSParser *self) {
@@ -167,6 +193,13 @@ static void ts_parser__log(TSParser *self) {
   }
 }
 
+static inline void ts_parser__trace(TSParser *self, TSTraceEvent event) {
+  TSTraceBuffer *buffer = self->trace_buffer;
+  if (buffer->capacity == 0) return;
+  buffer->events[buffer->event_count % buffer->capacity] = event;
+  buffer->event_count++;
+}
+
 static bool ts_parser__breakdown_top_of_stack(
   TSParser *self,
   StackVersion version
@@ -204,6 +237,13 @@ static bool ts_parser__breakdown_top_of_stack(
         ts_stack_push(self->stack, slice.version, tree, false, state);
       }
 
+      TRACE(
+        TSTraceEventTypeBreakdownTopOfStack,
+        .state = state,
+        .symbol = ts_subtree_symbol(parent),
+        .version = slice.version,
+        .byte = ts_stack_position(self->stack, slice.version).bytes
+      );
       ts_subtree_release(&self->tree_pool, parent);
       array_delete(&slice.subtrees);
 
@@ -295,6 +335,16 @@ static ErrorStatus ts_parser__version_status(
   };
 }
 
+// While the parser is recovering from an error, each token that it processes
+// in the error state, and each stack version that it creates in order to try
+// a different recovery, is charged against its recovery budget. Once the
+// budget for the current error region is spent, the parser stops exploring
+// alternative recoveries, and just skips tokens until it finds one that is
+// valid in some earlier state on the stack.
+static inline bool ts_parser__can_explore_recoveries(const TSParser *self) {
+  return !self->recovery_budget || self->recovery_count < self->recovery_budget;
+}
+
 static bool ts_parser__better_version_exists(
   TSParser *self,
   StackVersion version,
@@ -482,7 +532,10 @@ static Subtree ts_parser__lex(
       current_position.extent.column
     );
     ts_lexer_start(&self->lexer);
-    bool found_token = self->language->lex_fn(&self->lexer.data, lex_mode.lex_state);
+    const TSLexTable *lex_table = ts_language_lex_table(self->language);
+    bool found_token = lex_table
+      ? ts_lexer_run_table(&self->lexer, lex_table, lex_mode.lex_state)
+      : self->language->lex_fn(&self->lexer.data, lex_mode.lex_state);
     ts_lexer_finish(&self->lexer, &lookahead_end_byte);
     if (found_token) break;
 
@@ -543,8 +596,12 @@ static Subtree ts_parser__lex(
       uint32_t end_byte = self->lexer.token_end_position.bytes;
       ts_lexer_reset(&self->lexer, self->lexer.token_start_position);
       ts_lexer_start(&self->lexer);
+      const TSLexTable *keyword_lex_table = ts_language_keyword_lex_table(self->language);
+      bool found_keyword = keyword_lex_table
+        ? ts_lexer_run_table(&self->lexer, keyword_lex_table, 0)
+        : self->language->keyword_lex_fn(&self->lexer.data, 0);
       if (
-        self->language->keyword_lex_fn(&self->lexer.data, 0) &&
+        found_keyword &&
         self->lexer.token_end_position.bytes == end_byte &&
         ts_language_has_actions(self->language, parse_state, self->lexer.data.result_symbol)
       ) {
@@ -570,6 +627,7 @@ static Subtree ts_parser__lex(
       MutableSubtree mut_result = ts_subtree_to_mut_unsafe(result);
       ts_external_scanner_state_init(
         &mut_result.ptr->external_scanner_state,
+        self->tree_pool.arena,
         self->lexer.debug_buffer,
         external_scanner_state_len
       );
@@ -577,6 +635,20 @@ static Subtree ts_parser__lex(
     }
   }
 
+  self->stats.lex_count++;
+  if (lookahead_end_byte > start_position.bytes) {
+    self->stats.lexed_byte_count += lookahead_end_byte - start_position.bytes;
+  }
+
+  TRACE(
+    TSTraceEventTypeLexedLookahead,
+    .state = parse_state,
+    .symbol = ts_subtree_symbol(result),
+    .version = version,
+    .byte = start_position.bytes,
+    .value = ts_subtree_total_bytes(result)
+  );
+
   LOG_LOOKAHEAD(
     SYM_NAME(ts_subtree_symbol(result)),
     ts_subtree_total_size(result).bytes
@@ -592,33 +664,89 @@ static Subtree ts_parser__get_cached_token(
   TableEntry *table_entry
 ) {
   TokenCache *cache = &self->token_cache;
-  if (
-    cache->token.ptr && cache->byte_index == position &&
-    ts_subtree_external_scanner_state_eq(cache->last_external_token, last_external_token)
-  ) {
-    ts_language_table_entry(self->language, state, ts_subtree_symbol(cache->token), table_entry);
-    if (ts_parser__can_reuse_first_leaf(self, state, cache->token, table_entry)) {
-      ts_subtree_retain(cache->token);
-      return cache->token;
+  TSLexMode lex_mode = self->language->lex_modes[state];
+
+  // Prefer tokens that were lexed in the current lex mode, since the lexer
+  // would produce the same token again. Then fall back to tokens from other
+  // lex modes that are still valid in the current state.
+  for (unsigned pass = 0; pass < 2; pass++) {
+    for (unsigned i = 0; i < TOKEN_CACHE_SIZE; i++) {
+      TokenCacheEntry *entry = &cache->entries[i];
+      if (!entry->token.ptr || entry->byte_index != position) continue;
+      bool has_same_lex_mode = memcmp(&entry->lex_mode, &lex_mode, sizeof(TSLexMode)) == 0;
+      if (has_same_lex_mode != (pass == 0)) continue;
+      if (!ts_subtree_external_scanner_state_eq(entry->last_external_token, last_external_token)) continue;
+      ts_language_table_entry(self->language, state, ts_subtree_symbol(entry->token), table_entry);
+      if (ts_parser__can_reuse_first_leaf(self, state, entry->token, table_entry)) {
+        self->stats.token_cache_hit_count++;
+        ts_subtree_retain(entry->token);
+        return entry->token;
+      }
     }
   }
+
+  self->stats.token_cache_miss_count++;
   return NULL_SUBTREE;
 }
 
-static void ts_parser__set_cached_token(
+static void ts_parser__set_cached_token_entry(
   TSParser *self,
+  TokenCacheEntry *entry,
   uint32_t byte_index,
+  TSLexMode lex_mode,
   Subtree last_external_token,
   Subtree token
 ) {
-  TokenCache *cache = &self->token_cache;
   if (token.ptr) ts_subtree_retain(token);
   if (last_external_token.ptr) ts_subtree_retain(last_external_token);
-  if (cache->token.ptr) ts_subtree_release(&self->tree_pool, cache->token);
-  if (cache->last_external_token.ptr) ts_subtree_release(&self->tree_pool, cache->last_external_token);
-  cache->token = token;
-  cache->byte_index = byte_index;
-  cache->last_external_token = last_external_token;
+  if (entry->token.ptr) ts_subtree_release(&self->tree_pool, entry->token);
+  if (entry->last_external_token.ptr) ts_subtree_release(&self->tree_pool, entry->last_external_token);
+  entry->token = token;
+  entry->byte_index = byte_index;
+  entry->lex_mode = lex_mode;
+  entry->last_external_token = last_external_token;
+}
+
+static void ts_parser__set_cached_token(
+  TSParser *self,
+  TSStateId state,
+  uint32_t byte_index,
+  Subtree last_external_token,
+  Subtree token
+) {
+  TokenCache *cache = &self->token_cache;
+  TSLexMode lex_mode = self->language->lex_modes[state];
+
+  // Replace any token with the same key. Otherwise, replace the oldest token.
+  TokenCacheEntry *entry = NULL;
+  for (unsigned i = 0; i < TOKEN_CACHE_SIZE; i++) {
+    TokenCacheEntry *candidate = &cache->entries[i];
+    if (
+      candidate->token.ptr &&
+      candidate->byte_index == byte_index &&
+      memcmp(&candidate->lex_mode, &lex_mode, sizeof(TSLexMode)) == 0 &&
+      ts_subtree_external_scanner_state_eq(candidate->last_external_token, last_external_token)
+    ) {
+      entry = candidate;
+      break;
+    }
+  }
+  if (!entry) {
+    entry = &cache->entries[cache->next_index];
+    cache->next_index = (cache->next_index + 1) % TOKEN_CACHE_SIZE;
+  }
+
+  ts_parser__set_cached_token_entry(self, entry, byte_index, lex_mode, last_external_token, token);
+}
+
+static void ts_parser__clear_token_cache(TSParser *self) {
+  TokenCache *cache = &self->token_cache;
+  for (unsigned i = 0; i < TOKEN_CACHE_SIZE; i++) {
+    ts_parser__set_cached_token_entry(
+      self, &cache->entries[i], 0, (TSLexMode) {0, 0}, NULL_SUBTREE, NULL_SUBTREE
+    );
+  }
+  cache->next_index = 0;
 }
 
 static bool ts_parser__has_included_range_difference(
@@ -706,6 +834,16 @@ static Subtree ts_parser__reuse_node(
     }
 
     LOG("reuse_node symbol:%s", TREE_NAME(result));
+    TRACE(
+      TSTraceEventTypeReuseNode,
+      .state = *state,
+      .symbol = ts_subtree_symbol(result),
+      .version = version,
+      .byte = position,
+      .value = ts_subtree_total_bytes(result)
+    );
+    self->stats.reused_subtree_count++;
+    self->stats.reused_byte_count += ts_subtree_total_bytes(result);
     ts_subtree_retain(result);
     return result;
   }
@@ -776,6 +914,7 @@ static bool ts_parser__select_children(
   // room for its own heap data. The scratch tree is never explicitly released,
   // so the same 'scratch trees' array can be reused again later.
   MutableSubtree scratch_tree = ts_subtree_new_node(
+    NULL,
     ts_subtree_symbol(left),
     &self->scratch_trees,
     0,
@@ -859,7 +998,7 @@ static StackVersion ts_parser__reduce(
     ts_subtree_array_remove_trailing_extras(&children, &self->trailing_extras);
 
     MutableSubtree parent = ts_subtree_new_node(
-      symbol, &children, production_id, self->language
+      &self->tree_pool, symbol, &children, production_id, self->language
     );
 
     // This pop operation may have caused multiple stack versions to collapse
@@ -883,7 +1022,7 @@ static StackVersion ts_parser__reduce(
         ts_subtree_release(&self->tree_pool, ts_subtree_from_mut(parent));
         array_swap(&self->trailing_extras, &self->trailing_extras2);
         parent = ts_subtree_new_node(
-          symbol, &next_slice_children, production_id, self->language
+          &self->tree_pool, symbol, &next_slice_children, production_id, self->language
         );
       } else {
         array_clear(&self->trailing_extras2);
@@ -893,6 +1032,7 @@ static StackVersion ts_parser__reduce(
 
     TSStateId state = ts_stack_state(self->stack, slice_version);
     TSStateId next_state = ts_language_next_state(self->language, state, symbol);
+    if (state == 1) self->has_streamable_nodes = true;
     if (end_of_non_terminal_extra && next_state == state) {
       parent.ptr->extra = true;
     }
@@ -951,6 +1091,7 @@ static void ts_parser__accept(
         }
         array_splice(&trees, j, 1, child_count, children);
         root = ts_subtree_from_mut(ts_subtree_new_node(
+          &self->tree_pool,
           ts_subtree_symbol(tree),
           &trees,
           tree.ptr->production_id,
@@ -1112,7 +1253,9 @@ static bool ts_parser__recover_to_state(
     ts_subtree_array_remove_trailing_extras(&slice.subtrees, &self->trailing_extras);
 
     if (slice.subtrees.size > 0) {
-      Subtree error = ts_subtree_new_error_node(&slice.subtrees, true, self->language);
+      Subtree error = ts_subtree_new_error_node(
+        &self->tree_pool, &slice.subtrees, true, self->language
+      );
       ts_stack_push(self->stack, slice.version, error, false, goal_state);
     } else {
       array_delete(&slice.subtrees);
@@ -1136,6 +1279,8 @@ static void ts_parser__recover(
 ) {
   bool did_recover = false;
   unsigned previous_version_count = ts_stack_version_count(self->stack);
+  self->stats.recover_count++;
+  self->recovery_count++;
   Length position = ts_stack_position(self->stack, version);
   StackSummary *summary = ts_stack_get_summary(self->stack, version);
   unsigned node_count_since_error = ts_stack_node_count_since_error(self->stack, version);
@@ -1159,6 +1304,9 @@ static void ts_parser__recover(
 
       if (entry.state == ERROR_STATE) continue;
       if (entry.position.bytes == position.bytes) continue;
+
+      // Do not wrap nodes that have already been streamed in an ERROR node.
+      if (entry.position.bytes + 1 < self->stream_goal_byte) continue;
       unsigned depth = entry.depth;
       if (node_count_since_error > 0) depth++;
 
@@ -1186,12 +1334,23 @@ static void ts_parser__recover(
       // If the current lookahead token is valid in some previous state, recover to that state.
       // Then stop looking for further recoveries.
       if (ts_language_has_actions(self->language, entry.state, ts_subtree_symbol(lookahead))) {
+        self->recovery_count++;
         if (ts_parser__recover_to_state(self, version, depth, entry.state)) {
           did_recover = true;
           LOG("recover_to_previous state:%u, depth:%u", entry.state, depth);
+          TRACE(
+            TSTraceEventTypeRecoverToPrevious,
+            .state = entry.state,
+            .version = version,
+            .byte = position.bytes,
+            .value = depth
+          );
           LOG_STACK();
           break;
         }
+
+        // Once the recovery budget is spent, only attempt one recovery per token.
+        if (!ts_parser__can_explore_recoveries(self)) break;
       }
     }
   }
@@ -1228,8 +1387,11 @@ static void ts_parser__recover(
   // in an ERROR node and terminate.
   if (ts_subtree_is_eof(lookahead)) {
     LOG("recover_eof");
+    TRACE(TSTraceEventTypeRecoverEof, .version = version, .byte = position.bytes);
     SubtreeArray children = array_new();
-    Subtree parent = ts_subtree_new_error_node(&children, false, self->language);
+    Subtree parent = ts_subtree_new_error_node(
+      &self->tree_pool, &children, false, self->language
+    );
     ts_stack_push(self->stack, version, parent, false, 1);
     ts_parser__accept(self, version, lookahead);
     return;
@@ -1258,10 +1420,18 @@ static void ts_parser__recover(
 
   // Wrap the lookahead token in an ERROR.
   LOG("skip_token symbol:%s", TREE_NAME(lookahead));
+  TRACE(
+    TSTraceEventTypeSkipToken,
+    .state = ERROR_STATE,
+    .symbol = ts_subtree_symbol(lookahead),
+    .version = version,
+    .byte = position.bytes
+  );
   SubtreeArray children = array_new();
   array_reserve(&children, 1);
   array_push(&children, lookahead);
   MutableSubtree error_repeat = ts_subtree_new_node(
+    &self->tree_pool,
     ts_builtin_sym_error_repeat,
     &children,
     0,
@@ -1290,6 +1460,7 @@ static void ts_parser__recover(
     ts_stack_renumber_version(self->stack, pop.contents[0].version, version);
     array_push(&pop.contents[0].subtrees, ts_subtree_from_mut(error_repeat));
     error_repeat = ts_subtree_new_node(
+      &self->tree_pool,
       ts_builtin_sym_error_repeat,
       &pop.contents[0].subtrees,
       0,
@@ -1324,7 +1495,7 @@ static void ts_parser__handle_error(
   // were created in the previous step.
   bool did_insert_missing_token = false;
   for (StackVersion v = version; v < version_count;) {
-    if (!did_insert_missing_token) {
+    if (!did_insert_missing_token && ts_parser__can_explore_recoveries(self)) {
       TSStateId state = ts_stack_state(self->stack, v);
       for (
         TSSymbol missing_symbol = 1;
@@ -1352,6 +1523,7 @@ static void ts_parser__handle_error(
           uint32_t lookahead_bytes = ts_subtree_total_bytes(lookahead) + ts_subtree_lookahead_bytes(lookahead);
 
           StackVersion version_with_missing_tree = ts_stack_copy_version(self->stack, v);
+          self->recovery_count++;
           Subtree missing_tree = ts_subtree_new_missing_leaf(
             &self->tree_pool, missing_symbol,
             padding, lookahead_bytes,
@@ -1372,6 +1544,13 @@ static void ts_parser__handle_error(
               SYM_NAME(missing_symbol),
               ts_stack_state(self->stack, version_with_missing_tree)
             );
+            TRACE(
+              TSTraceEventTypeRecoverWithMissing,
+              .state = ts_stack_state(self->stack, version_with_missing_tree),
+              .symbol = missing_symbol,
+              .version = version_with_missing_tree,
+              .byte = ts_stack_position(self->stack, version_with_missing_tree).bytes
+            );
             did_insert_missing_token = true;
             break;
           }
@@ -1441,7 +1620,7 @@ static bool ts_parser__advance(
       lookahead = ts_parser__lex(self, version, state);
 
       if (lookahead.ptr) {
-        ts_parser__set_cached_token(self, position, last_external_token, lookahead);
+        ts_parser__set_cached_token(self, state, position, last_external_token, lookahead);
         ts_language_table_entry(self->language, state, ts_subtree_symbol(lookahead), &table_entry);
       }
 
@@ -1469,6 +1648,9 @@ static bool ts_parser__advance(
       return false;
     }
 
+    // Count the work done by the current call when parsing in steps.
+    self->step_operation_count++;
+
     // Process each parse action for the current lookahead token in
     // the current state. If there are multiple actions, then this is
     // an ambiguous state. REDUCE actions always create a new stack
@@ -1495,7 +1677,16 @@ static bool ts_parser__advance(
             next_state = ts_language_next_state(self->language, state, ts_subtree_symbol(lookahead));
           }
 
+          TRACE(
+            action.shift.extra ? TSTraceEventTypeShiftExtra : TSTraceEventTypeShift,
+            .state = next_state,
+            .symbol = ts_subtree_symbol(lookahead),
+            .version = version,
+            .byte = position,
+            .value = ts_subtree_total_bytes(lookahead)
+          );
           ts_parser__shift(self, version, next_state, lookahead, action.shift.extra);
+          self->stats.shift_count++;
           if (did_reuse) reusable_node_advance(&self->reusable_node);
           return true;
         }
@@ -1504,11 +1695,20 @@ static bool ts_parser__advance(
           bool is_fragile = table_entry.action_count > 1;
           bool end_of_non_terminal_extra = lookahead.ptr == NULL;
           LOG("reduce sym:%s, child_count:%u", SYM_NAME(action.reduce.symbol), action.reduce.child_count);
+          TRACE(
+            TSTraceEventTypeReduce,
+            .state = state,
+            .symbol = action.reduce.symbol,
+            .version = version,
+            .byte = position,
+            .value = action.reduce.child_count
+          );
           StackVersion reduction_version = ts_parser__reduce(
             self, version, action.reduce.symbol, action.reduce.child_count,
             action.reduce.dynamic_precedence, action.reduce.production_id,
             is_fragile, end_of_non_terminal_extra
           );
+          self->stats.reduce_count++;
           if (reduction_version != STACK_VERSION_NONE) {
             last_reduction_version = reduction_version;
           }
@@ -1517,6 +1717,7 @@ static bool ts_parser__advance(
 
         case TSParseActionTypeAccept: {
           LOG("accept");
+          TRACE(TSTraceEventTypeAccept, .state = state, .version = version, .byte = position);
           ts_parser__accept(self, version, lookahead);
           return true;
         }
@@ -1616,6 +1817,13 @@ static bool ts_parser__advance(
     // version advances successfully, then this version can simply be removed.
     // But if all versions end up paused, then error recovery is needed.
     LOG("detect_error");
+    TRACE(
+      TSTraceEventTypeDetectError,
+      .state = state,
+      .symbol = lookahead.ptr ? ts_subtree_symbol(lookahead) : ts_builtin_sym_end,
+      .version = version,
+      .byte = position
+    );
     ts_stack_pause(self->stack, version, lookahead);
     return true;
   }
@@ -1624,6 +1832,10 @@ static bool ts_parser__advance(
 static unsigned ts_parser__condense_stack(TSParser *self) {
   bool made_changes = false;
   unsigned min_error_cost = UINT_MAX;
+  uint32_t version_count = ts_stack_version_count(self->stack);
+  if (version_count > self->stats.max_version_count) {
+    self->stats.max_version_count = version_count;
+  }
   for (StackVersion i = 0; i < ts_stack_version_count(self->stack); i++) {
     // Prune any versions that have been marked for removal.
     if (ts_stack_is_halted(self->stack, i)) {
@@ -1689,6 +1901,21 @@ static unsigned ts_parser__condense_stack(TSParser *self) {
     made_changes = true;
   }
 
+  // Once the recovery budget has been spent, only pursue the most promising
+  // of the versions that are recovering from an error.
+  if (!ts_parser__can_explore_recoveries(self)) {
+    bool has_version_in_error = false;
+    for (StackVersion i = 0; i < ts_stack_version_count(self->stack); i++) {
+      if (!ts_parser__version_status(self, i).is_in_error) continue;
+      if (has_version_in_error) {
+        ts_stack_remove_version(self->stack, i);
+        i--;
+        made_changes = true;
+      }
+      has_version_in_error = true;
+    }
+  }
+
   // If the best-performing stack version is currently paused, or all
   // versions are paused, then resume the best paused version and begin
   // the error recovery process. Otherwise, remove the paused versions.
@@ -1698,6 +1925,12 @@ static unsigned ts_parser__condense_stack(TSParser *self) {
       if (ts_stack_is_paused(self->stack, i)) {
         if (!has_unpaused_version && self->accept_count < MAX_VERSION_COUNT) {
           LOG("resume version:%u", i);
+          TRACE(
+            TSTraceEventTypeResume,
+            .state = ts_stack_state(self->stack, i),
+            .version = i,
+            .byte = ts_stack_position(self->stack, i).bytes
+          );
           min_error_cost = ts_stack_error_cost(self->stack, i);
           Subtree lookahead = ts_stack_resume(self->stack, i);
           ts_parser__handle_error(self, i, lookahead);
@@ -1713,16 +1946,138 @@ static unsigned ts_parser__condense_stack(TSParser *self) {
     }
   }
 
+  // The current error region ends once the most promising version has parsed
+  // enough nodes without any further errors.
+  if (self->recovery_count > 0 && ts_stack_version_count(self->stack) > 0) {
+    ErrorStatus status = ts_parser__version_status(self, 0);
+    if (!status.is_in_error && status.node_count >= MIN_NODE_COUNT_AFTER_ERROR_REGION) {
+      self->recovery_count = 0;
+    }
+  }
+
   if (made_changes) {
     LOG("condense");
+    TRACE(TSTraceEventTypeCondense, .value = ts_stack_version_count(self->stack));
     LOG_STACK();
   }
 
   return min_error_cost;
 }
 
+static void ts_parser__stream_node(TSParser *self, TSNode node) {
+  LOG("stream_node sym:%s", SYM_NAME(ts_node_symbol(node)));
+  self->node_stream.emit(self->node_stream.payload, node);
+  self->stream_goal_byte = ts_node_end_byte(node) + 1;
+}
+
+// Pass the visible nodes within the given subtree to the node stream, skipping
+// any that have already been passed. If the subtree itself is visible, it is
+// passed as one node, unless it is the root of the finished tree.
+static void ts_parser__stream_nodes(
+  TSParser *self,
+  Subtree subtree,
+  Length position,
+  bool is_root
+) {
+  TSTree tree = {
+    .root = subtree,
+    .language = self->language,
+    .included_ranges = self->lexer.included_ranges,
+    .included_range_count = self->lexer.included_range_count,
+    .arena = self->tree_pool.arena,
+  };
+  TSNode node = ts_node_new(
+    &tree,
+    &tree.root,
+    length_add(position, ts_subtree_padding(subtree)),
+    0
+  );
+  if (ts_subtree_visible(subtree) && !is_root) {
+    if (ts_node_end_byte(node) >= self->stream_goal_byte) {
+      ts_parser__stream_node(self, node);
+    }
+  } else {
+    TSTreeCursor cursor = ts_tree_cursor_new(node);
+    if (ts_tree_cursor_goto_first_child_for_byte(&cursor, self->stream_goal_byte) >= 0) {
+      do {
+        ts_parser__stream_node(self, ts_tree_cursor_current_node(&cursor));
+      } while (ts_tree_cursor_goto_next_sibling(&cursor));
+    }
+    ts_tree_cursor_delete(&cursor);
+  }
+
+  // The callback's navigation may have built caches for this temporary tree.
+  ts_tree_clear_caches(&tree);
+}
+
+// Determine whether the given subtree is a repetition within the grammar's
+// start rule, whose children will become children of the root node.
+static bool ts_parser__is_top_level_repetition(TSParser *self, Subtree subtree) {
+  if (ts_subtree_child_count(subtree) == 0) return false;
+  TSSymbol symbol = ts_subtree_symbol(subtree);
+  TSSymbolMetadata metadata = ts_language_symbol_metadata(self->language, symbol);
+  if (metadata.visible || metadata.named) return false;
+
+  // The repetition must be reducible to a symbol that is accepted at the
+  // end of the document.
+  TableEntry table_entry;
+  TSStateId state = ts_language_next_state(self->language, 1, symbol);
+  ts_language_table_entry(self->language, state, ts_builtin_sym_end, &table_entry);
+  for (uint32_t i = 0; i < table_entry.action_count; i++) {
+    TSParseAction action = table_entry.actions[i];
+    if (action.type != TSParseActionTypeReduce) continue;
+    TSStateId next_state = ts_language_next_state(self->language, 1, action.reduce.symbol);
+    TableEntry next_table_entry;
+    ts_language_table_entry(self->language, next_state, ts_builtin_sym_end, &next_table_entry);
+    for (uint32_t j = 0; j < next_table_entry.action_count; j++) {
+      if (next_table_entry.actions[j].type == TSParseActionTypeAccept) return true;
+    }
+  }
+  return false;
+}
+
+// Stream the top-level nodes at the bottom of the only stack version: the
+// contents of the repetition in the start rule, and any extras and errors
+// beneath it. Those extras and errors are only streamed once the repetition
+// has been reduced above them, because until then, an error recovery could
+// still merge a leading error with a subsequent one. The topmost subtree on
+// the stack is never streamed, for the same reason.
+static void ts_parser__stream_completed_nodes(TSParser *self) {
+  self->has_streamable_nodes = false;
+  SubtreeArray *subtrees = &self->stack_subtrees;
+  if (!ts_stack_get_subtrees(self->stack, 0, subtrees)) return;
+
+  uint32_t count = 0;
+  for (uint32_t i = subtrees->size; i > 1; i--) {
+    Subtree subtree = subtrees->contents[i - 1];
+    if (ts_parser__is_top_level_repetition(self, subtree)) {
+      count = subtrees->size - i + 1;
+      break;
+    }
+    if (!ts_subtree_extra(subtree) && !ts_subtree_is_error(subtree)) break;
+  }
+
+  Length position = length_zero();
+  for (uint32_t i = subtrees->size; i > subtrees->size - count; i--) {
+    Subtree subtree = subtrees->contents[i - 1];
+    ts_parser__stream_nodes(self, subtree, position, false);
+    position = length_add(position, ts_subtree_total_size(subtree));
+  }
+
+  // Free the contents of the repetition, now that they have been streamed.
+  if (self->discard_streamed_nodes && count > 0) {
+    Subtree repetition = subtrees->contents[subtrees->size - count];
+    Subtree placeholder = ts_subtree_new_placeholder(&self->tree_pool, repetition);
+    if (!ts_stack_replace_subtree(self->stack, 0, repetition, placeholder)) {
+      ts_subtree_release(&self->tree_pool, placeholder);
+    }
+  }
+  array_clear(subtrees);
+}
+
 static bool ts_parser_has_outstanding_parse(TSParser *self) {
   return (
+    self->has_paused_parse ||
     ts_stack_state(self->stack, 0) != 1 ||
     ts_stack_node_count_since_error(self->stack, 0) != 0
   );
@@ -1740,14 +2095,28 @@ TSParser *ts_parser_new(void) {
   self->finished_tree = NULL_SUBTREE;
   self->reusable_node = reusable_node_new();
   self->dot_graph_file = NULL;
+  self->trace_buffer = NULL;
+  self->node_stream = (TSNodeStream) {NULL, NULL};
+  self->stream_goal_byte = 0;
+  self->has_streamable_nodes = false;
+  self->discard_streamed_nodes = false;
   self->cancellation_flag = NULL;
   self->timeout_duration = 0;
+  self->recovery_budget = 0;
+  self->recovery_count = 0;
   self->end_clock = clock_null();
   self->operation_count = 0;
+  self->step_operation_count = 0;
+  self->step_operation_budget = 0;
+  self->step_progress_bytes = 0;
+  self->paused_position = 0;
+  self->has_paused_parse = false;
   self->old_tree = NULL_SUBTREE;
+  self->old_tree_arena = NULL;
   self->included_range_differences = (TSRangeArray) array_new();
   self->included_range_difference_index = 0;
-  ts_parser__set_cached_token(self, 0, NULL_SUBTREE, NULL_SUBTREE);
+  self->arena_allocation = false;
+  ts_parser__clear_token_cache(self);
   return self;
 }
 
@@ -1767,12 +2136,13 @@ void ts_parser_delete(TSParser *self) {
     self->old_tree = NULL_SUBTREE;
   }
   ts_lexer_delete(&self->lexer);
-  ts_parser__set_cached_token(self, 0, NULL_SUBTREE, NULL_SUBTREE);
+  ts_parser__clear_token_cache(self);
   ts_subtree_pool_delete(&self->tree_pool);
   reusable_node_delete(&self->reusable_node);
   array_delete(&self->trailing_extras);
   array_delete(&self->trailing_extras2);
   array_delete(&self->scratch_trees);
+  array_delete(&self->stack_subtrees);
   ts_free(self);
 }
 
@@ -1825,6 +2195,35 @@ void ts_parser_print_dot_graphs(TSParser *self, int fd) {
   }
 }
 
+void ts_parser_set_trace_buffer(TSParser *self, TSTraceBuffer *buffer) {
+  self->trace_buffer = buffer;
+}
+
+TSTraceBuffer *ts_parser_trace_buffer(const TSParser *self) {
+  return self->trace_buffer;
+}
+
+void ts_parser_set_node_stream(TSParser *self, TSNodeStream stream) {
+  self->node_stream = stream;
+}
+
+TSNodeStream ts_parser_node_stream(const TSParser *self) {
+  return self->node_stream;
+}
+
+void ts_parser_set_discard_streamed_nodes(TSParser *self, bool discard) {
+  self->discard_streamed_nodes = discard;
+}
+
+bool ts_parser_discard_streamed_nodes(const TSParser *self) {
+  return self->discard_streamed_nodes;
+}
+
+void ts_parser_stats(const TSParser *self, TSParserStats *stats) {
+  *stats = self->stats;
+  stats->subtree_allocation_count = self->tree_pool.allocation_count;
+}
+
 const size_t *ts_parser_cancellation_flag(const TSParser *self) {
   return (const size_t *)self->cancellation_flag;
 }
@@ -1841,6 +2240,22 @@ void ts_parser_set_timeout_micros(TSParser *self, uint64_t timeout_micros) {
   self->timeout_duration = duration_from_micros(timeout_micros);
 }
 
+uint32_t ts_parser_recovery_budget(const TSParser *self) {
+  return self->recovery_budget;
+}
+
+void ts_parser_set_recovery_budget(TSParser *self, uint32_t budget) {
+  self->recovery_budget = budget;
+}
+
+bool ts_parser_arena_allocation(const TSParser *self) {
+  return self->arena_allocation;
+}
+
+void ts_parser_set_arena_allocation(TSParser *self, bool enabled) {
+  self->arena_allocation = enabled;
+}
+
 bool ts_parser_set_included_ranges(
   TSParser *self,
   const TSRange *ranges,
@@ -1866,31 +2281,54 @@ void ts_parser_reset(TSParser *self) {
   reusable_node_clear(&self->reusable_node);
   ts_lexer_reset(&self->lexer, length_zero());
   ts_stack_clear(self->stack);
-  ts_parser__set_cached_token(self, 0, NULL_SUBTREE, NULL_SUBTREE);
+  ts_parser__clear_token_cache(self);
   if (self->finished_tree.ptr) {
     ts_subtree_release(&self->tree_pool, self->finished_tree);
     self->finished_tree = NULL_SUBTREE;
   }
+
+  // The arenas must outlive all of the subtrees that were released above.
+  ts_subtree_arena_release(self->tree_pool.arena);
+  self->tree_pool.arena = NULL;
+  ts_subtree_arena_release(self->old_tree_arena);
+  self->old_tree_arena = NULL;
   self->accept_count = 0;
+  self->stream_goal_byte = 0;
+  self->has_streamable_nodes = false;
+  self->step_progress_bytes = 0;
+  self->paused_position = 0;
+  self->has_paused_parse = false;
 }
 
-TSTree *ts_parser_parse(
-  TSParser *self,
-  const TSTree *old_tree,
-  TSInput input
-) {
-  if (!self->language || !input.read) return NULL;
-
-  ts_lexer_set_input(&self->lexer, input);
-
+// Parse the lexer's current input.
+static TSTree *ts_parser__parse(TSParser *self, const TSTree *old_tree) {
   array_clear(&self->included_range_differences);
   self->included_range_difference_index = 0;
 
-  if (ts_parser_has_outstanding_parse(self)) {
+  // Arenas are only freed along with the whole tree, so they are not used when
+  // the parser discards nodes as it goes.
+  bool is_resuming = ts_parser_has_outstanding_parse(self);
+  bool use_arena =
+    self->arena_allocation &&
+    !(self->discard_streamed_nodes && self->node_stream.emit);
+  if (!is_resuming && use_arena && !self->tree_pool.arena) {
+    // Each incremental parse into an arena keeps the old tree's arena alive.
+    // Once that chain of arenas grows too long, parse from scratch instead,
+    // so that the memory held by earlier generations can be reclaimed.
+    if (old_tree && old_tree->arena && old_tree->arena->generation + 1 >= MAX_ARENA_GENERATIONS) {
+      old_tree = NULL;
+    }
+    self->tree_pool.arena = ts_subtree_arena_new();
+  }
+
+  if (is_resuming) {
     LOG("resume_parsing");
+    TRACE(TSTraceEventTypeResumeParsing);
   } else if (old_tree) {
     ts_subtree_retain(old_tree->root);
     self->old_tree = old_tree->root;
+    self->old_tree_arena = old_tree->arena;
+    ts_subtree_arena_retain(self->old_tree_arena);
     ts_range_array_get_changed_ranges(
       old_tree->included_ranges, old_tree->included_range_count,
       self->lexer.included_ranges, self->lexer.included_range_count,
@@ -1898,6 +2336,7 @@ TSTree *ts_parser_parse(
     );
     reusable_node_reset(&self->reusable_node, old_tree->root);
     LOG("parse_after_edit");
+    TRACE(TSTraceEventTypeParseAfterEdit);
     LOG_TREE(self->old_tree);
     for (unsigned i = 0; i < self->included_range_differences.size; i++) {
       TSRange *range = &self->included_range_differences.contents[i];
@@ -1906,16 +2345,29 @@ TSTree *ts_parser_parse(
   } else {
     reusable_node_clear(&self->reusable_node);
     LOG("new_parse");
+    TRACE(TSTraceEventTypeNewParse);
   }
 
+  if (!is_resuming) {
+    self->recovery_count = 0;
+    self->stats = (TSParserStats) {0};
+    self->tree_pool.allocation_count = 0;
+  }
+
+  self->has_paused_parse = false;
   self->operation_count = 0;
+  self->step_operation_count = 0;
   if (self->timeout_duration) {
     self->end_clock = clock_after(clock_now(), self->timeout_duration);
   } else {
     self->end_clock = clock_null();
   }
 
-  uint32_t position = 0, last_position = 0, version_count = 0;
+  // When resuming, restore the position that the parse loop had reached, so
+  // that the stack versions are advanced in the same rounds as they would
+  // have been without pausing.
+  uint32_t position = 0, version_count = 0;
+  uint32_t last_position = is_resuming ? self->paused_position : 0;
   do {
     for (
       StackVersion version = 0;
@@ -1933,8 +2385,19 @@ TSTree *ts_parser_parse(
           ts_stack_position(self->stack, version).extent.row,
           ts_stack_position(self->stack, version).extent.column
         );
+        TRACE(
+          TSTraceEventTypeProcessVersion,
+          .state = ts_stack_state(self->stack, version),
+          .version = version,
+          .byte = ts_stack_position(self->stack, version).bytes,
+          .value = ts_stack_version_count(self->stack)
+        );
 
-        if (!ts_parser__advance(self, version, allow_node_reuse)) return NULL;
+        if (!ts_parser__advance(self, version, allow_node_reuse)) {
+          self->paused_position = last_position;
+          self->has_paused_parse = true;
+          return NULL;
+        }
         LOG_STACK();
 
         position = ts_stack_position(self->stack, version).bytes;
@@ -1958,6 +2421,17 @@ TSTree *ts_parser_parse(
       break;
     }
 
+    // Once there is only one stack version and no finished tree, any top-level
+    // nodes that have been reduced at the bottom of the stack can no longer change.
+    if (
+      self->node_stream.emit &&
+      self->has_streamable_nodes &&
+      ts_stack_version_count(self->stack) == 1 &&
+      !self->finished_tree.ptr
+    ) {
+      ts_parser__stream_completed_nodes(self);
+    }
+
     while (self->included_range_difference_index < self->included_range_differences.size) {
       TSRange *range = &self->included_range_differences.contents[self->included_range_difference_index];
       if (range->end_byte <= position) {
@@ -1966,24 +2440,115 @@ TSTree *ts_parser_parse(
         break;
       }
     }
+
+    // When parsing in steps, pause once the step's budget has been used up.
+    // This only happens between rounds, after every stack version has been
+    // advanced, so that each step makes progress on all of the versions.
+    if (
+      self->step_operation_budget &&
+      self->step_operation_count >= self->step_operation_budget &&
+      ts_stack_version_count(self->stack) > 0
+    ) {
+      self->paused_position = last_position;
+      self->has_paused_parse = true;
+      return NULL;
+    }
   } while (version_count != 0);
 
   assert(self->finished_tree.ptr);
   ts_subtree_balance(self->finished_tree, &self->tree_pool, self->language);
+  if (self->node_stream.emit) {
+    ts_parser__stream_nodes(self, self->finished_tree, length_zero(), true);
+  }
   LOG("done");
+  TRACE(TSTraceEventTypeDone, .byte = ts_subtree_total_bytes(self->finished_tree));
   LOG_TREE(self->finished_tree);
 
+  // If the new tree was allocated from an arena, that arena may contain
+  // references to subtrees that were reused from the old tree's arena.
+  // Otherwise, the new tree may directly contain those subtrees.
+  SubtreeArena *arena = self->old_tree_arena;
+  if (self->tree_pool.arena) {
+    ts_subtree_arena_add_dependency(self->tree_pool.arena, self->old_tree_arena);
+    arena = self->tree_pool.arena;
+  }
+
   TSTree *result = ts_tree_new(
     self->finished_tree,
     self->language,
     self->lexer.included_ranges,
-    self->lexer.included_range_count
+    self->lexer.included_range_count,
+    arena
   );
   self->finished_tree = NULL_SUBTREE;
   ts_parser_reset(self);
   return result;
 }
 
+TSTree *ts_parser_parse(
+  TSParser *self,
+  const TSTree *old_tree,
+  TSInput input
+) {
+  if (!self->language || !input.read) return NULL;
+  ts_lexer_set_input(&self->lexer, input);
+  return ts_parser__parse(self, old_tree);
+}
+
+static TSParseStatus ts_parser__parse_step(
+  TSParser *self,
+  const TSTree *old_tree,
+  uint32_t operation_budget,
+  TSTree **tree,
+  uint32_t *progress_bytes
+) {
+  self->step_operation_budget = operation_budget ? operation_budget : 1;
+  *tree = ts_parser__parse(self, old_tree);
+  self->step_operation_budget = 0;
+  if (*tree) {
+    if (progress_bytes) *progress_bytes = ts_subtree_total_bytes((*tree)->root);
+    return TSParseStatusComplete;
+  }
+
+  // Report the furthest position that any stack version has reached. Stack
+  // versions can be removed, so keep the progress from going backwards.
+  for (StackVersion i = 0, n = ts_stack_version_count(self->stack); i < n; i++) {
+    uint32_t bytes = ts_stack_position(self->stack, i).bytes;
+    if (bytes > self->step_progress_bytes) self->step_progress_bytes = bytes;
+  }
+  if (progress_bytes) *progress_bytes = self->step_progress_bytes;
+  return TSParseStatusIncomplete;
+}
+
+TSParseStatus ts_parser_parse_step(
+  TSParser *self,
+  const TSTree *old_tree,
+  TSInput input,
+  uint32_t operation_budget,
+  TSTree **tree,
+  uint32_t *progress_bytes
+) {
+  *tree = NULL;
+  if (!self->language || !input.read) return TSParseStatusFailed;
+  ts_lexer_set_input(&self->lexer, input);
+  return ts_parser__parse_step(self, old_tree, operation_budget, tree, progress_bytes);
+}
+
+TSParseStatus ts_parser_parse_string_step(
+  TSParser *self,
+  const TSTree *old_tree,
+  const char *string,
+  uint32_t length,
+  uint32_t operation_budget,
+  TSTree **tree,
+  uint32_t *progress_bytes
+) {
+  *tree = NULL;
+  if (!self->language) return TSParseStatusFailed;
+  ts_lexer_set_input_string(&self->lexer, string, length, TSInputEncodingUTF8);
+  return ts_parser__parse_step(self, old_tree, operation_budget, tree, progress_bytes);
+}
+
 TSTree *ts_parser_parse_string(
   TSParser *self,
   const TSTree *old_tree,
@@ -2000,12 +2565,164 @@ TSTree *ts_parser_parse_string_encoding(
   uint32_t length,
   TSInputEncoding encoding
 ) {
-  TSStringInput input = {string, length};
-  return ts_parser_parse(self, old_tree, (TSInput) {
-    &input,
-    ts_string_input_read,
-    encoding,
-  });
+  if (!self->language) return NULL;
+  ts_lexer_set_input_string(&self->lexer, string, length, encoding);
+  return ts_parser__parse(self, old_tree);
+}
+
+uint32_t ts_parser_parse_batch(
+  TSParser *self,
+  const char *const *strings,
+  const uint32_t *lengths,
+  uint32_t count,
+  TSTree **trees,
+  uint64_t *parse_times_micros
+) {
+  for (uint32_t i = 0; i < count; i++) {
+    TSClock start_clock = clock_now();
+    trees[i] = ts_parser_parse_string(self, NULL, strings[i], lengths[i]);
+    if (parse_times_micros) {
+      parse_times_micros[i] = duration_to_micros(clock_duration(start_clock, clock_now()));
+    }
+    if (!trees[i]) return i;
+  }
+  return count;
+}
+
+static void ts_parser__parse_chunk(void *payload) {
+  ParseChunk *chunk = payload;
+  TSParser *parser = ts_parser_new();
+  ts_parser_set_language(parser, chunk->language);
+  parser->timeout_duration = chunk->timeout_duration;
+  parser->recovery_budget = chunk->recovery_budget;
+  parser->cancellation_flag = chunk->cancellation_flag;
+  chunk->tree = ts_parser_parse_string(parser, NULL, chunk->string, chunk->length);
+  ts_parser_delete(parser);
+}
+
+TSTree *ts_parser_parse_parallel(
+  TSParser *self,
+  const char *string,
+  uint32_t length,
+  uint32_t thread_count
+) {
+  if (!self->language) return NULL;
+
+  // The chunks are parsed independently of each other, so this only works
+  // if the way that the input is tokenized doesn't depend on any state other
+  // than the parse state.
+  uint32_t included_range_count;
+  const TSRange *included_ranges = ts_lexer_included_ranges(&self->lexer, &included_range_count);
+  bool can_split =
+    !ts_parser_has_outstanding_parse(self) &&
+    self->language->external_token_count == 0 &&
+    included_range_count == 1 &&
+    included_ranges[0].start_byte == 0 &&
+    included_ranges[0].end_byte == UINT32_MAX;
+
+  // Split the input into chunks that end at line boundaries, because
+  // tokens rarely span lines, and no token's behavior can depend on its
+  // column if the chunks start at column zero.
+  Array(ParseChunk) chunks = array_new();
+  if (can_split && thread_count > 1 && length >= 2 * MIN_PARALLEL_CHUNK_SIZE) {
+    uint32_t chunk_count = length / MIN_PARALLEL_CHUNK_SIZE;
+    if (chunk_count > thread_count) chunk_count = thread_count;
+    array_reserve(&chunks, chunk_count);
+
+    uint32_t chunk_start = 0;
+    for (uint32_t i = 1; chunk_start < length; i++) {
+      uint32_t chunk_end = length;
+      if (i < chunk_count) {
+        uint32_t target = (uint64_t)length * i / chunk_count;
+        if (target < chunk_start) continue;
+        const char *newline = memchr(&string[target], '\n', length - target);
+        if (newline) chunk_end = newline - string + 1;
+      }
+      array_push(&chunks, ((ParseChunk) {
+        .language = self->language,
+        .string = &string[chunk_start],
+        .length = chunk_end - chunk_start,
+        .timeout_duration = self->timeout_duration,
+        .recovery_budget = self->recovery_budget,
+        .cancellation_flag = self->cancellation_flag,
+      }));
+      chunk_start = chunk_end;
+    }
+  }
+
+  if (chunks.size < 2) {
+    array_delete(&chunks);
+    return ts_parser_parse_string(self, NULL, string, length);
+  }
+
+  // Parse the first chunk on this thread, and each of the other chunks on
+  // its own thread. If a thread can't be started, parse its chunk here too.
+  for (uint32_t i = 1; i < chunks.size; i++) {
+    ParseChunk *chunk = &chunks.contents[i];
+    chunk->is_running = ts_thread_spawn(&chunk->thread, ts_parser__parse_chunk, chunk);
+  }
+  bool did_finish = true;
+  for (uint32_t i = 0; i < chunks.size; i++) {
+    ParseChunk *chunk = &chunks.contents[i];
+    if (chunk->is_running) {
+      ts_thread_join(&chunk->thread);
+    } else {
+      ts_parser__parse_chunk(chunk);
+    }
+    if (!chunk->tree) did_finish = false;
+  }
+
+  if (!did_finish) {
+    for (uint32_t i = 0; i < chunks.size; i++) {
+      ts_tree_delete(chunks.contents[i].tree);
+    }
+    array_delete(&chunks);
+    return NULL;
+  }
+
+  // Combine the chunks' trees into a single tree that spans the entire input.
+  // Then mark the boundaries between the chunks as edited, so that the nodes
+  // around them are not reused. Near the boundaries, the chunks' trees are
+  // likely to contain errors, and their tokens may be truncated.
+  SubtreeArray chunk_roots = array_new();
+  array_reserve(&chunk_roots, chunks.size);
+  for (uint32_t i = 0; i < chunks.size; i++) {
+    TSTree *tree = chunks.contents[i].tree;
+    ts_subtree_retain(tree->root);
+    array_push(&chunk_roots, tree->root);
+    ts_tree_delete(tree);
+  }
+  Subtree root = ts_subtree_from_mut(ts_subtree_new_node(
+    &self->tree_pool,
+    ts_subtree_symbol(chunk_roots.contents[0]),
+    &chunk_roots,
+    0,
+    self->language
+  ));
+  TSTree *chunked_tree = ts_tree_new(root, self->language, included_ranges, included_range_count, NULL);
+
+  Length chunk_end = length_zero();
+  for (uint32_t i = 0; i + 1 < chunks.size; i++) {
+    chunk_end = length_add(chunk_end, ts_subtree_total_size(ts_subtree_children(chunked_tree->root)[i]));
+    TSPoint next_point = string[chunk_end.bytes] == '\n'
+      ? (TSPoint) {chunk_end.extent.row + 1, 0}
+      : (TSPoint) {chunk_end.extent.row, chunk_end.extent.column + 1};
+    ts_tree_edit(chunked_tree, &(TSInputEdit) {
+      .start_byte = chunk_end.bytes,
+      .old_end_byte = chunk_end.bytes + 1,
+      .new_end_byte = chunk_end.bytes + 1,
+      .start_point = chunk_end.extent,
+      .old_end_point = next_point,
+      .new_end_point = next_point,
+    });
+  }
+  array_delete(&chunks);
+
+  // Reparse the entire input, reusing the chunks' nodes wherever they are
+  // valid, and reparsing the input around the boundaries between chunks.
+  TSTree *result = ts_parser_parse_string(self, chunked_tree, string, length);
+  ts_tree_delete(chunked_tree);
+  return result;
 }
 
 #undef LOG
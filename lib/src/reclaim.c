@@ -0,0 +1,115 @@
+#include "./alloc.h"
+#include "./atomic.h"
+#include "./reclaim.h"
+
+// A subtree whose last reference has been dropped, but whose memory has not
+// yet been freed, along with the arena that must outlive it.
+typedef struct RetiredSubtree {
+  Subtree subtree;
+  SubtreeArena *arena;
+  struct RetiredSubtree *next;
+} RetiredSubtree;
+
+// Subtrees that were deleted with `ts_tree_delete_deferred`, and which have not
+// yet been picked up by `ts_reclaim_step`.
+static RetiredSubtree *volatile deferred_subtrees = NULL;
+
+// The state of `ts_reclaim_step`, which is only accessed by the thread that
+// holds the `is_stepping` flag. The pool's tree stack holds the descendants of
+// the current subtree that still need to be freed.
+static volatile uint32_t is_stepping = 0;
+static RetiredSubtree *current_subtree = NULL;
+static RetiredSubtree *pending_subtrees = NULL;
+static SubtreePool step_pool = {{NULL, 0, 0}, {NULL, 0, 0}, NULL, 0};
+
+static inline bool ts_reclaim__lock(volatile uint32_t *flag) {
+  return atomic_compare_exchange(flag, 0, 1);
+}
+
+static inline void ts_reclaim__unlock(volatile uint32_t *flag) {
+  atomic_compare_exchange(flag, 1, 0);
+}
+
+static void ts_reclaim__push(
+  RetiredSubtree *volatile *list,
+  Subtree subtree,
+  SubtreeArena *arena
+) {
+  RetiredSubtree *entry = ts_malloc(sizeof(RetiredSubtree));
+  entry->subtree = subtree;
+  entry->arena = arena;
+  do {
+    entry->next = atomic_load_ptr((void *const volatile *)list);
+  } while (!atomic_compare_exchange_ptr((void *volatile *)list, entry->next, entry));
+}
+
+static RetiredSubtree *ts_reclaim__take_all(RetiredSubtree *volatile *list) {
+  RetiredSubtree *result;
+  do {
+    result = atomic_load_ptr((void *const volatile *)list);
+  } while (result && !atomic_compare_exchange_ptr((void *volatile *)list, result, NULL));
+  return result;
+}
+
+// Release a reference to a subtree and a reference to the arena that it may
+// have been allocated from, without freeing any memory on this thread.
+//
+// When this is the last reference to the subtree, it is queued so that its
+// memory can be freed later by `ts_reclaim_step`.
+void ts_reclaim_subtree_deferred(Subtree self, SubtreeArena *arena) {
+  if (self.data.is_inline || atomic_dec((volatile uint32_t *)&self.ptr->ref_count) > 0) {
+    ts_subtree_arena_release(arena);
+    return;
+  }
+  ts_reclaim__push(&deferred_subtrees, self, arena);
+}
+
+TSReclaimStatus ts_reclaim_step(uint32_t budget) {
+  if (!ts_reclaim__lock(&is_stepping)) return TSReclaimStatusBusy;
+
+  RetiredSubtree *entry = ts_reclaim__take_all(&deferred_subtrees);
+  while (entry) {
+    RetiredSubtree *next = entry->next;
+    entry->next = pending_subtrees;
+    pending_subtrees = entry;
+    entry = next;
+  }
+
+  for (;;) {
+    // Once all of the current subtree's nodes have been freed, its arena can
+    // be released too.
+    if (current_subtree && step_pool.tree_stack.size == 0) {
+      ts_subtree_arena_release(current_subtree->arena);
+      ts_free(current_subtree);
+      current_subtree = NULL;
+    }
+
+    if (budget == 0) break;
+
+    if (!current_subtree) {
+      if (!pending_subtrees) break;
+      current_subtree = pending_subtrees;
+      pending_subtrees = current_subtree->next;
+
+      // The subtree's reference count already dropped to zero when it was
+      // deferred, so it goes directly onto the stack of subtrees to free.
+      array_push(&step_pool.tree_stack, ts_subtree_to_mut_unsafe(current_subtree->subtree));
+    }
+
+    budget -= ts_subtree_release_pending(&step_pool, budget);
+  }
+
+  bool has_more_work =
+    current_subtree ||
+    pending_subtrees ||
+    atomic_load_ptr((void *const volatile *)&deferred_subtrees);
+
+  // Don't hold onto any memory once there is nothing left to do.
+  if (!current_subtree) {
+    ts_subtree_pool_delete(&step_pool);
+    step_pool = ts_subtree_pool_new(0);
+  }
+
+  ts_reclaim__unlock(&is_stepping);
+  return has_more_work ? TSReclaimStatusPending : TSReclaimStatusDone;
+}
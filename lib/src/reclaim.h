@@ -0,0 +1,16 @@
+#ifndef TREE_SITTER_RECLAIM_H_
+#define TREE_SITTER_RECLAIM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./subtree.h"
+
+void ts_reclaim_subtree_deferred(Subtree, SubtreeArena *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_RECLAIM_H_
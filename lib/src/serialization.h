@@ -0,0 +1,109 @@
+#ifndef TREE_SITTER_SERIALIZATION_H_
+#define TREE_SITTER_SERIALIZATION_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "./array.h"
+#include "./length.h"
+
+// Helpers for reading and writing the binary format produced by
+// `ts_tree_serialize`.
+//
+// All integers are written as unsigned LEB128 varints, so that the format
+// is compact and doesn't depend on the host's byte order. Signed integers
+// are zigzag-encoded first.
+
+typedef Array(uint8_t) ByteArray;
+
+typedef struct {
+  const uint8_t *position;
+  const uint8_t *end;
+  bool failed;
+} ByteReader;
+
+static inline void byte_array_push_uint(ByteArray *self, uint32_t value) {
+  while (value >= 0x80) {
+    array_push(self, (uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  array_push(self, (uint8_t)value);
+}
+
+static inline void byte_array_push_int(ByteArray *self, int32_t value) {
+  byte_array_push_uint(self, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+static inline void byte_array_push_length(ByteArray *self, Length value) {
+  byte_array_push_uint(self, value.bytes);
+  byte_array_push_uint(self, value.extent.row);
+  byte_array_push_uint(self, value.extent.column);
+}
+
+// Overwrite four bytes at the given offset with a little-endian integer. This
+// is used for values that aren't known until after the data that follows
+// them has been written.
+static inline void byte_array_set_uint32(ByteArray *self, uint32_t offset, uint32_t value) {
+  for (unsigned i = 0; i < 4; i++) {
+    self->contents[offset + i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+// Once a read fails, the reader is marked as failed and all subsequent reads
+// return zero, so that callers only need to check for failure occasionally.
+static inline uint32_t byte_reader_read_uint(ByteReader *self) {
+  uint32_t result = 0;
+  for (unsigned shift = 0; shift < 35; shift += 7) {
+    if (self->position == self->end) break;
+    uint8_t byte = *self->position++;
+    result |= (uint32_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) return result;
+  }
+  self->failed = true;
+  self->position = self->end;
+  return 0;
+}
+
+static inline int32_t byte_reader_read_int(ByteReader *self) {
+  uint32_t value = byte_reader_read_uint(self);
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static inline Length byte_reader_read_length(ByteReader *self) {
+  Length result;
+  result.bytes = byte_reader_read_uint(self);
+  result.extent.row = byte_reader_read_uint(self);
+  result.extent.column = byte_reader_read_uint(self);
+  return result;
+}
+
+// Get a pointer to the next `length` bytes, advancing past them.
+static inline const uint8_t *byte_reader_read_bytes(ByteReader *self, uint32_t length) {
+  if (self->failed || (size_t)(self->end - self->position) < length) {
+    self->failed = true;
+    self->position = self->end;
+    return NULL;
+  }
+  const uint8_t *result = self->position;
+  self->position += length;
+  return result;
+}
+
+static inline uint32_t byte_reader_read_uint32(ByteReader *self) {
+  const uint8_t *bytes = byte_reader_read_bytes(self, 4);
+  if (!bytes) return 0;
+  return
+    (uint32_t)bytes[0] |
+    (uint32_t)bytes[1] << 8 |
+    (uint32_t)bytes[2] << 16 |
+    (uint32_t)bytes[3] << 24;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TREE_SITTER_SERIALIZATION_H_
@@ -8,7 +8,8 @@
 #include <stdio.h>
 
 #define MAX_LINK_COUNT 8
-#define MAX_NODE_POOL_SIZE 50
+#define MIN_NODE_SLAB_SIZE 64
+#define MAX_NODE_SLAB_SIZE 4096
 #define MAX_ITERATOR_COUNT 64
 
 #if defined _WIN32 && !defined __GNUC__
@@ -25,15 +26,19 @@ typedef struct {
   bool is_pending;
 } StackLink;
 
+// Nearly all stack nodes have exactly one link, so the first link is stored
+// inline. When stack versions are merged, any additional links are stored in
+// a separately allocated array.
 struct StackNode {
   TSStateId state;
-  Length position;
-  StackLink links[MAX_LINK_COUNT];
   short unsigned int link_count;
   uint32_t ref_count;
+  Length position;
   unsigned error_cost;
   unsigned node_count;
   int dynamic_precedence;
+  StackLink link;
+  StackLink *overflow_links;
 };
 
 typedef struct {
@@ -43,7 +48,14 @@ typedef struct {
   bool is_pending;
 } StackIterator;
 
-typedef Array(StackNode *) StackNodeArray;
+// Stack nodes are allocated from slabs, which grow in size as more nodes are
+// needed. Released nodes are kept in a free list, which is threaded through
+// their first link.
+typedef struct {
+  Array(StackNode *) slabs;
+  StackNode *free_list;
+  uint32_t live_count;
+} StackNodePool;
 
 typedef enum {
   StackStatusActive,
@@ -64,8 +76,8 @@ struct Stack {
   Array(StackHead) heads;
   StackSliceArray slices;
   Array(StackIterator) iterators;
-  StackNodeArray node_pool;
-  StackNode *base_node;
+  StackNodePool node_pool;
+  StackNode base_node;
   SubtreePool *subtree_pool;
 };
 
@@ -78,6 +90,60 @@ enum {
 
 typedef StackAction (*StackCallback)(void *, const StackIterator *);
 
+static uint32_t stack_node_pool__slab_size(uint32_t index) {
+  return index < 6 ? MIN_NODE_SLAB_SIZE << index : MAX_NODE_SLAB_SIZE;
+}
+
+static void stack_node_pool__add_free_nodes(StackNodePool *self, StackNode *slab, uint32_t size) {
+  for (uint32_t i = size; i > 0; i--) {
+    slab[i - 1].link.node = self->free_list;
+    self->free_list = &slab[i - 1];
+  }
+}
+
+static StackNode *stack_node_pool_alloc(StackNodePool *self) {
+  if (!self->free_list) {
+    uint32_t size = stack_node_pool__slab_size(self->slabs.size);
+    StackNode *slab = ts_malloc(size * sizeof(StackNode));
+    array_push(&self->slabs, slab);
+    stack_node_pool__add_free_nodes(self, slab, size);
+  }
+  StackNode *node = self->free_list;
+  self->free_list = node->link.node;
+  self->live_count++;
+  return node;
+}
+
+static void stack_node_pool_free(StackNodePool *self, StackNode *node) {
+  node->link.node = self->free_list;
+  self->free_list = node;
+  self->live_count--;
+}
+
+// Once every node has been released, free all of the slabs except the first
+// one, so that the memory used while parsing a large document is not retained.
+static void stack_node_pool_trim(StackNodePool *self) {
+  if (self->live_count > 0 || self->slabs.size <= 1) return;
+  for (uint32_t i = 1; i < self->slabs.size; i++) {
+    ts_free(self->slabs.contents[i]);
+  }
+  self->slabs.size = 1;
+  self->free_list = NULL;
+  stack_node_pool__add_free_nodes(self, self->slabs.contents[0], stack_node_pool__slab_size(0));
+}
+
+static void stack_node_pool_delete(StackNodePool *self) {
+  for (uint32_t i = 0; i < self->slabs.size; i++) {
+    ts_free(self->slabs.contents[i]);
+  }
+  array_delete(&self->slabs);
+  self->free_list = NULL;
+}
+
+inline StackLink *stack_node_link(StackNode *self, unsigned index) {
+  return index == 0 ? &self->link : &self->overflow_links[index - 1];
+}
+
 static void stack_node_retain(StackNode *self) {
   if (!self)
     return;
@@ -88,7 +154,7 @@ static void stack_node_retain(StackNode *self) {
 
 static void stack_node_release(
   StackNode *self,
-  StackNodeArray *pool,
+  StackNodePool *pool,
   SubtreePool *subtree_pool
 ) {
 recur:
@@ -99,20 +165,17 @@ recur:
   StackNode *first_predecessor = NULL;
   if (self->link_count > 0) {
     for (unsigned i = self->link_count - 1; i > 0; i--) {
-      StackLink link = self->links[i];
+      StackLink link = self->overflow_links[i - 1];
       if (link.subtree.ptr) ts_subtree_release(subtree_pool, link.subtree);
       stack_node_release(link.node, pool, subtree_pool);
     }
-    StackLink link = self->links[0];
+    StackLink link = self->link;
     if (link.subtree.ptr) ts_subtree_release(subtree_pool, link.subtree);
-    first_predecessor = self->links[0].node;
+    first_predecessor = self->link.node;
   }
 
-  if (pool->size < MAX_NODE_POOL_SIZE) {
-    array_push(pool, self);
-  } else {
-    ts_free(self);
-  }
+  if (self->overflow_links) ts_free(self->overflow_links);
+  stack_node_pool_free(pool, self);
 
   if (first_predecessor) {
     self = first_predecessor;
@@ -125,11 +188,9 @@ static StackNode *stack_node_new(
   Subtree subtree,
   bool is_pending,
   TSStateId state,
-  StackNodeArray *pool
+  StackNodePool *pool
 ) {
-  StackNode *node = pool->size > 0
-    ? array_pop(pool)
-    : ts_malloc(sizeof(StackNode));
+  StackNode *node = stack_node_pool_alloc(pool);
   *node = (StackNode) {
     .ref_count = 1,
     .link_count = 0,
@@ -138,7 +199,7 @@ static StackNode *stack_node_new(
 
   if (previous_node) {
     node->link_count = 1;
-    node->links[0] = (StackLink) {
+    node->link = (StackLink) {
       .node = previous_node,
       .subtree = subtree,
       .is_pending = is_pending,
@@ -190,7 +251,7 @@ static void stack_node_add_link(
   if (link.node == self) return;
 
   for (int i = 0; i < self->link_count; i++) {
-    StackLink *existing_link = &self->links[i];
+    StackLink *existing_link = stack_node_link(self, i);
     if (stack__subtree_is_equivalent(existing_link->subtree, link.subtree)) {
       // In general, we preserve ambiguities until they are removed from the stack
       // during a pop operation where multiple paths lead to the same node. But in
@@ -216,7 +277,7 @@ static void stack_node_add_link(
         existing_link->node->position.bytes == link.node->position.bytes
       ) {
         for (int j = 0; j < link.node->link_count; j++) {
-          stack_node_add_link(existing_link->node, link.node->links[j], subtree_pool);
+          stack_node_add_link(existing_link->node, *stack_node_link(link.node, j), subtree_pool);
         }
         int32_t dynamic_precedence = link.node->dynamic_precedence;
         if (link.subtree.ptr) {
@@ -231,11 +292,14 @@ static void stack_node_add_link(
   }
 
   if (self->link_count == MAX_LINK_COUNT) return;
+  if (self->link_count > 0 && !self->overflow_links) {
+    self->overflow_links = ts_malloc((MAX_LINK_COUNT - 1) * sizeof(StackLink));
+  }
 
   stack_node_retain(link.node);
   unsigned node_count = link.node->node_count;
   int dynamic_precedence = link.node->dynamic_precedence;
-  self->links[self->link_count++] = link;
+  *stack_node_link(self, self->link_count++) = link;
 
   if (link.subtree.ptr) {
     ts_subtree_retain(link.subtree);
@@ -249,7 +313,7 @@ static void stack_node_add_link(
 
 static void stack_head_delete(
   StackHead *self,
-  StackNodeArray *pool,
+  StackNodePool *pool,
   SubtreePool *subtree_pool
 ) {
   if (self->node) {
@@ -367,11 +431,11 @@ static StackSliceArray stack__iter(
         StackIterator *next_iterator;
         StackLink link;
         if (j == node->link_count) {
-          link = node->links[0];
+          link = node->link;
           next_iterator = &self->iterators.contents[i];
         } else {
           if (self->iterators.size >= MAX_ITERATOR_COUNT) continue;
-          link = node->links[j];
+          link = *stack_node_link(node, j);
           StackIterator current_iterator = self->iterators.contents[i];
           array_push(&self->iterators, current_iterator);
           next_iterator = array_back(&self->iterators);
@@ -408,14 +472,18 @@ Stack *ts_stack_new(SubtreePool *subtree_pool) {
   array_init(&self->heads);
   array_init(&self->slices);
   array_init(&self->iterators);
-  array_init(&self->node_pool);
+  array_init(&self->node_pool.slabs);
   array_reserve(&self->heads, 4);
   array_reserve(&self->slices, 4);
   array_reserve(&self->iterators, 4);
-  array_reserve(&self->node_pool, MAX_NODE_POOL_SIZE);
 
+  // The base node is stored inline, and is never returned to the node pool.
   self->subtree_pool = subtree_pool;
-  self->base_node = stack_node_new(NULL, NULL_SUBTREE, false, 1, &self->node_pool);
+  self->base_node = (StackNode) {
+    .ref_count = 1,
+    .state = 1,
+    .position = length_zero(),
+  };
   ts_stack_clear(self);
 
   return self;
@@ -426,16 +494,17 @@ void ts_stack_delete(Stack *self) {
     array_delete(&self->slices);
   if (self->iterators.contents)
     array_delete(&self->iterators);
-  stack_node_release(self->base_node, &self->node_pool, self->subtree_pool);
   for (uint32_t i = 0; i < self->heads.size; i++) {
     stack_head_delete(&self->heads.contents[i], &self->node_pool, self->subtree_pool);
   }
   array_clear(&self->heads);
-  if (self->node_pool.contents) {
-    for (uint32_t i = 0; i < self->node_pool.size; i++)
-      ts_free(self->node_pool.contents[i]);
-    array_delete(&self->node_pool);
+  for (unsigned i = 0; i < self->base_node.link_count; i++) {
+    StackLink link = *stack_node_link(&self->base_node, i);
+    if (link.subtree.ptr) ts_subtree_release(self->subtree_pool, link.subtree);
+    stack_node_release(link.node, &self->node_pool, self->subtree_pool);
   }
+  if (self->base_node.overflow_links) ts_free(self->base_node.overflow_links);
+  stack_node_pool_delete(&self->node_pool);
   array_delete(&self->heads);
   ts_free(self);
 }
@@ -468,7 +537,7 @@ unsigned ts_stack_error_cost(const Stack *self, StackVersion version) {
   unsigned result = head->node->error_cost;
   if (
     head->status == StackStatusPaused ||
-    (head->node->state == ERROR_STATE && !head->node->links[0].subtree.ptr)) {
+    (head->node->state == ERROR_STATE && !head->node->link.subtree.ptr)) {
     result += ERROR_COST_PER_RECOVERY;
   }
   return result;
@@ -547,7 +616,8 @@ inline StackAction pop_error_callback(void *payload, const StackIterator *iterat
 SubtreeArray ts_stack_pop_error(Stack *self, StackVersion version) {
   StackNode *node = array_get(&self->heads, version)->node;
   for (unsigned i = 0; i < node->link_count; i++) {
-    if (node->links[i].subtree.ptr && ts_subtree_is_error(node->links[i].subtree)) {
+    Subtree subtree = stack_node_link(node, i)->subtree;
+    if (subtree.ptr && ts_subtree_is_error(subtree)) {
       bool found_error = false;
       StackSliceArray pop = stack__iter(self, version, pop_error_callback, &found_error, 1);
       if (pop.size > 0) {
@@ -622,7 +692,7 @@ bool ts_stack_has_advanced_since_error(const Stack *self, StackVersion version)
   if (node->error_cost == 0) return true;
   while (node) {
     if (node->link_count > 0) {
-      Subtree subtree = node->links[0].subtree;
+      Subtree subtree = node->link.subtree;
       if (subtree.ptr) {
         if (ts_subtree_total_bytes(subtree) > 0) {
           return true;
@@ -630,7 +700,7 @@ bool ts_stack_has_advanced_since_error(const Stack *self, StackVersion version)
           node->node_count > head->node_count_at_last_error &&
           ts_subtree_error_cost(subtree) == 0
         ) {
-          node = node->links[0].node;
+          node = node->link.node;
           continue;
         }
       }
@@ -640,6 +710,35 @@ bool ts_stack_has_advanced_since_error(const Stack *self, StackVersion version)
   return false;
 }
 
+bool ts_stack_get_subtrees(const Stack *self, StackVersion version, SubtreeArray *subtrees) {
+  array_clear(subtrees);
+  const StackNode *node = array_get(&self->heads, version)->node;
+  while (node != &self->base_node) {
+    if (node->link_count != 1) return false;
+    if (node->link.subtree.ptr) array_push(subtrees, node->link.subtree);
+    node = node->link.node;
+  }
+  return true;
+}
+
+bool ts_stack_replace_subtree(
+  Stack *self,
+  StackVersion version,
+  Subtree old_subtree,
+  Subtree new_subtree
+) {
+  StackNode *node = array_get(&self->heads, version)->node;
+  while (node != &self->base_node && node->link_count > 0) {
+    if (node->link.subtree.ptr == old_subtree.ptr) {
+      ts_subtree_release(self->subtree_pool, node->link.subtree);
+      node->link.subtree = new_subtree;
+      return true;
+    }
+    node = node->link.node;
+  }
+  return false;
+}
+
 void ts_stack_remove_version(Stack *self, StackVersion version) {
   stack_head_delete(array_get(&self->heads, version), &self->node_pool, self->subtree_pool);
   array_erase(&self->heads, version);
@@ -681,7 +780,7 @@ bool ts_stack_merge(Stack *self, StackVersion version1, StackVersion version2) {
   StackHead *head1 = &self->heads.contents[version1];
   StackHead *head2 = &self->heads.contents[version2];
   for (uint32_t i = 0; i < head2->node->link_count; i++) {
-    stack_node_add_link(head1->node, head2->node->links[i], self->subtree_pool);
+    stack_node_add_link(head1->node, *stack_node_link(head2->node, i), self->subtree_pool);
   }
   if (head1->node->state == ERROR_STATE) {
     head1->node_count_at_last_error = head1->node->node_count;
@@ -735,13 +834,14 @@ Subtree ts_stack_resume(Stack *self, StackVersion version) {
 }
 
 void ts_stack_clear(Stack *self) {
-  stack_node_retain(self->base_node);
+  stack_node_retain(&self->base_node);
   for (uint32_t i = 0; i < self->heads.size; i++) {
     stack_head_delete(&self->heads.contents[i], &self->node_pool, self->subtree_pool);
   }
   array_clear(&self->heads);
+  stack_node_pool_trim(&self->node_pool);
   array_push(&self->heads, ((StackHead) {
-    .node = self->base_node,
+    .node = &self->base_node,
     .status = StackStatusActive,
     .last_external_token = NULL_SUBTREE,
     .lookahead_when_paused = NULL_SUBTREE,
@@ -817,8 +917,8 @@ bool ts_stack_print_dot_graph(Stack *self, const TSLanguage *language, FILE *f)
         fprintf(f, "label=\"?\"");
       } else if (
         node->link_count == 1 &&
-        node->links[0].subtree.ptr &&
-        ts_subtree_extra(node->links[0].subtree)
+        node->link.subtree.ptr &&
+        ts_subtree_extra(node->link.subtree)
       ) {
         fprintf(f, "shape=point margin=0 label=\"\"");
       } else {
@@ -836,7 +936,7 @@ bool ts_stack_print_dot_graph(Stack *self, const TSLanguage *language, FILE *f)
       );
 
       for (int j = 0; j < node->link_count; j++) {
-        StackLink link = node->links[j];
+        StackLink link = *stack_node_link(node, j);
         fprintf(f, "node_%p -> node_%p [", (void *)node, (void *)link.node);
         if (link.is_pending) fprintf(f, "style=dashed ");
         if (link.subtree.ptr && ts_subtree_extra(link.subtree)) fprintf(f, "fontcolor=gray ");
@@ -81,6 +81,17 @@ int ts_stack_dynamic_precedence(Stack *, StackVersion);
 
 bool ts_stack_has_advanced_since_error(const Stack *, StackVersion);
 
+// Get the subtrees on the given version of the stack, in order from the top
+// of the stack to the bottom. This returns false if the stack version has
+// more than one path to the bottom of the stack, because versions with
+// different subtrees have been merged.
+bool ts_stack_get_subtrees(const Stack *, StackVersion, SubtreeArray *);
+
+// Replace a subtree on the given version of the stack with another subtree of
+// the same size. If the old subtree is found, this transfers ownership of the
+// new subtree to the stack, releases the old subtree, and returns true.
+bool ts_stack_replace_subtree(Stack *, StackVersion, Subtree old_subtree, Subtree new_subtree);
+
 // Compute a summary of all the parse states near the top of the given
 // version of the stack and store the summary for later retrieval.
 void ts_stack_record_summary(Stack *, StackVersion, unsigned max_depth);
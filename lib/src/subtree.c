@@ -20,23 +20,122 @@ typedef struct {
 
 #define TS_MAX_INLINE_TREE_LENGTH UINT8_MAX
 #define TS_MAX_TREE_POOL_SIZE 32
+#define TS_ARENA_ALIGNMENT 8
+#define TS_ARENA_MIN_SLAB_SIZE 4096
+#define TS_ARENA_MAX_SLAB_SIZE (1024 * 1024)
+
+// SubtreeArena
+
+SubtreeArena *ts_subtree_arena_new(void) {
+  SubtreeArena *self = ts_malloc(sizeof(SubtreeArena));
+  self->ref_count = 1;
+  self->generation = 0;
+  self->has_heap_references = false;
+  self->slab_position = NULL;
+  self->slab_end = NULL;
+  self->next_slab_size = TS_ARENA_MIN_SLAB_SIZE;
+  array_init(&self->slabs);
+  array_init(&self->dependencies);
+  return self;
+}
+
+void ts_subtree_arena_retain(SubtreeArena *self) {
+  if (!self) return;
+  assert(self->ref_count > 0);
+  atomic_inc(&self->ref_count);
+}
+
+void ts_subtree_arena_release(SubtreeArena *self) {
+  if (!self) return;
+  assert(self->ref_count > 0);
+  if (atomic_dec(&self->ref_count) > 0) return;
+
+  Array(SubtreeArena *) stack = array_new();
+  array_push(&stack, self);
+  while (stack.size > 0) {
+    SubtreeArena *arena = array_pop(&stack);
+    for (unsigned i = 0; i < arena->dependencies.size; i++) {
+      SubtreeArena *dependency = arena->dependencies.contents[i];
+      assert(dependency->ref_count > 0);
+      if (atomic_dec(&dependency->ref_count) == 0) {
+        array_push(&stack, dependency);
+      }
+    }
+    for (unsigned i = 0; i < arena->slabs.size; i++) {
+      ts_free(arena->slabs.contents[i]);
+    }
+    array_delete(&arena->slabs);
+    array_delete(&arena->dependencies);
+    ts_free(arena);
+  }
+  array_delete(&stack);
+}
+
+// Record that subtrees in this arena may refer to subtrees in another arena,
+// so that the other arena's memory is kept alive as long as this one is.
+void ts_subtree_arena_add_dependency(SubtreeArena *self, SubtreeArena *dependency) {
+  if (!dependency || dependency == self) return;
+  for (unsigned i = 0; i < self->dependencies.size; i++) {
+    if (self->dependencies.contents[i] == dependency) return;
+  }
+  ts_subtree_arena_retain(dependency);
+  array_push(&self->dependencies, dependency);
+  if (dependency->has_heap_references) self->has_heap_references = true;
+  if (dependency->generation + 1 > self->generation) {
+    self->generation = dependency->generation + 1;
+  }
+}
+
+static void *ts_subtree_arena_allocate(SubtreeArena *self, size_t size) {
+  size = (size + TS_ARENA_ALIGNMENT - 1) & ~(size_t)(TS_ARENA_ALIGNMENT - 1);
+  if ((size_t)(self->slab_end - self->slab_position) >= size) {
+    void *result = self->slab_position;
+    self->slab_position += size;
+    return result;
+  }
+
+  // Allocations that are larger than a typical slab get a slab of their own,
+  // so that the remainder of the current slab can still be used.
+  if (size > self->next_slab_size) {
+    char *slab = ts_malloc(size);
+    array_push(&self->slabs, slab);
+    return slab;
+  }
+
+  char *slab = ts_malloc(self->next_slab_size);
+  array_push(&self->slabs, slab);
+  self->slab_position = slab + size;
+  self->slab_end = slab + self->next_slab_size;
+  if (self->next_slab_size < TS_ARENA_MAX_SLAB_SIZE) {
+    self->next_slab_size *= 2;
+  }
+  return slab;
+}
 
 // ExternalScannerState
 
-void ts_external_scanner_state_init(ExternalScannerState *self, const char *data, unsigned length) {
+void ts_external_scanner_state_init(
+  ExternalScannerState *self,
+  SubtreeArena *arena,
+  const char *data,
+  unsigned length
+) {
   self->length = length;
   if (length > sizeof(self->short_data)) {
-    self->long_data = ts_malloc(length);
+    self->long_data = arena ? ts_subtree_arena_allocate(arena, length) : ts_malloc(length);
     memcpy(self->long_data, data, length);
   } else {
     memcpy(self->short_data, data, length);
   }
 }
 
-ExternalScannerState ts_external_scanner_state_copy(const ExternalScannerState *self) {
+ExternalScannerState ts_external_scanner_state_copy(
+  const ExternalScannerState *self,
+  SubtreeArena *arena
+) {
   ExternalScannerState result = *self;
   if (self->length > sizeof(self->short_data)) {
-    result.long_data = ts_malloc(self->length);
+    result.long_data = arena ? ts_subtree_arena_allocate(arena, self->length) : ts_malloc(self->length);
     memcpy(result.long_data, self->long_data, self->length);
   }
   return result;
@@ -118,7 +217,7 @@ void ts_subtree_array_reverse(SubtreeArray *self) {
 // SubtreePool
 
 SubtreePool ts_subtree_pool_new(uint32_t capacity) {
-  SubtreePool self = {array_new(), array_new()};
+  SubtreePool self = {array_new(), array_new(), NULL, 0};
   array_reserve(&self.free_trees, capacity);
   return self;
 }
@@ -134,7 +233,10 @@ void ts_subtree_pool_delete(SubtreePool *self) {
 }
 
 static SubtreeHeapData *ts_subtree_pool_allocate(SubtreePool *self) {
-  if (self->free_trees.size > 0) {
+  self->allocation_count++;
+  if (self->arena) {
+    return ts_subtree_arena_allocate(self->arena, sizeof(SubtreeHeapData));
+  } else if (self->free_trees.size > 0) {
     return array_pop(&self->free_trees).ptr;
   } else {
     return ts_malloc(sizeof(SubtreeHeapData));
@@ -151,6 +253,25 @@ static void ts_subtree_pool_free(SubtreePool *self, SubtreeHeapData *tree) {
 
 // Subtree
 
+// Determine whether a subtree can be mutated in place using the given pool.
+//
+// Arena-allocated subtrees are only mutated while an arena is in use, so that
+// a subtree in an arena never acquires children whose memory is managed
+// separately.
+static inline bool ts_subtree_can_mutate_in_place(const SubtreePool *pool, Subtree self) {
+  return self.ptr->ref_count == 1 && (!self.ptr->is_arena || pool->arena);
+}
+
+static inline void ts_subtree_arena_track_children(SubtreeArena *arena, const Subtree *children, uint32_t count) {
+  if (arena->has_heap_references) return;
+  for (uint32_t i = 0; i < count; i++) {
+    if (!children[i].data.is_inline && !children[i].ptr->is_arena) {
+      arena->has_heap_references = true;
+      return;
+    }
+  }
+}
+
 static inline bool ts_subtree_can_inline(Length padding, Length size, uint32_t lookahead_bytes) {
   return
     padding.bytes < TS_MAX_INLINE_TREE_LENGTH &&
@@ -215,6 +336,7 @@ Subtree ts_subtree_new_leaf(
       .depends_on_column = depends_on_column,
       .is_missing = false,
       .is_keyword = is_keyword,
+      .is_arena = pool->arena != NULL,
       {{.first_leaf = {.symbol = 0, .parse_state = 0}}}
     };
     return (Subtree) {.ptr = data};
@@ -254,10 +376,13 @@ Subtree ts_subtree_new_error(
   return result;
 }
 
-// Clone a subtree.
-MutableSubtree ts_subtree_clone(Subtree self) {
+// Clone a subtree, allocating the copy from the pool's arena if it has one.
+MutableSubtree ts_subtree_clone(SubtreePool *pool, Subtree self) {
   size_t alloc_size = ts_subtree_alloc_size(self.ptr->child_count);
-  Subtree *new_children = ts_malloc(alloc_size);
+  pool->allocation_count++;
+  Subtree *new_children = pool->arena
+    ? ts_subtree_arena_allocate(pool->arena, alloc_size)
+    : ts_malloc(alloc_size);
   Subtree *old_children = ts_subtree_children(self);
   memcpy(new_children, old_children, alloc_size);
   SubtreeHeapData *result = (SubtreeHeapData *)&new_children[self.ptr->child_count];
@@ -265,12 +390,17 @@ MutableSubtree ts_subtree_clone(Subtree self) {
     for (uint32_t i = 0; i < self.ptr->child_count; i++) {
       ts_subtree_retain(new_children[i]);
     }
+    if (pool->arena) {
+      ts_subtree_arena_track_children(pool->arena, new_children, self.ptr->child_count);
+    }
   } else if (self.ptr->has_external_tokens) {
     result->external_scanner_state = ts_external_scanner_state_copy(
-      &self.ptr->external_scanner_state
+      &self.ptr->external_scanner_state,
+      pool->arena
     );
   }
   result->ref_count = 1;
+  result->is_arena = pool->arena != NULL;
   return (MutableSubtree) {.ptr = result};
 }
 
@@ -281,8 +411,8 @@ MutableSubtree ts_subtree_clone(Subtree self) {
 // perform a copy.
 MutableSubtree ts_subtree_make_mut(SubtreePool *pool, Subtree self) {
   if (self.data.is_inline) return (MutableSubtree) {self.data};
-  if (self.ptr->ref_count == 1) return ts_subtree_to_mut_unsafe(self);
-  MutableSubtree result = ts_subtree_clone(self);
+  if (ts_subtree_can_mutate_in_place(pool, self)) return ts_subtree_to_mut_unsafe(self);
+  MutableSubtree result = ts_subtree_clone(pool, self);
   ts_subtree_release(pool, self);
   return result;
 }
@@ -291,20 +421,25 @@ static void ts_subtree__compress(
   MutableSubtree self,
   unsigned count,
   const TSLanguage *language,
-  MutableSubtreeArray *stack
+  SubtreePool *pool
 ) {
+  MutableSubtreeArray *stack = &pool->tree_stack;
   unsigned initial_stack_size = stack->size;
 
   MutableSubtree tree = self;
   TSSymbol symbol = tree.ptr->symbol;
   for (unsigned i = 0; i < count; i++) {
-    if (tree.ptr->ref_count > 1 || tree.ptr->child_count < 2) break;
+    if (
+      !ts_subtree_can_mutate_in_place(pool, ts_subtree_from_mut(tree)) ||
+      tree.ptr->child_count < 2
+    ) break;
 
     MutableSubtree child = ts_subtree_to_mut_unsafe(ts_subtree_children(tree)[0]);
     if (
       child.data.is_inline ||
       child.ptr->child_count < 2 ||
-      child.ptr->ref_count > 1 ||
+      !ts_subtree_can_mutate_in_place(pool, ts_subtree_from_mut(child)) ||
+      child.ptr->is_arena != tree.ptr->is_arena ||
       child.ptr->symbol != symbol
     ) break;
 
@@ -312,7 +447,8 @@ static void ts_subtree__compress(
     if (
       grandchild.data.is_inline ||
       grandchild.ptr->child_count < 2 ||
-      grandchild.ptr->ref_count > 1 ||
+      !ts_subtree_can_mutate_in_place(pool, ts_subtree_from_mut(grandchild)) ||
+      grandchild.ptr->is_arena != tree.ptr->is_arena ||
       grandchild.ptr->symbol != symbol
     ) break;
 
@@ -336,7 +472,7 @@ static void ts_subtree__compress(
 void ts_subtree_balance(Subtree self, SubtreePool *pool, const TSLanguage *language) {
   array_clear(&pool->tree_stack);
 
-  if (ts_subtree_child_count(self) > 0 && self.ptr->ref_count == 1) {
+  if (ts_subtree_child_count(self) > 0 && ts_subtree_can_mutate_in_place(pool, self)) {
     array_push(&pool->tree_stack, ts_subtree_to_mut_unsafe(self));
   }
 
@@ -350,7 +486,7 @@ void ts_subtree_balance(Subtree self, SubtreePool *pool, const TSLanguage *langu
       if (repeat_delta > 0) {
         unsigned n = (unsigned)repeat_delta;
         for (unsigned i = n / 2; i > 0; i /= 2) {
-          ts_subtree__compress(tree, i, language, &pool->tree_stack);
+          ts_subtree__compress(tree, i, language, pool);
           n -= i;
         }
       }
@@ -358,13 +494,30 @@ void ts_subtree_balance(Subtree self, SubtreePool *pool, const TSLanguage *langu
 
     for (uint32_t i = 0; i < tree.ptr->child_count; i++) {
       Subtree child = ts_subtree_children(tree)[i];
-      if (ts_subtree_child_count(child) > 0 && child.ptr->ref_count == 1) {
+      if (ts_subtree_child_count(child) > 0 && ts_subtree_can_mutate_in_place(pool, child)) {
         array_push(&pool->tree_stack, ts_subtree_to_mut_unsafe(child));
       }
     }
   }
 }
 
+// Get the summary of the symbols that a child contributes to its parent's
+// summary, given the alias that the parent's production applies to it.
+static inline uint64_t ts_subtree__child_symbol_summary(
+  Subtree child,
+  TSSymbol alias_symbol,
+  const TSLanguage *language
+) {
+  uint64_t result = ts_subtree_symbol_summary(child);
+  TSSymbol symbol = alias_symbol;
+  if (!symbol && ts_subtree_visible(child)) symbol = ts_subtree_symbol(child);
+  if (symbol) {
+    if (symbol != ts_builtin_sym_error) symbol = language->public_symbol_map[symbol];
+    result |= ts_subtree_symbol_summary_bit(symbol);
+  }
+  return result;
+}
+
 // Assign all of the node's properties that depend on its children.
 void ts_subtree_summarize_children(
   MutableSubtree self,
@@ -381,6 +534,7 @@ void ts_subtree_summarize_children(
   self.ptr->depends_on_column = false;
   self.ptr->has_external_scanner_state_change = false;
   self.ptr->dynamic_precedence = 0;
+  self.ptr->symbol_summary = 0;
 
   uint32_t structural_index = 0;
   const TSSymbol *alias_sequence = ts_language_alias_sequence(language, self.ptr->production_id);
@@ -437,10 +591,14 @@ void ts_subtree_summarize_children(
     self.ptr->dynamic_precedence += ts_subtree_dynamic_precedence(child);
     self.ptr->visible_descendant_count += ts_subtree_visible_descendant_count(child);
 
-    if (alias_sequence && alias_sequence[structural_index] != 0 && !ts_subtree_extra(child)) {
+    TSSymbol alias_symbol = 0;
+    if (alias_sequence && !ts_subtree_extra(child)) alias_symbol = alias_sequence[structural_index];
+    self.ptr->symbol_summary |= ts_subtree__child_symbol_summary(child, alias_symbol, language);
+
+    if (alias_symbol) {
       self.ptr->visible_descendant_count++;
       self.ptr->visible_child_count++;
-      if (ts_language_symbol_metadata(language, alias_sequence[structural_index]).named) {
+      if (ts_language_symbol_metadata(language, alias_symbol).named) {
         self.ptr->named_child_count++;
       }
     } else if (ts_subtree_visible(child)) {
@@ -501,8 +659,12 @@ void ts_subtree_summarize_children(
 
 // Create a new parent node with the given children.
 //
-// This takes ownership of the children array.
+// This takes ownership of the children array. If the pool has an arena, the
+// children are copied into the arena and the array is freed. Otherwise, the
+// node's data is stored at the end of the array itself. The pool may be NULL,
+// in which case no arena is used.
 MutableSubtree ts_subtree_new_node(
+  SubtreePool *pool,
   TSSymbol symbol,
   SubtreeArray *children,
   unsigned production_id,
@@ -510,19 +672,33 @@ MutableSubtree ts_subtree_new_node(
 ) {
   TSSymbolMetadata metadata = ts_language_symbol_metadata(language, symbol);
   bool fragile = symbol == ts_builtin_sym_error || symbol == ts_builtin_sym_error_repeat;
+  SubtreeArena *arena = pool ? pool->arena : NULL;
+  uint32_t child_count = children->size;
 
   // Allocate the node's data at the end of the array of children.
-  size_t new_byte_size = ts_subtree_alloc_size(children->size);
-  if (children->capacity * sizeof(Subtree) < new_byte_size) {
-    children->contents = ts_realloc(children->contents, new_byte_size);
-    children->capacity = (uint32_t)(new_byte_size / sizeof(Subtree));
+  size_t new_byte_size = ts_subtree_alloc_size(child_count);
+  SubtreeHeapData *data;
+  if (pool) pool->allocation_count++;
+  if (arena) {
+    Subtree *new_children = ts_subtree_arena_allocate(arena, new_byte_size);
+    if (child_count > 0) {
+      memcpy(new_children, children->contents, child_count * sizeof(Subtree));
+      ts_subtree_arena_track_children(arena, new_children, child_count);
+    }
+    array_delete(children);
+    data = (SubtreeHeapData *)&new_children[child_count];
+  } else {
+    if (children->capacity * sizeof(Subtree) < new_byte_size) {
+      children->contents = ts_realloc(children->contents, new_byte_size);
+      children->capacity = (uint32_t)(new_byte_size / sizeof(Subtree));
+    }
+    data = (SubtreeHeapData *)&children->contents[child_count];
   }
-  SubtreeHeapData *data = (SubtreeHeapData *)&children->contents[children->size];
 
   *data = (SubtreeHeapData) {
     .ref_count = 1,
     .symbol = symbol,
-    .child_count = children->size,
+    .child_count = child_count,
     .visible = metadata.visible,
     .named = metadata.named,
     .has_changes = false,
@@ -530,6 +706,7 @@ MutableSubtree ts_subtree_new_node(
     .fragile_left = fragile,
     .fragile_right = fragile,
     .is_keyword = false,
+    .is_arena = arena != NULL,
     {{
       .visible_descendant_count = 0,
       .production_id = production_id,
@@ -546,12 +723,13 @@ MutableSubtree ts_subtree_new_node(
 // This node is treated as 'extra'. Its children are prevented from having
 // having any effect on the parse state.
 Subtree ts_subtree_new_error_node(
+  SubtreePool *pool,
   SubtreeArray *children,
   bool extra,
   const TSLanguage *language
 ) {
   MutableSubtree result = ts_subtree_new_node(
-    ts_builtin_sym_error, children, 0, language
+    pool, ts_builtin_sym_error, children, 0, language
   );
   result.ptr->extra = extra;
   return ts_subtree_from_mut(result);
@@ -580,6 +758,37 @@ Subtree ts_subtree_new_missing_leaf(
   return result;
 }
 
+// Create a leaf that takes the place of a subtree whose contents are no longer
+// needed. It has the same symbol, size and error cost as the original subtree,
+// so that the nodes around it are unaffected, but it can never be reused.
+Subtree ts_subtree_new_placeholder(SubtreePool *pool, Subtree self) {
+  SubtreeHeapData *data = ts_subtree_pool_allocate(pool);
+  *data = (SubtreeHeapData) {
+    .ref_count = 1,
+    .padding = ts_subtree_padding(self),
+    .size = ts_subtree_size(self),
+    .lookahead_bytes = ts_subtree_lookahead_bytes(self),
+    .error_cost = ts_subtree_error_cost(self),
+    .child_count = 0,
+    .symbol = ts_subtree_symbol(self),
+    .parse_state = TS_TREE_STATE_NONE,
+    .visible = ts_subtree_visible(self),
+    .named = ts_subtree_named(self),
+    .extra = ts_subtree_extra(self),
+    .fragile_left = true,
+    .fragile_right = true,
+    .has_changes = false,
+    .has_external_tokens = false,
+    .has_external_scanner_state_change = false,
+    .depends_on_column = false,
+    .is_missing = false,
+    .is_keyword = false,
+    .is_arena = pool->arena != NULL,
+    {{.first_leaf = {.symbol = 0, .parse_state = 0}}}
+  };
+  return (Subtree) {.ptr = data};
+}
+
 void ts_subtree_retain(Subtree self) {
   if (self.data.is_inline) return;
   assert(self.ptr->ref_count > 0);
@@ -596,7 +805,18 @@ void ts_subtree_release(SubtreePool *pool, Subtree self) {
     array_push(&pool->tree_stack, ts_subtree_to_mut_unsafe(self));
   }
 
-  while (pool->tree_stack.size > 0) {
+  ts_subtree_release_pending(pool, UINT32_MAX);
+}
+
+// Free the subtrees on the pool's tree stack, which are no longer referenced,
+// along with any of their descendants that are only referenced by them. Stop
+// after `budget` subtrees have been freed, leaving the rest on the stack.
+//
+// Returns the number of subtrees that were freed.
+uint32_t ts_subtree_release_pending(SubtreePool *pool, uint32_t budget) {
+  uint32_t count = 0;
+  while (pool->tree_stack.size > 0 && count < budget) {
+    count++;
     MutableSubtree tree = array_pop(&pool->tree_stack);
     if (tree.ptr->child_count > 0) {
       Subtree *children = ts_subtree_children(tree);
@@ -608,14 +828,15 @@ void ts_subtree_release(SubtreePool *pool, Subtree self) {
           array_push(&pool->tree_stack, ts_subtree_to_mut_unsafe(child));
         }
       }
-      ts_free(children);
-    } else {
+      if (!tree.ptr->is_arena) ts_free(children);
+    } else if (!tree.ptr->is_arena) {
       if (tree.ptr->has_external_tokens) {
         ts_external_scanner_state_delete(&tree.ptr->external_scanner_state);
       }
       ts_subtree_pool_free(pool, tree.ptr);
     }
   }
+  return count;
 }
 
 int ts_subtree_compare(Subtree left, Subtree right) {
@@ -728,9 +949,11 @@ Subtree ts_subtree_edit(Subtree self, const TSInputEdit *input_edit, SubtreePool
         data->fragile_right = false;
         data->has_changes = false;
         data->has_external_tokens = false;
+        data->has_external_scanner_state_change = false;
         data->depends_on_column = false;
         data->is_missing = result.data.is_missing;
         data->is_keyword = result.data.is_keyword;
+        data->is_arena = pool->arena != NULL;
         result.ptr = data;
       }
     } else {
@@ -832,104 +1055,364 @@ static size_t ts_subtree__write_char_to_string(char *str, size_t n, int32_t chr)
 
 static const char *const ROOT_FIELD = "__ROOT__";
 
-static size_t ts_subtree__write_to_string(
-  Subtree self, char *string, size_t limit,
-  const TSLanguage *language, bool include_all,
-  TSSymbol alias_symbol, bool alias_is_named, const char *field_name
-) {
-  if (!self.ptr) return snprintf(string, limit, "(NULL)");
-
-  char *cursor = string;
-  char **writer = (limit > 1) ? &cursor : &string;
-  bool is_root = field_name == ROOT_FIELD;
-  bool is_visible =
-    include_all ||
-    ts_subtree_missing(self) ||
-    (
-      alias_symbol
-        ? alias_is_named
-        : ts_subtree_visible(self) && ts_subtree_named(self)
-    );
+#define TS_WRITER_BUFFER_SIZE 1024
+
+typedef enum {
+  SubtreeWriteFormatSexp,
+  SubtreeWriteFormatXml,
+} SubtreeWriteFormat;
+
+typedef struct {
+  TSWriter writer;
+  const TSLanguage *language;
+  SubtreeWriteFormat format;
+  bool include_all;
+  TSSexpOptions sexp_options;
+  const char *source;
+  uint32_t source_length;
+  uint32_t depth;
+  bool did_write_node;
+  bool failed;
+  uint32_t size;
+  char buffer[TS_WRITER_BUFFER_SIZE];
+} SubtreeWriter;
+
+typedef struct {
+  Subtree tree;
+  Length position;
+  Length child_position;
+  const char *field_name;
+  TSSymbol alias_symbol;
+  bool alias_is_named;
+  bool is_visible;
+  bool is_written;
+  uint32_t child_index;
+  uint32_t structural_child_index;
+} SubtreeWriterEntry;
+
+static void ts_subtree_writer__flush(SubtreeWriter *self) {
+  if (self->size > 0 && !self->failed) {
+    self->failed = !self->writer.write(self->writer.payload, self->buffer, self->size);
+  }
+  self->size = 0;
+}
 
-  if (is_visible) {
-    if (!is_root) {
-      cursor += snprintf(*writer, limit, " ");
-      if (field_name) {
-        cursor += snprintf(*writer, limit, "%s: ", field_name);
+static void ts_subtree_writer__write(SubtreeWriter *self, const char *data, uint32_t length) {
+  if (self->size + length > TS_WRITER_BUFFER_SIZE) {
+    ts_subtree_writer__flush(self);
+    if (length > TS_WRITER_BUFFER_SIZE) {
+      if (!self->failed) {
+        self->failed = !self->writer.write(self->writer.payload, data, length);
       }
+      return;
     }
+  }
+  memcpy(&self->buffer[self->size], data, length);
+  self->size += length;
+}
 
-    if (ts_subtree_is_error(self) && ts_subtree_child_count(self) == 0 && self.ptr->size.bytes > 0) {
-      cursor += snprintf(*writer, limit, "(UNEXPECTED ");
-      cursor += ts_subtree__write_char_to_string(*writer, limit, self.ptr->lookahead_char);
-    } else {
-      TSSymbol symbol = alias_symbol ? alias_symbol : ts_subtree_symbol(self);
-      const char *symbol_name = ts_language_symbol_name(language, symbol);
-      if (ts_subtree_missing(self)) {
-        cursor += snprintf(*writer, limit, "(MISSING ");
-        if (alias_is_named || ts_subtree_named(self)) {
-          cursor += snprintf(*writer, limit, "%s", symbol_name);
-        } else {
-          cursor += snprintf(*writer, limit, "\"%s\"", symbol_name);
-        }
+static void ts_subtree_writer__write_string(SubtreeWriter *self, const char *string) {
+  ts_subtree_writer__write(self, string, strlen(string));
+}
+
+static void ts_subtree_writer__write_char(SubtreeWriter *self, int32_t chr) {
+  char string[16];
+  size_t length = ts_subtree__write_char_to_string(string, sizeof(string), chr);
+  ts_subtree_writer__write(self, string, length);
+}
+
+static void ts_subtree_writer__write_number(SubtreeWriter *self, uint32_t number) {
+  char string[10];
+  uint32_t i = sizeof(string);
+  do {
+    string[--i] = '0' + number % 10;
+    number /= 10;
+  } while (number > 0);
+  ts_subtree_writer__write(self, &string[i], sizeof(string) - i);
+}
+
+static void ts_subtree_writer__write_point(SubtreeWriter *self, TSPoint point) {
+  ts_subtree_writer__write(self, "[", 1);
+  ts_subtree_writer__write_number(self, point.row);
+  ts_subtree_writer__write(self, ", ", 2);
+  ts_subtree_writer__write_number(self, point.column);
+  ts_subtree_writer__write(self, "]", 1);
+}
+
+static void ts_subtree_writer__write_escaped(SubtreeWriter *self, const char *text, uint32_t length) {
+  uint32_t start = 0;
+  for (uint32_t i = 0; i < length; i++) {
+    const char *escape;
+    switch (text[i]) {
+      case '&': escape = "&amp;"; break;
+      case '<': escape = "&lt;"; break;
+      case '>': escape = "&gt;"; break;
+      default: continue;
+    }
+    ts_subtree_writer__write(self, &text[start], i - start);
+    ts_subtree_writer__write_string(self, escape);
+    start = i + 1;
+  }
+  ts_subtree_writer__write(self, &text[start], length - start);
+}
+
+static void ts_subtree_writer__write_separator(SubtreeWriter *self, bool indent) {
+  if (indent) {
+    ts_subtree_writer__write(self, "\n", 1);
+    for (uint32_t i = 0; i < self->depth; i++) {
+      ts_subtree_writer__write(self, "  ", 2);
+    }
+  } else {
+    ts_subtree_writer__write(self, " ", 1);
+  }
+}
+
+// In the XML format, and in the S-expression format with the `node_types`
+// option, nodes are visible in the same cases as in a tree cursor, and only
+// the named ones are written.
+static void ts_subtree_writer__set_cursor_visibility(SubtreeWriterEntry *entry) {
+  bool is_root = entry->field_name == ROOT_FIELD;
+  entry->is_visible = is_root || entry->alias_symbol || ts_subtree_visible(entry->tree);
+  entry->is_written = entry->is_visible && (
+    entry->alias_symbol
+      ? entry->alias_is_named
+      : ts_subtree_named(entry->tree)
+  );
+}
+
+static void ts_subtree_writer__enter_sexp(SubtreeWriter *self, SubtreeWriterEntry *entry) {
+  Subtree tree = entry->tree;
+  bool is_root = entry->field_name == ROOT_FIELD;
+  if (self->sexp_options.node_types) {
+    ts_subtree_writer__set_cursor_visibility(entry);
+  } else {
+    entry->is_visible =
+      self->include_all ||
+      ts_subtree_missing(tree) ||
+      (
+        entry->alias_symbol
+          ? entry->alias_is_named
+          : ts_subtree_visible(tree) && ts_subtree_named(tree)
+      );
+    entry->is_written = entry->is_visible;
+  }
+
+  if (entry->is_written) {
+    if (self->did_write_node) {
+      ts_subtree_writer__write_separator(self, self->sexp_options.indent);
+    }
+    if (!is_root && entry->field_name) {
+      ts_subtree_writer__write_string(self, entry->field_name);
+      ts_subtree_writer__write(self, ": ", 2);
+    }
+
+    TSSymbol symbol = entry->alias_symbol ? entry->alias_symbol : ts_subtree_symbol(tree);
+    const char *symbol_name = ts_language_symbol_name(self->language, symbol);
+    if (self->sexp_options.node_types) {
+      ts_subtree_writer__write(self, "(", 1);
+      ts_subtree_writer__write_string(self, symbol_name);
+    } else if (ts_subtree_is_error(tree) && ts_subtree_child_count(tree) == 0 && tree.ptr->size.bytes > 0) {
+      ts_subtree_writer__write_string(self, "(UNEXPECTED ");
+      ts_subtree_writer__write_char(self, tree.ptr->lookahead_char);
+    } else if (ts_subtree_missing(tree)) {
+      ts_subtree_writer__write_string(self, "(MISSING ");
+      if (entry->alias_is_named || ts_subtree_named(tree)) {
+        ts_subtree_writer__write_string(self, symbol_name);
       } else {
-        cursor += snprintf(*writer, limit, "(%s", symbol_name);
+        ts_subtree_writer__write(self, "\"", 1);
+        ts_subtree_writer__write_string(self, symbol_name);
+        ts_subtree_writer__write(self, "\"", 1);
       }
+    } else {
+      ts_subtree_writer__write(self, "(", 1);
+      ts_subtree_writer__write_string(self, symbol_name);
     }
-  } else if (is_root) {
-    TSSymbol symbol = ts_subtree_symbol(self);
-    const char *symbol_name = ts_language_symbol_name(language, symbol);
-    cursor += snprintf(*writer, limit, "(\"%s\")", symbol_name);
+
+    if (self->sexp_options.include_ranges) {
+      Length start = length_add(entry->position, ts_subtree_padding(tree));
+      Length end = length_add(start, ts_subtree_size(tree));
+      ts_subtree_writer__write(self, " ", 1);
+      ts_subtree_writer__write_point(self, start.extent);
+      ts_subtree_writer__write(self, " - ", 3);
+      ts_subtree_writer__write_point(self, end.extent);
+    }
+    self->did_write_node = true;
+  } else if (is_root && !self->sexp_options.node_types) {
+    TSSymbol symbol = ts_subtree_symbol(tree);
+    ts_subtree_writer__write(self, "(\"", 2);
+    ts_subtree_writer__write_string(self, ts_language_symbol_name(self->language, symbol));
+    ts_subtree_writer__write(self, "\")", 2);
+    self->did_write_node = true;
   }
 
-  if (ts_subtree_child_count(self)) {
-    const TSSymbol *alias_sequence = ts_language_alias_sequence(language, self.ptr->production_id);
-    const TSFieldMapEntry *field_map, *field_map_end;
-    ts_language_field_map(
-      language,
-      self.ptr->production_id,
-      &field_map,
-      &field_map_end
-    );
+  if (entry->is_visible) self->depth++;
+}
 
-    uint32_t structural_child_index = 0;
-    for (uint32_t i = 0; i < self.ptr->child_count; i++) {
-      Subtree child = ts_subtree_children(self)[i];
-      if (ts_subtree_extra(child)) {
-        cursor += ts_subtree__write_to_string(
-          child, *writer, limit,
-          language, include_all,
-          0, false, NULL
-        );
-      } else {
-        TSSymbol subtree_alias_symbol = alias_sequence
-          ? alias_sequence[structural_child_index]
-          : 0;
-        bool subtree_alias_is_named = subtree_alias_symbol
-          ? ts_language_symbol_metadata(language, subtree_alias_symbol).named
-          : false;
-
-        const char *child_field_name = is_visible ? NULL : field_name;
-        for (const TSFieldMapEntry *map = field_map; map < field_map_end; map++) {
-          if (!map->inherited && map->child_index == structural_child_index) {
-            child_field_name = language->field_names[map->field_id];
-            break;
-          }
-        }
+static void ts_subtree_writer__enter_xml(SubtreeWriter *self, SubtreeWriterEntry *entry) {
+  Subtree tree = entry->tree;
+  bool is_root = entry->field_name == ROOT_FIELD;
+  ts_subtree_writer__set_cursor_visibility(entry);
+
+  if (entry->is_written) {
+    if (self->did_write_node) ts_subtree_writer__write_separator(self, true);
+    TSSymbol symbol = entry->alias_symbol ? entry->alias_symbol : ts_subtree_symbol(tree);
+    ts_subtree_writer__write(self, "<", 1);
+    ts_subtree_writer__write_string(self, ts_language_symbol_name(self->language, symbol));
+    if (!is_root && entry->field_name) {
+      ts_subtree_writer__write(self, " type=\"", 7);
+      ts_subtree_writer__write_string(self, entry->field_name);
+      ts_subtree_writer__write(self, "\"", 1);
+    }
+    ts_subtree_writer__write(self, ">", 1);
+    self->did_write_node = true;
+  }
 
-        cursor += ts_subtree__write_to_string(
-          child, *writer, limit,
-          language, include_all,
-          subtree_alias_symbol, subtree_alias_is_named, child_field_name
-        );
-        structural_child_index++;
+  if (entry->is_visible) {
+    self->depth++;
+
+    // Write the entire text of each visible node that has no visible
+    // descendants, including any padding between its hidden descendants.
+    if (self->source && ts_subtree_visible_descendant_count(tree) == 0) {
+      uint32_t start = entry->position.bytes + ts_subtree_padding(tree).bytes;
+      uint32_t end = start + ts_subtree_size(tree).bytes;
+      if (end > self->source_length) end = self->source_length;
+      if (start < end) {
+        ts_subtree_writer__write_escaped(self, &self->source[start], end - start);
       }
     }
   }
+}
 
-  if (is_visible) cursor += snprintf(*writer, limit, ")");
+static void ts_subtree_writer__leave(SubtreeWriter *self, const SubtreeWriterEntry *entry) {
+  if (entry->is_visible) self->depth--;
+  if (!entry->is_written) return;
+  if (self->format == SubtreeWriteFormatXml) {
+    TSSymbol symbol = entry->alias_symbol ? entry->alias_symbol : ts_subtree_symbol(entry->tree);
+    ts_subtree_writer__write(self, "</", 2);
+    ts_subtree_writer__write_string(self, ts_language_symbol_name(self->language, symbol));
+    ts_subtree_writer__write(self, ">\n", 2);
+  } else {
+    ts_subtree_writer__write(self, ")", 1);
+  }
+}
 
-  return cursor - string;
+static void ts_subtree_writer__enter(SubtreeWriter *self, SubtreeWriterEntry *entry) {
+  if (self->format == SubtreeWriteFormatXml) {
+    ts_subtree_writer__enter_xml(self, entry);
+  } else {
+    ts_subtree_writer__enter_sexp(self, entry);
+  }
+}
+
+// Walk the tree iteratively, so that the amount of memory used depends only
+// on the depth of the tree, and not on the size of the output.
+static bool ts_subtree_writer__run(SubtreeWriter *self, Subtree tree, Length position) {
+  Array(SubtreeWriterEntry) stack = array_new();
+  array_push(&stack, ((SubtreeWriterEntry) {
+    .tree = tree,
+    .position = position,
+    .child_position = position,
+    .field_name = ROOT_FIELD,
+  }));
+  ts_subtree_writer__enter(self, array_back(&stack));
+
+  while (stack.size > 0 && !self->failed) {
+    SubtreeWriterEntry *entry = array_back(&stack);
+    Subtree parent = entry->tree;
+    if (entry->child_index == ts_subtree_child_count(parent)) {
+      ts_subtree_writer__leave(self, entry);
+      stack.size--;
+      continue;
+    }
+
+    Subtree child = ts_subtree_children(parent)[entry->child_index];
+    SubtreeWriterEntry child_entry = {
+      .tree = child,
+      .position = entry->child_position,
+      .child_position = entry->child_position,
+    };
+    if (!ts_subtree_extra(child)) {
+      const TSSymbol *alias_sequence = ts_language_alias_sequence(self->language, parent.ptr->production_id);
+      child_entry.alias_symbol = alias_sequence
+        ? alias_sequence[entry->structural_child_index]
+        : 0;
+      child_entry.alias_is_named = child_entry.alias_symbol
+        ? ts_language_symbol_metadata(self->language, child_entry.alias_symbol).named
+        : false;
+
+      const TSFieldMapEntry *field_map, *field_map_end;
+      ts_language_field_map(
+        self->language,
+        parent.ptr->production_id,
+        &field_map,
+        &field_map_end
+      );
+      child_entry.field_name = entry->is_visible ? NULL : entry->field_name;
+      for (const TSFieldMapEntry *map = field_map; map < field_map_end; map++) {
+        if (!map->inherited && map->child_index == entry->structural_child_index) {
+          child_entry.field_name = self->language->field_names[map->field_id];
+          break;
+        }
+      }
+      entry->structural_child_index++;
+    }
+    entry->child_index++;
+    entry->child_position = length_add(entry->child_position, ts_subtree_total_size(child));
+
+    array_push(&stack, child_entry);
+    ts_subtree_writer__enter(self, array_back(&stack));
+  }
+
+  array_delete(&stack);
+  ts_subtree_writer__flush(self);
+  return !self->failed;
+}
+
+bool ts_subtree_write_sexp(
+  Subtree self,
+  Length position,
+  const TSLanguage *language,
+  bool include_all,
+  TSSexpOptions options,
+  TSWriter writer
+) {
+  SubtreeWriter subtree_writer = {
+    .writer = writer,
+    .language = language,
+    .format = SubtreeWriteFormatSexp,
+    .include_all = include_all,
+    .sexp_options = options,
+  };
+  if (!self.ptr) {
+    ts_subtree_writer__write_string(&subtree_writer, "(NULL)");
+    ts_subtree_writer__flush(&subtree_writer);
+    return !subtree_writer.failed;
+  }
+  return ts_subtree_writer__run(&subtree_writer, self, position);
+}
+
+bool ts_subtree_write_xml(
+  Subtree self,
+  Length position,
+  const TSLanguage *language,
+  const char *source,
+  uint32_t source_length,
+  TSWriter writer
+) {
+  SubtreeWriter subtree_writer = {
+    .writer = writer,
+    .language = language,
+    .format = SubtreeWriteFormatXml,
+    .source = source,
+    .source_length = source_length,
+  };
+  return ts_subtree_writer__run(&subtree_writer, self, position);
+}
+
+static bool ts_subtree__write_to_array(void *payload, const char *data, uint32_t length) {
+  Array(char) *string = payload;
+  array_extend(string, length, data);
+  return true;
 }
 
 char *ts_subtree_string(
@@ -937,19 +1420,11 @@ char *ts_subtree_string(
   const TSLanguage *language,
   bool include_all
 ) {
-  char scratch_string[1];
-  size_t size = ts_subtree__write_to_string(
-    self, scratch_string, 1,
-    language, include_all,
-    0, false, ROOT_FIELD
-  ) + 1;
-  char *result = ts_malloc(size * sizeof(char));
-  ts_subtree__write_to_string(
-    self, result, size,
-    language, include_all,
-    0, false, ROOT_FIELD
-  );
-  return result;
+  Array(char) string = array_new();
+  TSWriter writer = {&string, ts_subtree__write_to_array};
+  ts_subtree_write_sexp(self, length_zero(), language, include_all, (TSSexpOptions) {0}, writer);
+  array_push(&string, '\0');
+  return string.contents;
 }
 
 void ts_subtree__print_dot_graph(const Subtree *self, uint32_t start_offset,
@@ -1037,3 +1512,299 @@ bool ts_subtree_external_scanner_state_eq(Subtree self, Subtree other) {
     state_other->length
   );
 }
+
+// Serialization
+//
+// Subtrees are written in post-order, so that when a parent node is read back,
+// all of its children are already on the stack. Each record begins with a set
+// of flags, which also determine which of the remaining fields are present.
+
+enum {
+  SerializedSubtreeIsInline = 1 << 0,
+  SerializedSubtreeVisible = 1 << 1,
+  SerializedSubtreeNamed = 1 << 2,
+  SerializedSubtreeExtra = 1 << 3,
+  SerializedSubtreeHasChanges = 1 << 4,
+  SerializedSubtreeIsMissing = 1 << 5,
+  SerializedSubtreeIsKeyword = 1 << 6,
+  SerializedSubtreeFragileLeft = 1 << 7,
+  SerializedSubtreeFragileRight = 1 << 8,
+  SerializedSubtreeHasExternalTokens = 1 << 9,
+  SerializedSubtreeHasExternalScannerStateChange = 1 << 10,
+  SerializedSubtreeDependsOnColumn = 1 << 11,
+};
+
+typedef struct {
+  Subtree tree;
+  uint32_t child_index;
+} SerializationStackEntry;
+
+static void ts_subtree__serialize_record(Subtree self, ByteArray *buffer) {
+  if (self.data.is_inline) {
+    uint32_t flags = SerializedSubtreeIsInline;
+    if (self.data.visible) flags |= SerializedSubtreeVisible;
+    if (self.data.named) flags |= SerializedSubtreeNamed;
+    if (self.data.extra) flags |= SerializedSubtreeExtra;
+    if (self.data.has_changes) flags |= SerializedSubtreeHasChanges;
+    if (self.data.is_missing) flags |= SerializedSubtreeIsMissing;
+    if (self.data.is_keyword) flags |= SerializedSubtreeIsKeyword;
+    byte_array_push_uint(buffer, flags);
+    byte_array_push_uint(buffer, self.data.symbol);
+    byte_array_push_uint(buffer, self.data.parse_state);
+    byte_array_push_length(buffer, ts_subtree_padding(self));
+    byte_array_push_uint(buffer, self.data.size_bytes);
+    byte_array_push_uint(buffer, self.data.lookahead_bytes);
+    return;
+  }
+
+  const SubtreeHeapData *data = self.ptr;
+  uint32_t flags = 0;
+  if (data->visible) flags |= SerializedSubtreeVisible;
+  if (data->named) flags |= SerializedSubtreeNamed;
+  if (data->extra) flags |= SerializedSubtreeExtra;
+  if (data->has_changes) flags |= SerializedSubtreeHasChanges;
+  if (data->is_missing) flags |= SerializedSubtreeIsMissing;
+  if (data->is_keyword) flags |= SerializedSubtreeIsKeyword;
+  if (data->fragile_left) flags |= SerializedSubtreeFragileLeft;
+  if (data->fragile_right) flags |= SerializedSubtreeFragileRight;
+  if (data->has_external_tokens) flags |= SerializedSubtreeHasExternalTokens;
+  if (data->has_external_scanner_state_change) flags |= SerializedSubtreeHasExternalScannerStateChange;
+  if (data->depends_on_column) flags |= SerializedSubtreeDependsOnColumn;
+  byte_array_push_uint(buffer, flags);
+  byte_array_push_uint(buffer, data->symbol);
+  byte_array_push_uint(buffer, data->parse_state);
+  byte_array_push_length(buffer, data->padding);
+  byte_array_push_length(buffer, data->size);
+  byte_array_push_uint(buffer, data->lookahead_bytes);
+  byte_array_push_uint(buffer, data->error_cost);
+  byte_array_push_uint(buffer, data->child_count);
+
+  if (data->child_count > 0) {
+    byte_array_push_uint(buffer, data->visible_child_count);
+    byte_array_push_uint(buffer, data->named_child_count);
+    byte_array_push_uint(buffer, data->visible_descendant_count);
+    byte_array_push_int(buffer, data->dynamic_precedence);
+    byte_array_push_uint(buffer, data->repeat_depth);
+    byte_array_push_uint(buffer, data->production_id);
+    byte_array_push_uint(buffer, data->first_leaf.symbol);
+    byte_array_push_uint(buffer, data->first_leaf.parse_state);
+  } else if (data->has_external_tokens) {
+    const ExternalScannerState *state = &data->external_scanner_state;
+    byte_array_push_uint(buffer, state->length);
+    array_extend(buffer, state->length, (const uint8_t *)ts_external_scanner_state_data(state));
+  } else if (data->symbol == ts_builtin_sym_error) {
+    byte_array_push_int(buffer, data->lookahead_char);
+  }
+}
+
+// Append the binary representation of a subtree to the given buffer, and
+// return the number of records that were written.
+//
+// Subtrees that are shared between several parents are written once for
+// each parent.
+uint32_t ts_subtree_serialize(Subtree self, ByteArray *buffer) {
+  uint32_t record_count = 0;
+  Array(SerializationStackEntry) stack = array_new();
+  array_push(&stack, ((SerializationStackEntry) {self, 0}));
+  while (stack.size > 0) {
+    SerializationStackEntry *entry = array_back(&stack);
+    if (entry->child_index < ts_subtree_child_count(entry->tree)) {
+      Subtree child = ts_subtree_children(entry->tree)[entry->child_index++];
+      array_push(&stack, ((SerializationStackEntry) {child, 0}));
+    } else {
+      ts_subtree__serialize_record(entry->tree, buffer);
+      record_count++;
+      stack.size--;
+    }
+  }
+  array_delete(&stack);
+  return record_count;
+}
+
+static inline bool ts_subtree__is_valid_symbol(const TSLanguage *language, uint32_t symbol) {
+  return
+    symbol < language->symbol_count ||
+    symbol == ts_builtin_sym_error ||
+    symbol == ts_builtin_sym_error_repeat;
+}
+
+static inline bool ts_subtree__is_valid_parse_state(const TSLanguage *language, uint32_t state) {
+  return state < language->state_count || state == TS_TREE_STATE_NONE;
+}
+
+// Read a subtree that was written by `ts_subtree_serialize`, consisting of the
+// given number of records.
+//
+// All of the subtree's heap data is allocated from the given arena, so no
+// subtrees need to be released if this fails. Instead, the reader is marked as
+// failed, and the arena can simply be released.
+Subtree ts_subtree_deserialize(
+  ByteReader *reader,
+  uint32_t record_count,
+  SubtreeArena *arena,
+  const TSLanguage *language
+) {
+  SubtreeArray stack = array_new();
+  for (uint32_t i = 0; i < record_count && !reader->failed; i++) {
+    uint32_t flags = byte_reader_read_uint(reader);
+    uint32_t symbol = byte_reader_read_uint(reader);
+    uint32_t parse_state = byte_reader_read_uint(reader);
+    if (
+      !ts_subtree__is_valid_symbol(language, symbol) ||
+      !ts_subtree__is_valid_parse_state(language, parse_state)
+    ) {
+      reader->failed = true;
+      break;
+    }
+
+    if (flags & SerializedSubtreeIsInline) {
+      Length padding = byte_reader_read_length(reader);
+      uint32_t size_bytes = byte_reader_read_uint(reader);
+      uint32_t lookahead_bytes = byte_reader_read_uint(reader);
+      Length size = {size_bytes, {0, size_bytes}};
+      if (symbol > UINT8_MAX || !ts_subtree_can_inline(padding, size, lookahead_bytes)) {
+        reader->failed = true;
+        break;
+      }
+      array_push(&stack, ((Subtree) {{
+        .parse_state = parse_state,
+        .symbol = symbol,
+        .padding_bytes = padding.bytes,
+        .padding_rows = padding.extent.row,
+        .padding_columns = padding.extent.column,
+        .size_bytes = size_bytes,
+        .lookahead_bytes = lookahead_bytes,
+        .visible = flags & SerializedSubtreeVisible,
+        .named = flags & SerializedSubtreeNamed,
+        .extra = flags & SerializedSubtreeExtra,
+        .has_changes = flags & SerializedSubtreeHasChanges,
+        .is_missing = flags & SerializedSubtreeIsMissing,
+        .is_keyword = flags & SerializedSubtreeIsKeyword,
+        .is_inline = true,
+      }}));
+      continue;
+    }
+
+    Length padding = byte_reader_read_length(reader);
+    Length size = byte_reader_read_length(reader);
+    uint32_t lookahead_bytes = byte_reader_read_uint(reader);
+    uint32_t error_cost = byte_reader_read_uint(reader);
+    uint32_t child_count = byte_reader_read_uint(reader);
+    if (reader->failed || child_count > stack.size) {
+      reader->failed = true;
+      break;
+    }
+
+    // Validate the fields of a node with children before building it. When
+    // the node has a production id, each of its structural children is looked
+    // up in the language's alias sequence for that production, so there can't
+    // be more of them than the sequences' length.
+    uint32_t visible_child_count = 0, named_child_count = 0, visible_descendant_count = 0;
+    uint32_t repeat_depth = 0, production_id = 0;
+    uint32_t first_leaf_symbol = 0, first_leaf_parse_state = 0;
+    int32_t dynamic_precedence = 0;
+    if (child_count > 0) {
+      visible_child_count = byte_reader_read_uint(reader);
+      named_child_count = byte_reader_read_uint(reader);
+      visible_descendant_count = byte_reader_read_uint(reader);
+      dynamic_precedence = byte_reader_read_int(reader);
+      repeat_depth = byte_reader_read_uint(reader);
+      production_id = byte_reader_read_uint(reader);
+      first_leaf_symbol = byte_reader_read_uint(reader);
+      first_leaf_parse_state = byte_reader_read_uint(reader);
+      if (
+        (production_id > 0 && production_id >= language->production_id_count) ||
+        !ts_subtree__is_valid_symbol(language, first_leaf_symbol) ||
+        !ts_subtree__is_valid_parse_state(language, first_leaf_parse_state)
+      ) {
+        reader->failed = true;
+        break;
+      }
+      if (production_id > 0) {
+        uint32_t structural_child_count = 0;
+        for (uint32_t j = stack.size - child_count; j < stack.size; j++) {
+          if (!ts_subtree_extra(stack.contents[j])) structural_child_count++;
+        }
+        if (structural_child_count > language->max_alias_sequence_length) {
+          reader->failed = true;
+          break;
+        }
+      }
+    }
+
+    // As with any other arena-allocated node, the children are stored
+    // immediately before the node's own data.
+    Subtree *children = ts_subtree_arena_allocate(arena, ts_subtree_alloc_size(child_count));
+    if (child_count > 0) {
+      stack.size -= child_count;
+      memcpy(children, &stack.contents[stack.size], child_count * sizeof(Subtree));
+    }
+    SubtreeHeapData *data = (SubtreeHeapData *)&children[child_count];
+    *data = (SubtreeHeapData) {
+      .ref_count = 1,
+      .padding = padding,
+      .size = size,
+      .lookahead_bytes = lookahead_bytes,
+      .error_cost = error_cost,
+      .child_count = child_count,
+      .symbol = symbol,
+      .parse_state = parse_state,
+      .visible = flags & SerializedSubtreeVisible,
+      .named = flags & SerializedSubtreeNamed,
+      .extra = flags & SerializedSubtreeExtra,
+      .fragile_left = flags & SerializedSubtreeFragileLeft,
+      .fragile_right = flags & SerializedSubtreeFragileRight,
+      .has_changes = flags & SerializedSubtreeHasChanges,
+      .has_external_tokens = flags & SerializedSubtreeHasExternalTokens,
+      .has_external_scanner_state_change = flags & SerializedSubtreeHasExternalScannerStateChange,
+      .depends_on_column = flags & SerializedSubtreeDependsOnColumn,
+      .is_missing = flags & SerializedSubtreeIsMissing,
+      .is_keyword = flags & SerializedSubtreeIsKeyword,
+      .is_arena = true,
+      {{.first_leaf = {.symbol = 0, .parse_state = 0}}}
+    };
+
+    if (child_count > 0) {
+      data->visible_child_count = visible_child_count;
+      data->named_child_count = named_child_count;
+      data->visible_descendant_count = visible_descendant_count;
+      data->dynamic_precedence = dynamic_precedence;
+      data->repeat_depth = repeat_depth;
+      data->production_id = production_id;
+      data->first_leaf.symbol = first_leaf_symbol;
+      data->first_leaf.parse_state = first_leaf_parse_state;
+
+      // The summary of the node's symbols isn't stored, because it can be
+      // computed from its children.
+      uint32_t structural_index = 0;
+      const TSSymbol *alias_sequence = ts_language_alias_sequence(language, production_id);
+      data->symbol_summary = 0;
+      for (uint32_t j = 0; j < child_count; j++) {
+        TSSymbol alias_symbol = 0;
+        if (!ts_subtree_extra(children[j])) {
+          if (alias_sequence) alias_symbol = alias_sequence[structural_index];
+          structural_index++;
+        }
+        data->symbol_summary |= ts_subtree__child_symbol_summary(children[j], alias_symbol, language);
+      }
+    } else if (data->has_external_tokens) {
+      uint32_t length = byte_reader_read_uint(reader);
+      const uint8_t *state = byte_reader_read_bytes(reader, length);
+      if (!state) break;
+      ts_external_scanner_state_init(&data->external_scanner_state, arena, (const char *)state, length);
+    } else if (symbol == ts_builtin_sym_error) {
+      data->lookahead_char = byte_reader_read_int(reader);
+    }
+
+    array_push(&stack, ((Subtree) {.ptr = data}));
+  }
+
+  Subtree result = NULL_SUBTREE;
+  if (!reader->failed && stack.size == 1) {
+    result = stack.contents[0];
+  } else {
+    reader->failed = true;
+  }
+  array_delete(&stack);
+  return result;
+}
@@ -12,6 +12,7 @@ extern "C" {
 #include "./array.h"
 #include "./error_costs.h"
 #include "./host.h"
+#include "./serialization.h"
 #include "tree_sitter/api.h"
 #include "tree_sitter/parser.h"
 
@@ -129,6 +130,7 @@ typedef struct {
   bool depends_on_column: 1;
   bool is_missing : 1;
   bool is_keyword : 1;
+  bool is_arena : 1;
 
   union {
     // Non-terminal subtrees (`child_count > 0`)
@@ -143,6 +145,7 @@ typedef struct {
         TSSymbol symbol;
         TSStateId parse_state;
       } first_leaf;
+      uint64_t symbol_summary;
     };
 
     // External terminal subtrees (`child_count == 0 && has_external_tokens`)
@@ -168,12 +171,40 @@ typedef union {
 typedef Array(Subtree) SubtreeArray;
 typedef Array(MutableSubtree) MutableSubtreeArray;
 
+// A region of memory from which subtrees can be allocated in bulk.
+//
+// Subtrees that are allocated from an arena are still reference counted,
+// so that they can be shared between trees, but their memory is never
+// freed individually. Instead, the arena's slabs are all freed at once
+// when the arena itself is released. An arena can depend on other arenas,
+// which is the case when a tree reuses nodes from a previous tree during
+// an incremental parse.
+typedef struct SubtreeArena SubtreeArena;
+
+struct SubtreeArena {
+  volatile uint32_t ref_count;
+  uint32_t generation;
+  bool has_heap_references;
+  char *slab_position;
+  char *slab_end;
+  size_t next_slab_size;
+  Array(char *) slabs;
+  Array(SubtreeArena *) dependencies;
+};
+
 typedef struct {
   MutableSubtreeArray free_trees;
   MutableSubtreeArray tree_stack;
+  SubtreeArena *arena;
+  uint32_t allocation_count;
 } SubtreePool;
 
-void ts_external_scanner_state_init(ExternalScannerState *, const char *, unsigned);
+SubtreeArena *ts_subtree_arena_new(void);
+void ts_subtree_arena_retain(SubtreeArena *);
+void ts_subtree_arena_release(SubtreeArena *);
+void ts_subtree_arena_add_dependency(SubtreeArena *, SubtreeArena *);
+
+void ts_external_scanner_state_init(ExternalScannerState *, SubtreeArena *, const char *, unsigned);
 const char *ts_external_scanner_state_data(const ExternalScannerState *);
 bool ts_external_scanner_state_eq(const ExternalScannerState *self, const char *, unsigned);
 void ts_external_scanner_state_delete(ExternalScannerState *self);
@@ -194,12 +225,14 @@ Subtree ts_subtree_new_leaf(
 Subtree ts_subtree_new_error(
   SubtreePool *, int32_t, Length, Length, uint32_t, TSStateId, const TSLanguage *
 );
-MutableSubtree ts_subtree_new_node(TSSymbol, SubtreeArray *, unsigned, const TSLanguage *);
-Subtree ts_subtree_new_error_node(SubtreeArray *, bool, const TSLanguage *);
+MutableSubtree ts_subtree_new_node(SubtreePool *, TSSymbol, SubtreeArray *, unsigned, const TSLanguage *);
+Subtree ts_subtree_new_error_node(SubtreePool *, SubtreeArray *, bool, const TSLanguage *);
 Subtree ts_subtree_new_missing_leaf(SubtreePool *, TSSymbol, Length, uint32_t, const TSLanguage *);
+Subtree ts_subtree_new_placeholder(SubtreePool *, Subtree);
 MutableSubtree ts_subtree_make_mut(SubtreePool *, Subtree);
 void ts_subtree_retain(Subtree);
 void ts_subtree_release(SubtreePool *, Subtree);
+uint32_t ts_subtree_release_pending(SubtreePool *, uint32_t);
 int ts_subtree_compare(Subtree, Subtree);
 void ts_subtree_set_symbol(MutableSubtree *, TSSymbol, const TSLanguage *);
 void ts_subtree_summarize(MutableSubtree, const Subtree *, uint32_t, const TSLanguage *);
@@ -207,10 +240,14 @@ void ts_subtree_summarize_children(MutableSubtree, const TSLanguage *);
 void ts_subtree_balance(Subtree, SubtreePool *, const TSLanguage *);
 Subtree ts_subtree_edit(Subtree, const TSInputEdit *edit, SubtreePool *);
 char *ts_subtree_string(Subtree, const TSLanguage *, bool include_all);
+bool ts_subtree_write_sexp(Subtree, Length, const TSLanguage *, bool include_all, TSSexpOptions, TSWriter);
+bool ts_subtree_write_xml(Subtree, Length, const TSLanguage *, const char *source, uint32_t source_length, TSWriter);
 void ts_subtree_print_dot_graph(Subtree, const TSLanguage *, FILE *);
 Subtree ts_subtree_last_external_token(Subtree);
 const ExternalScannerState *ts_subtree_external_scanner_state(Subtree self);
 bool ts_subtree_external_scanner_state_eq(Subtree, Subtree);
+uint32_t ts_subtree_serialize(Subtree, ByteArray *);
+Subtree ts_subtree_deserialize(ByteReader *, uint32_t, SubtreeArena *, const TSLanguage *);
 
 #define SUBTREE_GET(self, name) ((self).data.is_inline ? (self).data.name : (self).ptr->name)
 
@@ -303,6 +340,19 @@ static inline uint32_t ts_subtree_visible_descendant_count(Subtree self) {
     : self.ptr->visible_descendant_count;
 }
 
+// Each subtree stores a summary of the symbols of its visible descendants,
+// in which each public symbol sets the bit for its id modulo 64. A symbol
+// can only occur within the subtree if its bit is set.
+static inline uint64_t ts_subtree_symbol_summary_bit(TSSymbol symbol) {
+  return (uint64_t)1 << (symbol % 64);
+}
+
+static inline uint64_t ts_subtree_symbol_summary(Subtree self) {
+  return (self.data.is_inline || self.ptr->child_count == 0)
+    ? 0
+    : self.ptr->symbol_summary;
+}
+
 static inline uint32_t ts_subtree_node_count(Subtree self) {
   return
     ts_subtree_visible_descendant_count(self) +
@@ -0,0 +1,85 @@
+#ifndef TREE_SITTER_THREAD_H_
+#define TREE_SITTER_THREAD_H_
+
+#include <stdbool.h>
+
+// A minimal wrapper around the platform's threads, for spreading work across
+// multiple threads. On platforms without threads, `ts_thread_spawn` always
+// fails, and callers are expected to do the work on the current thread.
+
+typedef void (*TSThreadFunction)(void *);
+
+#if defined(__EMSCRIPTEN__) || defined(__wasi__) || defined(TREE_SITTER_NO_THREADS)
+
+typedef struct {
+  char unused;
+} TSThread;
+
+static inline bool ts_thread_spawn(TSThread *self, TSThreadFunction function, void *payload) {
+  (void)self;
+  (void)function;
+  (void)payload;
+  return false;
+}
+
+static inline void ts_thread_join(TSThread *self) {
+  (void)self;
+}
+
+#elif defined(_WIN32)
+
+#include <windows.h>
+
+typedef struct {
+  HANDLE handle;
+  TSThreadFunction function;
+  void *payload;
+} TSThread;
+
+static DWORD WINAPI ts_thread__run(LPVOID self) {
+  TSThread *thread = self;
+  thread->function(thread->payload);
+  return 0;
+}
+
+static inline bool ts_thread_spawn(TSThread *self, TSThreadFunction function, void *payload) {
+  self->function = function;
+  self->payload = payload;
+  self->handle = CreateThread(NULL, 0, ts_thread__run, self, 0, NULL);
+  return self->handle != NULL;
+}
+
+static inline void ts_thread_join(TSThread *self) {
+  WaitForSingleObject(self->handle, INFINITE);
+  CloseHandle(self->handle);
+}
+
+#else
+
+#include <pthread.h>
+
+typedef struct {
+  pthread_t handle;
+  TSThreadFunction function;
+  void *payload;
+} TSThread;
+
+static void *ts_thread__run(void *self) {
+  TSThread *thread = self;
+  thread->function(thread->payload);
+  return NULL;
+}
+
+static inline bool ts_thread_spawn(TSThread *self, TSThreadFunction function, void *payload) {
+  self->function = function;
+  self->payload = payload;
+  return pthread_create(&self->handle, NULL, ts_thread__run, self) == 0;
+}
+
+static inline void ts_thread_join(TSThread *self) {
+  pthread_join(self->handle, NULL);
+}
+
+#endif
+
+#endif  // TREE_SITTER_THREAD_H_
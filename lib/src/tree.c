@@ -1,14 +1,19 @@
 #include "tree_sitter/api.h"
 #include "./array.h"
+#include "./atomic.h"
 #include "./get_changed_ranges.h"
+#include "./language.h"
 #include "./length.h"
+#include "./reclaim.h"
+#include "./serialization.h"
 #include "./subtree.h"
 #include "./tree_cursor.h"
 #include "./tree.h"
 
 TSTree *ts_tree_new(
   Subtree root, const TSLanguage *language,
-  const TSRange *included_ranges, unsigned included_range_count
+  const TSRange *included_ranges, unsigned included_range_count,
+  SubtreeArena *arena
 ) {
   TSTree *result = ts_malloc(sizeof(TSTree));
   result->root = root;
@@ -16,20 +21,214 @@ TSTree *ts_tree_new(
   result->included_ranges = ts_calloc(included_range_count, sizeof(TSRange));
   memcpy(result->included_ranges, included_ranges, included_range_count * sizeof(TSRange));
   result->included_range_count = included_range_count;
+  result->arena = arena;
+  result->parent_cache = NULL;
+  result->child_indices = NULL;
+  ts_subtree_arena_retain(arena);
   return result;
 }
 
 TSTree *ts_tree_copy(const TSTree *self) {
   ts_subtree_retain(self->root);
-  return ts_tree_new(self->root, self->language, self->included_ranges, self->included_range_count);
+  return ts_tree_new(
+    self->root, self->language,
+    self->included_ranges, self->included_range_count,
+    self->arena
+  );
+}
+
+// If the tree has not been edited since it was parsed into an arena, and the
+// arena has no references to separately-allocated subtrees, then the subtrees
+// don't need to be visited when the tree is deleted: their memory is freed
+// along with the arena. Any remaining references to them from other trees
+// hold their own reference to the arena.
+static bool ts_tree__is_arena_only(const TSTree *self) {
+  return
+    self->arena &&
+    !self->arena->has_heap_references &&
+    !self->root.data.is_inline &&
+    self->root.ptr->is_arena;
+}
+
+static inline uint32_t ts_tree__hash_pointer(const void *pointer) {
+  return (uint32_t)(((uint64_t)(uintptr_t)pointer * 0x9e3779b97f4a7c15ull) >> 32);
+}
+
+static ParentCache *ts_tree__parent_cache_new(const TSTree *self) {
+  Array(ParentCacheEntry) entries = array_new();
+  array_push(&entries, ((ParentCacheEntry) {
+    .child = &self->root,
+    .position = ts_subtree_padding(self->root),
+    .alias_symbol = 0,
+    .structural_child_index = 0,
+    .parent_index = UINT32_MAX,
+  }));
+
+  // Visit the subtrees in breadth-first order, using the entries themselves
+  // as the queue.
+  for (uint32_t i = 0; i < entries.size; i++) {
+    ParentCacheEntry entry = entries.contents[i];
+    Subtree parent = *entry.child;
+    uint32_t child_count = ts_subtree_child_count(parent);
+    if (child_count == 0) continue;
+
+    const TSSymbol *alias_sequence = ts_language_alias_sequence(
+      self->language,
+      parent.ptr->production_id
+    );
+    Length position = entry.position;
+    uint32_t structural_child_index = 0;
+    for (uint32_t j = 0; j < child_count; j++) {
+      const Subtree *child = &ts_subtree_children(parent)[j];
+      if (j > 0) position = length_add(position, ts_subtree_padding(*child));
+      bool is_extra = ts_subtree_extra(*child);
+      TSSymbol alias_symbol = 0;
+      if (!is_extra && alias_sequence) {
+        alias_symbol = alias_sequence[structural_child_index];
+      }
+      array_push(&entries, ((ParentCacheEntry) {
+        .child = child,
+        .position = position,
+        .alias_symbol = alias_symbol,
+        .structural_child_index = structural_child_index,
+        .parent_index = i,
+      }));
+      if (!is_extra) structural_child_index++;
+      position = length_add(position, ts_subtree_size(*child));
+    }
+  }
+
+  // Keep the table at most half full, so that probe sequences stay short.
+  uint32_t slot_count = 1;
+  while (slot_count < entries.size * 2) slot_count *= 2;
+
+  ParentCache *result = ts_malloc(sizeof(ParentCache));
+  result->entries = ts_realloc(entries.contents, entries.size * sizeof(ParentCacheEntry));
+  result->slots = ts_calloc(slot_count, sizeof(uint32_t));
+  result->slot_mask = slot_count - 1;
+  for (uint32_t i = 0; i < entries.size; i++) {
+    uint32_t slot = ts_tree__hash_pointer(result->entries[i].child) & result->slot_mask;
+    while (result->slots[slot]) slot = (slot + 1) & result->slot_mask;
+    result->slots[slot] = i + 1;
+  }
+  return result;
+}
+
+static void ts_tree__parent_cache_delete(ParentCache *self) {
+  if (!self) return;
+  ts_free(self->entries);
+  ts_free(self->slots);
+  ts_free(self);
+}
+
+void ts_tree_index_parents(const TSTree *self) {
+  // The cache is added to a tree that is otherwise immutable, and which other
+  // threads may be reading. If multiple threads build it at once, only one of
+  // the caches is kept.
+  TSTree *tree = (TSTree *)self;
+  if (atomic_load_ptr((void *const volatile *)&tree->parent_cache)) return;
+  ParentCache *cache = ts_tree__parent_cache_new(self);
+  if (!atomic_compare_exchange_ptr((void *volatile *)&tree->parent_cache, NULL, cache)) {
+    ts_tree__parent_cache_delete(cache);
+  }
+}
+
+const ParentCacheEntry *ts_tree_parent_cache_entry(const TSTree *self, const Subtree *child) {
+  ParentCache *cache = atomic_load_ptr((void *const volatile *)&self->parent_cache);
+  if (!cache) return NULL;
+
+  uint32_t slot = ts_tree__hash_pointer(child) & cache->slot_mask;
+  while (cache->slots[slot]) {
+    const ParentCacheEntry *entry = &cache->entries[cache->slots[slot] - 1];
+    if (entry->child == child) return entry;
+    slot = (slot + 1) & cache->slot_mask;
+  }
+  return NULL;
+}
+
+static inline uint32_t ts_tree__child_index_bucket(const SubtreeHeapData *subtree) {
+  return ts_tree__hash_pointer(subtree) % CHILD_INDEX_BUCKET_COUNT;
+}
+
+const ChildIndex *ts_tree_child_index(const TSTree *self, Subtree subtree) {
+  ChildIndexTable *table = atomic_load_ptr((void *const volatile *)&self->child_indices);
+  if (!table) return NULL;
+  ChildIndex *const volatile *bucket = &table->buckets[ts_tree__child_index_bucket(subtree.ptr)];
+  ChildIndex *index = atomic_load_ptr((void *const volatile *)bucket);
+  while (index && index->subtree != subtree.ptr) index = index->next;
+  return index;
+}
+
+// Child indices are added lazily, to a tree that other threads may be
+// reading, so like the parent cache, the table is updated with atomic
+// operations. If two threads index the same node at once, both indices are
+// kept, and either may be used.
+const ChildIndex *ts_tree_add_child_index(const TSTree *self, ChildIndex *index) {
+  TSTree *tree = (TSTree *)self;
+  ChildIndexTable *table = atomic_load_ptr((void *const volatile *)&tree->child_indices);
+  if (!table) {
+    table = ts_calloc(1, sizeof(ChildIndexTable));
+    if (!atomic_compare_exchange_ptr((void *volatile *)&tree->child_indices, NULL, table)) {
+      ts_free(table);
+      table = atomic_load_ptr((void *const volatile *)&tree->child_indices);
+    }
+  }
+
+  ChildIndex *volatile *bucket = &table->buckets[ts_tree__child_index_bucket(index->subtree)];
+  do {
+    index->next = atomic_load_ptr((void *const volatile *)bucket);
+  } while (!atomic_compare_exchange_ptr((void *volatile *)bucket, index->next, index));
+  return index;
+}
+
+static void ts_tree__child_indices_delete(ChildIndexTable *self) {
+  if (!self) return;
+  for (unsigned i = 0; i < CHILD_INDEX_BUCKET_COUNT; i++) {
+    ChildIndex *index = self->buckets[i];
+    while (index) {
+      ChildIndex *next = index->next;
+      ts_free(index);
+      index = next;
+    }
+  }
+  ts_free(self);
+}
+
+void ts_tree_clear_caches(TSTree *self) {
+  ts_tree__parent_cache_delete(self->parent_cache);
+  ts_tree__child_indices_delete(self->child_indices);
+  self->parent_cache = NULL;
+  self->child_indices = NULL;
 }
 
 void ts_tree_delete(TSTree *self) {
   if (!self) return;
+  if (ts_tree__is_arena_only(self)) {
+    ts_subtree_arena_release(self->arena);
+  } else {
+    SubtreePool pool = ts_subtree_pool_new(0);
+    ts_subtree_release(&pool, self->root);
+    ts_subtree_pool_delete(&pool);
+    ts_subtree_arena_release(self->arena);
+  }
+  ts_tree__parent_cache_delete(self->parent_cache);
+  ts_tree__child_indices_delete(self->child_indices);
+  ts_free(self->included_ranges);
+  ts_free(self);
+}
 
-  SubtreePool pool = ts_subtree_pool_new(0);
-  ts_subtree_release(&pool, self->root);
-  ts_subtree_pool_delete(&pool);
+void ts_tree_delete_deferred(TSTree *self) {
+  if (!self) return;
+
+  // Releasing an arena only frees its slabs, which is cheap enough to do
+  // right away.
+  if (ts_tree__is_arena_only(self)) {
+    ts_subtree_arena_release(self->arena);
+  } else {
+    ts_reclaim_subtree_deferred(self->root, self->arena);
+  }
+  ts_tree__parent_cache_delete(self->parent_cache);
+  ts_tree__child_indices_delete(self->child_indices);
   ts_free(self->included_ranges);
   ts_free(self);
 }
@@ -52,6 +251,8 @@ const TSLanguage *ts_tree_language(const TSTree *self) {
 }
 
 void ts_tree_edit(TSTree *self, const TSInputEdit *edit) {
+  ts_tree_clear_caches(self);
+
   for (unsigned i = 0; i < self->included_range_count; i++) {
     TSRange *range = &self->included_ranges[i];
     if (range->end_byte >= edit->old_end_byte) {
@@ -123,6 +324,198 @@ TSRange *ts_tree_get_changed_ranges(const TSTree *old_tree, const TSTree *new_tr
   return result;
 }
 
+// Serialization
+
+static const uint8_t SERIALIZATION_MAGIC[4] = {'T', 'S', 'T', 'R'};
+static const uint32_t SERIALIZATION_FORMAT_VERSION = 1;
+
+static inline uint32_t ts_tree__hash_bytes(uint32_t hash, const void *data, size_t length) {
+  const uint8_t *bytes = data;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static inline uint32_t ts_tree__hash_string(uint32_t hash, const char *string) {
+  return ts_tree__hash_bytes(hash, string, string ? strlen(string) + 1 : 0);
+}
+
+// Compute a fingerprint of the parts of a language that a serialized tree
+// depends on, so that a tree is never deserialized using a language whose
+// symbols, states or productions may not match the ones it was parsed with.
+static uint32_t ts_tree__language_fingerprint(const TSLanguage *language) {
+  uint32_t counts[] = {
+    language->version,
+    language->symbol_count,
+    language->alias_count,
+    language->token_count,
+    language->external_token_count,
+    language->state_count,
+    language->production_id_count,
+    language->field_count,
+  };
+  uint32_t hash = ts_tree__hash_bytes(2166136261u, counts, sizeof(counts));
+  for (uint32_t i = 0, n = ts_language_symbol_count(language); i < n; i++) {
+    hash = ts_tree__hash_string(hash, ts_language_symbol_name(language, i));
+  }
+  for (uint32_t i = 1, n = ts_language_field_count(language); i <= n; i++) {
+    hash = ts_tree__hash_string(hash, ts_language_field_name_for_id(language, i));
+  }
+  return hash;
+}
+
+char *ts_tree_serialize(const TSTree *self, uint32_t *length) {
+  ByteArray buffer = array_new();
+  array_extend(&buffer, sizeof(SERIALIZATION_MAGIC), SERIALIZATION_MAGIC);
+  byte_array_push_uint(&buffer, SERIALIZATION_FORMAT_VERSION);
+  byte_array_push_uint(&buffer, ts_tree__language_fingerprint(self->language));
+  byte_array_push_uint(&buffer, self->included_range_count);
+  for (unsigned i = 0; i < self->included_range_count; i++) {
+    const TSRange *range = &self->included_ranges[i];
+    byte_array_push_uint(&buffer, range->start_point.row);
+    byte_array_push_uint(&buffer, range->start_point.column);
+    byte_array_push_uint(&buffer, range->end_point.row);
+    byte_array_push_uint(&buffer, range->end_point.column);
+    byte_array_push_uint(&buffer, range->start_byte);
+    byte_array_push_uint(&buffer, range->end_byte);
+  }
+
+  // The number of subtree records isn't known until they have all been
+  // written, so space is reserved for it here.
+  uint32_t record_count_offset = buffer.size;
+  array_grow_by(&buffer, 4);
+  uint32_t record_count = ts_subtree_serialize(self->root, &buffer);
+  byte_array_set_uint32(&buffer, record_count_offset, record_count);
+  *length = buffer.size;
+  return (char *)buffer.contents;
+}
+
+TSTree *ts_tree_deserialize(const TSLanguage *language, const char *data, uint32_t length) {
+  ByteReader reader = {
+    .position = (const uint8_t *)data,
+    .end = (const uint8_t *)data + length,
+    .failed = false,
+  };
+  const uint8_t *magic = byte_reader_read_bytes(&reader, sizeof(SERIALIZATION_MAGIC));
+  if (!magic || memcmp(magic, SERIALIZATION_MAGIC, sizeof(SERIALIZATION_MAGIC)) != 0) return NULL;
+  if (byte_reader_read_uint(&reader) != SERIALIZATION_FORMAT_VERSION) return NULL;
+  if (byte_reader_read_uint(&reader) != ts_tree__language_fingerprint(language)) return NULL;
+
+  // Each range takes at least six bytes, which bounds the allocation below
+  // even if the data is corrupt.
+  uint32_t range_count = byte_reader_read_uint(&reader);
+  if (reader.failed || range_count > (size_t)(reader.end - reader.position) / 6) return NULL;
+  TSRange *ranges = ts_calloc(range_count, sizeof(TSRange));
+  for (uint32_t i = 0; i < range_count; i++) {
+    TSRange *range = &ranges[i];
+    range->start_point.row = byte_reader_read_uint(&reader);
+    range->start_point.column = byte_reader_read_uint(&reader);
+    range->end_point.row = byte_reader_read_uint(&reader);
+    range->end_point.column = byte_reader_read_uint(&reader);
+    range->start_byte = byte_reader_read_uint(&reader);
+    range->end_byte = byte_reader_read_uint(&reader);
+  }
+
+  // The nodes are read directly from the given data, and are all allocated
+  // from a single arena, so that the tree can be deleted without visiting
+  // every node.
+  TSTree *result = NULL;
+  uint32_t record_count = byte_reader_read_uint32(&reader);
+  SubtreeArena *arena = ts_subtree_arena_new();
+  Subtree root = ts_subtree_deserialize(&reader, record_count, arena, language);
+  if (!reader.failed && reader.position == reader.end) {
+    result = ts_tree_new(root, language, ranges, range_count, arena);
+  }
+  ts_subtree_arena_release(arena);
+  ts_free(ranges);
+  return result;
+}
+
+typedef struct {
+  uint32_t index;
+  uint32_t last_child;
+  uint32_t cursor_depth;
+} ExportAncestor;
+
+bool ts_tree_export(const TSTree *self, TSTreeExportOptions options, TSFlatTree *output) {
+  const uint32_t none = UINT32_MAX;
+  uint32_t capacity = output->capacity;
+  uint32_t count = 0;
+  uint32_t cursor_depth = 0;
+
+  // The exported ancestors of the current node, each with the index of its
+  // last exported child, so that the sibling links can be filled in.
+  Array(ExportAncestor) ancestors = array_new();
+  TSTreeCursor cursor = ts_tree_cursor_new(ts_tree_root_node(self));
+  for (;;) {
+    while (ancestors.size > 0 && array_back(&ancestors)->cursor_depth >= cursor_depth) {
+      ancestors.size--;
+    }
+
+    TSNode node = ts_tree_cursor_current_node(&cursor);
+    bool is_named = ts_node_is_named(node);
+    bool descend = true;
+    if (!options.named_only || is_named || cursor_depth == 0) {
+      if (options.max_depth > 0 && ancestors.size > options.max_depth) {
+        descend = false;
+      } else {
+        uint32_t index = count++;
+        uint32_t parent = none;
+        if (ancestors.size > 0) {
+          ExportAncestor *ancestor = array_back(&ancestors);
+          parent = ancestor->index;
+          uint32_t previous = ancestor->last_child;
+          if (previous == none) {
+            if (output->first_children && parent < capacity) {
+              output->first_children[parent] = index;
+            }
+          } else if (output->next_siblings && previous < capacity) {
+            output->next_siblings[previous] = index;
+          }
+          ancestor->last_child = index;
+        }
+        array_push(&ancestors, ((ExportAncestor) {index, none, cursor_depth}));
+
+        if (index < capacity) {
+          if (output->symbols) output->symbols[index] = ts_node_symbol(node);
+          if (output->start_bytes) output->start_bytes[index] = ts_node_start_byte(node);
+          if (output->end_bytes) output->end_bytes[index] = ts_node_end_byte(node);
+          if (output->start_points) output->start_points[index] = ts_node_start_point(node);
+          if (output->end_points) output->end_points[index] = ts_node_end_point(node);
+          if (output->parents) output->parents[index] = parent;
+          if (output->first_children) output->first_children[index] = none;
+          if (output->next_siblings) output->next_siblings[index] = none;
+          if (output->field_ids) output->field_ids[index] = ts_tree_cursor_current_field_id(&cursor);
+          if (output->flags) {
+            output->flags[index] =
+              (is_named ? TSFlatNodeFlagNamed : 0) |
+              (ts_node_is_extra(node) ? TSFlatNodeFlagExtra : 0) |
+              (ts_node_is_missing(node) ? TSFlatNodeFlagMissing : 0) |
+              (ts_node_has_error(node) ? TSFlatNodeFlagHasError : 0);
+          }
+        }
+      }
+    }
+
+    if (descend && ts_tree_cursor_goto_first_child(&cursor)) {
+      cursor_depth++;
+      continue;
+    }
+    while (!ts_tree_cursor_goto_next_sibling(&cursor)) {
+      if (!ts_tree_cursor_goto_parent(&cursor)) goto done;
+      cursor_depth--;
+    }
+  }
+
+done:
+  ts_tree_cursor_delete(&cursor);
+  array_delete(&ancestors);
+  output->node_count = count;
+  return count <= capacity;
+}
+
 #ifdef _WIN32
 
 void ts_tree_print_dot_graph(const TSTree *self, int fd) {
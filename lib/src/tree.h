@@ -7,22 +7,66 @@
 extern "C" {
 #endif
 
+// The location of a subtree within a tree: the position and alias that a
+// node for the subtree would have, and the cache entry for its parent.
 typedef struct {
   const Subtree *child;
-  const Subtree *parent;
   Length position;
   TSSymbol alias_symbol;
+  uint32_t structural_child_index;
+  uint32_t parent_index;
 } ParentCacheEntry;
 
+// An index from every subtree in a tree to its parent. The entries are
+// stored in breadth-first order, so that siblings are adjacent, and are
+// located via an open-addressing hash table of entry indices, keyed by the
+// address of the child subtree.
+typedef struct {
+  ParentCacheEntry *entries;
+  uint32_t *slots;
+  uint32_t slot_mask;
+} ParentCache;
+
+// An index of the children of a node with many children, so that a child can
+// be found by its index or position without visiting the preceding children.
+// Offsets are relative to the start of the node, and give the end of the
+// previous child, which is where a `NodeChildIterator` would be positioned
+// before advancing to each child. The final entry gives the totals.
+typedef struct {
+  Length offset;
+  uint32_t visible_count;
+  uint32_t named_count;
+  uint32_t structural_child_index;
+} ChildIndexEntry;
+
+typedef struct ChildIndex {
+  const SubtreeHeapData *subtree;
+  struct ChildIndex *next;
+  ChildIndexEntry *entries;
+} ChildIndex;
+
+#define CHILD_INDEX_BUCKET_COUNT 64
+
+typedef struct {
+  ChildIndex *volatile buckets[CHILD_INDEX_BUCKET_COUNT];
+} ChildIndexTable;
+
 struct TSTree {
   Subtree root;
   const TSLanguage *language;
   TSRange *included_ranges;
   unsigned included_range_count;
+  SubtreeArena *arena;
+  ParentCache *volatile parent_cache;
+  ChildIndexTable *volatile child_indices;
 };
 
-TSTree *ts_tree_new(Subtree root, const TSLanguage *language, const TSRange *, unsigned);
+TSTree *ts_tree_new(Subtree root, const TSLanguage *language, const TSRange *, unsigned, SubtreeArena *);
 TSNode ts_node_new(const TSTree *, const Subtree *, Length, TSSymbol);
+const ParentCacheEntry *ts_tree_parent_cache_entry(const TSTree *, const Subtree *);
+const ChildIndex *ts_tree_child_index(const TSTree *, Subtree);
+const ChildIndex *ts_tree_add_child_index(const TSTree *, ChildIndex *);
+void ts_tree_clear_caches(TSTree *);
 
 #ifdef __cplusplus
 }
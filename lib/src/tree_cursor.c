@@ -411,6 +411,87 @@ bool ts_tree_cursor_goto_parent(TSTreeCursor *_self) {
   return false;
 }
 
+static inline bool ts_tree_cursor__entry_matches(
+  const TreeCursor *self,
+  const TreeCursorEntry *entry,
+  const TSSymbol *symbols,
+  uint32_t symbol_count,
+  uint64_t symbol_summary,
+  uint32_t flags
+) {
+  Subtree subtree = *entry->subtree;
+  TSSymbol symbol = ts_subtree_symbol(subtree);
+  bool named = ts_subtree_named(subtree);
+  if (!ts_subtree_extra(subtree)) {
+    const TreeCursorEntry *parent_entry = entry - 1;
+    TSSymbol alias_symbol = ts_language_alias_at(
+      self->tree->language,
+      parent_entry->subtree->ptr->production_id,
+      entry->structural_child_index
+    );
+    if (alias_symbol) {
+      symbol = alias_symbol;
+      named = ts_language_symbol_metadata(self->tree->language, alias_symbol).named;
+    }
+  }
+
+  if ((flags & TSTreeCursorMatchNamed) && !named) return false;
+  if (symbol_count == 0) return true;
+  symbol = ts_language_public_symbol(self->tree->language, symbol);
+  if (!(ts_subtree_symbol_summary_bit(symbol) & symbol_summary)) return false;
+  for (uint32_t i = 0; i < symbol_count; i++) {
+    if (symbols[i] == symbol) return true;
+  }
+  return false;
+}
+
+bool ts_tree_cursor_next_matching(
+  TSTreeCursor *_self,
+  const TSSymbol *symbols,
+  uint32_t symbol_count,
+  uint32_t flags
+) {
+  TreeCursor *self = (TreeCursor *)_self;
+
+  // Subtrees whose summaries don't include any of the symbols are skipped.
+  uint64_t symbol_summary = symbol_count == 0 ? UINT64_MAX : 0;
+  for (uint32_t i = 0; i < symbol_count; i++) {
+    symbol_summary |= ts_subtree_symbol_summary_bit(symbols[i]);
+  }
+
+  bool descend = !(flags & TSTreeCursorMatchSkipChildren);
+  for (;;) {
+    bool visible;
+    TreeCursorEntry entry;
+    bool did_advance = false;
+    Subtree subtree = ts_tree_cursor_current_subtree(_self);
+    if (descend && (ts_subtree_symbol_summary(subtree) & symbol_summary)) {
+      CursorChildIterator iterator = ts_tree_cursor_iterate_children(self);
+      did_advance = ts_tree_cursor_child_iterator_next(&iterator, &entry, &visible);
+    }
+
+    // Once a subtree has been searched, move on to the next sibling of it or
+    // of its nearest ancestor that has one.
+    while (!did_advance) {
+      if (self->stack.size == 1) return false;
+      TreeCursorEntry previous_entry = array_pop(&self->stack);
+      CursorChildIterator iterator = ts_tree_cursor_iterate_children(self);
+      iterator.child_index = previous_entry.child_index;
+      iterator.structural_child_index = previous_entry.structural_child_index;
+      iterator.position = previous_entry.position;
+      iterator.descendant_index = previous_entry.descendant_index;
+      ts_tree_cursor_child_iterator_next(&iterator, &entry, &visible);
+      did_advance = ts_tree_cursor_child_iterator_next(&iterator, &entry, &visible);
+    }
+
+    array_push(&self->stack, entry);
+    if (visible && ts_tree_cursor__entry_matches(
+      self, array_back(&self->stack), symbols, symbol_count, symbol_summary, flags
+    )) return true;
+    descend = true;
+  }
+}
+
 void ts_tree_cursor_goto_descendant(
   TSTreeCursor *_self,
   uint32_t goal_descendant_index